@@ -0,0 +1,67 @@
+#include <fmt/core.h>
+
+#include <assembler/assembler.hpp>
+#include <common/mapped_file.hpp>
+#include <cpu/pc_profiler.hpp>
+#include <cpu/simulator.hpp>
+#include <cpu/timing_config.hpp>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+namespace {
+void printUsage() {
+  fmt::print( stderr, "Usage : annotate [--timing FILE] [--line-table FILE] "
+                      "<program.s>\n" );
+}
+}  // namespace
+
+// Runs a program and prints its source with the instructions, cycles and
+// cache hits and misses spent on every line. --line-table also writes the
+// address to line mapping of the assembled program.
+int main( int argc, char** argv ) {
+  cpu::TimingConfig timing_config;
+  std::string line_table_filename;
+  std::string program_filename;
+  try {
+    for ( auto i = 1; i < argc; i++ ) {
+      std::string_view arg = argv[i];
+      bool has_value = i + 1 < argc;
+      if ( arg == "--timing" && has_value ) {
+        timing_config = cpu::TimingConfig::fromFile( argv[++i] );
+      } else if ( arg == "--line-table" && has_value ) {
+        line_table_filename = argv[++i];
+      } else if ( !arg.starts_with( "--" ) && program_filename.empty() ) {
+        program_filename = arg;
+      } else {
+        printUsage();
+        return EXIT_FAILURE;
+      }
+    }
+    if ( program_filename.empty() ) {
+      printUsage();
+      return EXIT_FAILURE;
+    }
+
+    assembler::turbo_asm engine( program_filename );
+    assembler::LineTable line_table = engine.getLineTable();
+    if ( !line_table_filename.empty() ) {
+      engine.dumpLineTable( line_table_filename );
+    }
+
+    cpu::CPU program_cpu( 1024, 512, 8, memory::CacheWritePolicy::WRITEBACK,
+                          memory::CacheReplacementPolicy::FIFO,
+                          timing_config );
+    cpu::PcProfiler profiler( line_table.size() );
+    program_cpu.runProgram( engine.dumpBinary(), { &profiler } );
+
+    common::MappedFile source( program_filename );
+    profiler.annotate( std::cout, source.view(), line_table );
+  } catch ( const std::exception& e ) {
+    fmt::print( stderr, "annotate : {}\n", e.what() );
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,79 @@
+#include <fmt/core.h>
+
+#include <assembler/assembler.hpp>
+#include <cpu/batch_runner.hpp>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+void printUsage() {
+  fmt::print( stderr,
+              "Usage : batch_runner [--json] [--threads N] [--output FILE] "
+              "<sweep file> <program.s>...\n" );
+}
+}  // namespace
+
+// Runs every program on every point of the sweep file and writes one CSV
+// ( or JSON ) row per run
+int main( int argc, char** argv ) {
+  cpu::ResultWriter::Format format = cpu::ResultWriter::Format::CSV;
+  std::int32_t num_threads = 0;
+  std::string output_filename;
+  std::vector<std::string> positional;
+  for ( auto i = 1; i < argc; i++ ) {
+    std::string arg = argv[i];
+    if ( arg == "--json" ) {
+      format = cpu::ResultWriter::Format::JSON;
+    } else if ( arg == "--threads" && i + 1 < argc ) {
+      num_threads = std::atoi( argv[++i] );
+    } else if ( arg == "--output" && i + 1 < argc ) {
+      output_filename = argv[++i];
+    } else if ( arg == "--help" ) {
+      printUsage();
+      return 0;
+    } else {
+      positional.push_back( arg );
+    }
+  }
+  if ( positional.size() < 2 ) {
+    printUsage();
+    return 1;
+  }
+
+  try {
+    cpu::SweepSpace space = cpu::SweepSpace::fromFile( positional[0] );
+
+    std::vector<cpu::BatchProgram> programs;
+    for ( std::size_t i = 1; i < positional.size(); i++ ) {
+      assembler::turbo_asm engine( positional[i] );
+      programs.push_back( { positional[i], engine.dumpBinary() } );
+    }
+
+    std::ofstream output_file;
+    if ( !output_filename.empty() ) {
+      output_file.open( output_filename );
+      if ( !output_file ) {
+        throw std::runtime_error( "Unable to open " + output_filename );
+      }
+    }
+    cpu::ResultWriter writer(
+        output_filename.empty() ? std::cout : output_file, format );
+    writer.writeHeader();
+
+    cpu::BatchRunner runner( num_threads );
+    std::size_t num_failed = runner.run( programs, space.getPoints(), writer );
+    if ( num_failed != 0 ) {
+      fmt::print( stderr, "{} run(s) failed\n", num_failed );
+      return 2;
+    }
+  } catch ( const std::exception& e ) {
+    fmt::print( stderr, "batch_runner : {}\n", e.what() );
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,108 @@
+#include <fmt/core.h>
+
+#include <chrono>
+#include <cpu/trace_cache_sim.hpp>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <memory/common_enums.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+void printUsage() {
+  fmt::print( stderr,
+              "Usage : cache_sim [--threads N] <trace> <config>...\n"
+              "  trace  : Dinero din text or a binary execution trace\n"
+              "  config : size:block[:FIFO|RANDOM|LRU"
+              "[:WRITEBACK|WRITETHROUGH]]\n" );
+}
+
+cpu::TraceCacheConfig parseConfig( std::string_view text ) {
+  std::vector<std::string> fields;
+  std::size_t start = 0;
+  while ( true ) {
+    std::size_t end = text.find( ':', start );
+    fields.emplace_back( text.substr( start, end - start ) );
+    if ( end == std::string_view::npos ) {
+      break;
+    }
+    start = end + 1;
+  }
+  if ( fields.size() < 2 || fields.size() > 4 ) {
+    throw std::invalid_argument( "Invalid cache config : " +
+                                 std::string( text ) );
+  }
+  cpu::TraceCacheConfig config;
+  config.cache_size = std::stoi( fields[0] );
+  config.block_size = std::stoi( fields[1] );
+  if ( fields.size() > 2 ) {
+    config.replacement_policy = memory::parseReplacementPolicy( fields[2] );
+  }
+  if ( fields.size() > 3 ) {
+    config.write_policy = memory::parseWritePolicy( fields[3] );
+  }
+  config.validate();
+  return config;
+}
+}  // namespace
+
+// Simulates caches over a memory reference trace, one CSV row per config
+int main( int argc, char** argv ) {
+  std::int32_t num_threads = 0;
+  std::string trace_filename;
+  std::vector<cpu::TraceCacheConfig> configs;
+  try {
+    for ( auto i = 1; i < argc; i++ ) {
+      std::string_view arg = argv[i];
+      if ( arg == "--threads" && i + 1 < argc ) {
+        num_threads = std::stoi( argv[++i] );
+      } else if ( arg.starts_with( "--" ) ) {
+        printUsage();
+        return EXIT_FAILURE;
+      } else if ( trace_filename.empty() ) {
+        trace_filename = arg;
+      } else {
+        configs.push_back( parseConfig( arg ) );
+      }
+    }
+    if ( configs.empty() ) {
+      printUsage();
+      return EXIT_FAILURE;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<cpu::TraceCacheStats> results =
+        cpu::TraceCacheSimulator::run( trace_filename, configs, num_threads );
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    fmt::print(
+        "cache_size,block_size,replacement_policy,write_policy,reads,writes,"
+        "fetches,read_misses,write_misses,fetch_misses,miss_rate,evictions,"
+        "writebacks,memory_reads,memory_writes\n" );
+    std::int64_t references = 0;
+    for ( std::size_t i = 0; i < configs.size(); i++ ) {
+      const cpu::TraceCacheConfig& config = configs[i];
+      const cpu::TraceCacheStats& stats = results[i];
+      fmt::print( "{},{},{},{},{},{},{},{},{},{},{:.6f},{},{},{},{}\n",
+                  config.cache_size, config.block_size,
+                  memory::toString( config.replacement_policy ),
+                  memory::toString( config.write_policy ),
+                  stats.accesses[memory::READ], stats.accesses[memory::WRITE],
+                  stats.accesses[memory::FETCH], stats.misses[memory::READ],
+                  stats.misses[memory::WRITE], stats.misses[memory::FETCH],
+                  stats.getMissRate(), stats.evictions, stats.writebacks,
+                  stats.memory_reads, stats.memory_writes );
+      references += stats.getAccesses();
+    }
+    fmt::print( stderr, "{} references in {:.3f} s ( {:.1f} M / s )\n",
+                references, elapsed.count(),
+                references / elapsed.count() / 1e6 );
+  } catch ( const std::exception& e ) {
+    fmt::print( stderr, "cache_sim : {}\n", e.what() );
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
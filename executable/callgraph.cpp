@@ -0,0 +1,69 @@
+#include <fmt/core.h>
+
+#include <assembler/assembler.hpp>
+#include <cpu/call_graph_profiler.hpp>
+#include <cpu/simulator.hpp>
+#include <cpu/timing_config.hpp>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+namespace {
+void printUsage() {
+  fmt::print( stderr, "Usage : callgraph [--timing FILE] [--folded FILE] "
+                      "[--misses] <program.s>\n" );
+}
+}  // namespace
+
+// Runs a program and prints the inclusive and exclusive cycles and cache
+// misses of every function. --folded also writes the stacks in the folded
+// format of flame graph tools, weighted by cycles or, with --misses, by
+// cache misses.
+int main( int argc, char** argv ) {
+  cpu::TimingConfig timing_config;
+  std::string folded_filename;
+  cpu::CallGraphProfiler::Metric metric = cpu::CallGraphProfiler::CYCLES;
+  std::string program_filename;
+  try {
+    for ( auto i = 1; i < argc; i++ ) {
+      std::string_view arg = argv[i];
+      bool has_value = i + 1 < argc;
+      if ( arg == "--timing" && has_value ) {
+        timing_config = cpu::TimingConfig::fromFile( argv[++i] );
+      } else if ( arg == "--folded" && has_value ) {
+        folded_filename = argv[++i];
+      } else if ( arg == "--misses" ) {
+        metric = cpu::CallGraphProfiler::MISSES;
+      } else if ( !arg.starts_with( "--" ) && program_filename.empty() ) {
+        program_filename = arg;
+      } else {
+        printUsage();
+        return EXIT_FAILURE;
+      }
+    }
+    if ( program_filename.empty() ) {
+      printUsage();
+      return EXIT_FAILURE;
+    }
+
+    assembler::turbo_asm engine( program_filename );
+    cpu::CPU program_cpu( 1024, 512, 8, memory::CacheWritePolicy::WRITEBACK,
+                          memory::CacheReplacementPolicy::FIFO,
+                          timing_config );
+    cpu::CallGraphProfiler profiler( engine.getSymbols() );
+    program_cpu.runProgram( engine.dumpBinary(), { &profiler } );
+
+    profiler.writeReport( std::cout );
+    if ( !folded_filename.empty() ) {
+      std::ofstream folded( folded_filename );
+      profiler.writeFolded( folded, metric );
+    }
+  } catch ( const std::exception& e ) {
+    fmt::print( stderr, "callgraph : {}\n", e.what() );
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
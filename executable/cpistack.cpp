@@ -0,0 +1,54 @@
+#include <fmt/core.h>
+
+#include <assembler/assembler.hpp>
+#include <cpu/cpi_stack.hpp>
+#include <cpu/simulator.hpp>
+#include <cpu/timing_config.hpp>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+namespace {
+void printUsage() {
+  fmt::print( stderr, "Usage : cpistack [--timing FILE] <program.s>\n" );
+}
+}  // namespace
+
+// Runs a program and prints how its CPI splits into causes, for the whole
+// run and for the code from every label to the next
+int main( int argc, char** argv ) {
+  cpu::TimingConfig timing_config;
+  std::string program_filename;
+  try {
+    for ( auto i = 1; i < argc; i++ ) {
+      std::string_view arg = argv[i];
+      if ( arg == "--timing" && i + 1 < argc ) {
+        timing_config = cpu::TimingConfig::fromFile( argv[++i] );
+      } else if ( !arg.starts_with( "--" ) && program_filename.empty() ) {
+        program_filename = arg;
+      } else {
+        printUsage();
+        return EXIT_FAILURE;
+      }
+    }
+    if ( program_filename.empty() ) {
+      printUsage();
+      return EXIT_FAILURE;
+    }
+
+    assembler::turbo_asm engine( program_filename );
+    cpu::CPU program_cpu( 1024, 512, 8, memory::CacheWritePolicy::WRITEBACK,
+                          memory::CacheReplacementPolicy::FIFO,
+                          timing_config );
+    cpu::CpiStackProfiler profiler = cpu::CpiStackProfiler::fromSymbols(
+        engine.getSymbols(), engine.getLineTable().size() * 4 );
+    program_cpu.runProgram( engine.dumpBinary(), { &profiler } );
+    profiler.write( std::cout );
+  } catch ( const std::exception& e ) {
+    fmt::print( stderr, "cpistack : {}\n", e.what() );
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
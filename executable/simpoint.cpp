@@ -0,0 +1,129 @@
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <assembler/assembler.hpp>
+#include <cpu/bbv_profiler.hpp>
+#include <cpu/simpoint.hpp>
+#include <cpu/simulator.hpp>
+#include <cpu/timing_config.hpp>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+void printUsage() {
+  fmt::print( stderr,
+              "Usage : simpoint [--interval N] [--max-k K] [--seed S] "
+              "[--timing FILE] [--write-bbv FILE] [--checkpoints DIR] "
+              "<program.s>\n"
+              "        simpoint --bbv FILE [--max-k K] [--seed S]\n" );
+}
+
+void printPoints( const std::vector<cpu::SimulationPoint>& points ) {
+  fmt::print( "interval,weight\n" );
+  for ( auto& point : points ) {
+    fmt::print( "{},{:.6f}\n", point.interval, point.weight );
+  }
+}
+}  // namespace
+
+// Profiles basic block vectors of a program ( or reads them from a .bb
+// file ), picks simulation points and, for a program, estimates its cycles
+// and miss rate from detailed runs of those points only
+int main( int argc, char** argv ) {
+  std::int64_t interval_length = 100;
+  cpu::SimPointConfig config;
+  cpu::TimingConfig timing_config;
+  std::string bbv_filename;
+  std::string write_bbv_filename;
+  std::string checkpoint_dir;
+  std::vector<std::string> positional;
+  try {
+    for ( auto i = 1; i < argc; i++ ) {
+      std::string arg = argv[i];
+      bool has_value = i + 1 < argc;
+      if ( arg == "--interval" && has_value ) {
+        interval_length = std::atoll( argv[++i] );
+      } else if ( arg == "--max-k" && has_value ) {
+        config.max_k = std::atoi( argv[++i] );
+      } else if ( arg == "--seed" && has_value ) {
+        config.seed = std::atoi( argv[++i] );
+      } else if ( arg == "--timing" && has_value ) {
+        timing_config = cpu::TimingConfig::fromFile( argv[++i] );
+      } else if ( arg == "--bbv" && has_value ) {
+        bbv_filename = argv[++i];
+      } else if ( arg == "--write-bbv" && has_value ) {
+        write_bbv_filename = argv[++i];
+      } else if ( arg == "--checkpoints" && has_value ) {
+        checkpoint_dir = argv[++i];
+      } else if ( arg == "--help" ) {
+        printUsage();
+        return 0;
+      } else {
+        positional.push_back( arg );
+      }
+    }
+    if ( bbv_filename.empty() == positional.empty() ) {
+      printUsage();
+      return 1;
+    }
+
+    if ( !bbv_filename.empty() ) {
+      std::ifstream bbv_file( bbv_filename );
+      if ( !bbv_file ) {
+        throw std::runtime_error( "Unable to open " + bbv_filename );
+      }
+      auto intervals = cpu::BbvProfiler::read( bbv_file );
+      std::int32_t num_blocks = 0;
+      for ( auto& interval : intervals ) {
+        for ( auto& [block, count] : interval.counts ) {
+          num_blocks = std::max( num_blocks, block + 1 );
+        }
+      }
+      printPoints( cpu::SimPoint::select( intervals, num_blocks, config ) );
+      return 0;
+    }
+
+    assembler::turbo_asm engine( positional[0] );
+    cpu::CPU program_cpu( 1024, 512, 8, memory::CacheWritePolicy::WRITEBACK,
+                          memory::CacheReplacementPolicy::FIFO,
+                          timing_config );
+    program_cpu.loadProgram( engine.dumpBinary() );
+
+    cpu::BbvProfiler profiler( interval_length );
+    cpu::CPU profiled_cpu = program_cpu.fork();
+    profiler.profile( profiled_cpu );
+    if ( !write_bbv_filename.empty() ) {
+      std::ofstream bbv_file( write_bbv_filename );
+      cpu::BbvProfiler::write( bbv_file, profiler.getIntervals() );
+    }
+    std::int64_t total_instructions = 0;
+    for ( auto& interval : profiler.getIntervals() ) {
+      total_instructions += interval.getTotal();
+    }
+
+    auto points = cpu::SimPoint::select( profiler.getIntervals(),
+                                         profiler.getNumBlocks(), config );
+    printPoints( points );
+    cpu::SimPointEstimate estimate;
+    if ( checkpoint_dir.empty() ) {
+      estimate = cpu::SimPoint::estimate( program_cpu.fork(), points,
+                                          interval_length, total_instructions );
+    } else {
+      cpu::SimPoint::writeCheckpoints( program_cpu.fork(), points,
+                                       interval_length, checkpoint_dir );
+      estimate = cpu::SimPoint::estimateFromCheckpoints(
+          points, interval_length, total_instructions, checkpoint_dir );
+    }
+    fmt::print( "\nInstructions : {}\n", estimate.instructions );
+    fmt::print( "Estimated CPI : {:.4f}\n", estimate.cpi );
+    fmt::print( "Estimated cycles : {:.0f}\n", estimate.cycles );
+    fmt::print( "Estimated miss rate : {:.4f}\n", estimate.miss_rate );
+  } catch ( const std::exception& e ) {
+    fmt::print( stderr, "simpoint : {}\n", e.what() );
+    return 1;
+  }
+  return 0;
+}
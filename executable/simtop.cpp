@@ -0,0 +1,91 @@
+#include <fmt/core.h>
+
+#include <chrono>
+#include <cpu/live_counters.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace {
+void printUsage() {
+  fmt::print( stderr, "Usage : simtop [--interval MS] [--once] "
+                      "<pid | counter file>\n" );
+}
+
+// Rate per second between two publishes, 0 if no time has passed
+double getRate( std::int64_t delta, std::int64_t delta_ns ) {
+  return delta_ns <= 0 ? 0 : delta * 1e9 / delta_ns;
+}
+}  // namespace
+
+// Follows the live counters of a running simulation, one line per
+// interval, until it finishes. A run that keeps publishing the same PC is
+// likely stuck in a loop, one that stops publishing is stalled or dead.
+int main( int argc, char** argv ) {
+  std::int64_t interval_ms = 1000;
+  bool once = false;
+  std::string path;
+  try {
+    for ( auto i = 1; i < argc; i++ ) {
+      std::string_view arg = argv[i];
+      if ( arg == "--interval" && i + 1 < argc ) {
+        interval_ms = std::stoll( argv[++i] );
+      } else if ( arg == "--once" ) {
+        once = true;
+      } else if ( !arg.starts_with( "--" ) && path.empty() ) {
+        path = arg;
+      } else {
+        printUsage();
+        return EXIT_FAILURE;
+      }
+    }
+    if ( path.empty() || interval_ms <= 0 ) {
+      printUsage();
+      return EXIT_FAILURE;
+    }
+    if ( path.find( '/' ) == std::string::npos ) {
+      path = cpu::LiveCounterPublisher::getDefaultPath( std::stoll( path ) );
+    }
+
+    cpu::LiveCounterReader reader( path );
+    fmt::print( "pid {} : {}\n", reader.getPid(), path );
+    fmt::print( "{:>14} {:>16} {:>8} {:>8} {:>10} {:>14}\n", "instructions",
+                "cycles", "ipc", "hit %", "pc", "instr / s" );
+
+    cpu::LiveCounters last = reader.read();
+    bool first = true;
+    while ( true ) {
+      cpu::LiveCounters now = reader.read();
+      std::int64_t accesses = now.cache_hits + now.cache_misses;
+      std::string status;
+      if ( now.finished ) {
+        status = "finished";
+      } else if ( !first && now.updates == last.updates ) {
+        status = "no progress";
+      }
+      fmt::print( "{:>14} {:>16} {:>8.4f} {:>8.2f} {:>#10x} {:>14.0f} {}\n",
+                  now.instructions, now.cycles,
+                  now.cycles == 0 ? 0 : now.instructions / double( now.cycles ),
+                  accesses == 0 ? 0 : 100.0 * now.cache_hits / accesses,
+                  now.pc,
+                  getRate( now.instructions - last.instructions,
+                           now.time_ns - last.time_ns ),
+                  status );
+      std::fflush( stdout );
+      if ( once || now.finished ) {
+        break;
+      }
+      last = now;
+      first = false;
+      std::this_thread::sleep_for( std::chrono::milliseconds( interval_ms ) );
+    }
+  } catch ( const std::exception& e ) {
+    fmt::print( stderr, "simtop : {}\n", e.what() );
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -1,22 +1,61 @@
 #include <fmt/core.h>
 
 #include <assembler/assembler.hpp>
+#include <cpu/live_counters.hpp>
 #include <cpu/simulator.hpp>
+#include <cpu/timing_config.hpp>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string_view>
 
 #include "memory/common_enums.hpp"
 
 std::string get_examples_dir() { return std::string( EXAMPLES ); }
 
-int main() {
+// Usage : test_program [--live] [--json | --csv] [timing config file]
+// --live publishes the counters for simtop while running, --json / --csv
+// print the statistics registry instead of the text dump
+int main( int argc, char** argv ) {
+  std::optional<common::StatsRegistry::Format> stats_format;
+  std::unique_ptr<cpu::LiveCounterPublisher> publisher;
+  int arg = 1;
+  if ( argc > arg && std::string_view( argv[arg] ) == "--live" ) {
+    publisher = std::make_unique<cpu::LiveCounterPublisher>();
+    fmt::print( stderr, "Publishing counters to {}\n", publisher->getPath() );
+    arg++;
+  }
+  if ( argc > arg && std::string_view( argv[arg] ) == "--json" ) {
+    stats_format = common::StatsRegistry::Format::JSON;
+    arg++;
+  } else if ( argc > arg && std::string_view( argv[arg] ) == "--csv" ) {
+    stats_format = common::StatsRegistry::Format::CSV;
+    arg++;
+  }
+
+  cpu::TimingConfig timing_config;
+  if ( argc > arg ) {
+    timing_config = cpu::TimingConfig::fromFile( argv[arg] );
+  }
+
   // Invoking assembler to convert the assembly file to binary file
   assembler::turbo_asm engine( get_examples_dir() + "sample9.s" );
   std::string binary = engine.dumpBinary();
 
   // Passing that dump to the cpu for execution
   cpu::CPU test_cpu( 1024, 512, 8, memory::CacheWritePolicy::WRITEBACK,
-                     memory::CacheReplacementPolicy::FIFO );
-  test_cpu.runProgram( binary );
-  test_cpu.getSystemState().dumpState();
+                     memory::CacheReplacementPolicy::FIFO, timing_config );
+  if ( publisher ) {
+    test_cpu.loadProgram( binary );
+    test_cpu.run( { publisher.get() } );
+  } else {
+    test_cpu.runProgram( binary );
+  }
+  if ( stats_format ) {
+    test_cpu.getSystemState().dumpStats( std::cout, *stats_format );
+  } else {
+    test_cpu.getSystemState().dumpState();
+  }
 
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include <fmt/core.h>
+
+#include <assembler/assembler.hpp>
+#include <cpu/simulator.hpp>
+#include <cpu/timing_config.hpp>
+#include <cpu/working_set.hpp>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+namespace {
+void printUsage() {
+  fmt::print( stderr,
+              "Usage : workingset [--timing FILE] [--interval N] "
+              "[--line-size B] [--rate R] [--max-lines N] <program.s>\n" );
+}
+}  // namespace
+
+// Runs a program and prints, per interval of instructions, the working set
+// of its loads and stores and the miss ratio of LRU caches of every power
+// of two lines as CSV
+int main( int argc, char** argv ) {
+  cpu::TimingConfig timing_config;
+  cpu::WorkingSetConfig config;
+  std::string program_filename;
+  try {
+    for ( auto i = 1; i < argc; i++ ) {
+      std::string_view arg = argv[i];
+      bool has_value = i + 1 < argc;
+      if ( arg == "--timing" && has_value ) {
+        timing_config = cpu::TimingConfig::fromFile( argv[++i] );
+      } else if ( arg == "--interval" && has_value ) {
+        config.interval_length = std::stoll( argv[++i] );
+      } else if ( arg == "--line-size" && has_value ) {
+        config.line_size = std::stoi( argv[++i] );
+      } else if ( arg == "--rate" && has_value ) {
+        config.sampling_rate = std::stod( argv[++i] );
+      } else if ( arg == "--max-lines" && has_value ) {
+        config.max_sampled_lines = std::stoi( argv[++i] );
+      } else if ( !arg.starts_with( "--" ) && program_filename.empty() ) {
+        program_filename = arg;
+      } else {
+        printUsage();
+        return EXIT_FAILURE;
+      }
+    }
+    if ( program_filename.empty() ) {
+      printUsage();
+      return EXIT_FAILURE;
+    }
+
+    assembler::turbo_asm engine( program_filename );
+    cpu::CPU program_cpu( 1024, 512, 8, memory::CacheWritePolicy::WRITEBACK,
+                          memory::CacheReplacementPolicy::FIFO,
+                          timing_config );
+    cpu::WorkingSetProfiler profiler( config );
+    program_cpu.runProgram( engine.dumpBinary(), { &profiler } );
+    profiler.writeCSV( std::cout );
+  } catch ( const std::exception& e ) {
+    fmt::print( stderr, "workingset : {}\n", e.what() );
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
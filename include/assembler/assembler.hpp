@@ -1,31 +1,88 @@
-#include <unistd.h>
+#pragma once
 
+#include <algorithm>
 #include <assembler/instruction.hpp>
+#include <assembler/line_table.hpp>
+#include <assembler/line_reader.hpp>
 #include <assembler/operand.hpp>
+#include <common/mapped_file.hpp>
+#include <common/thread_pool.hpp>
+#include <cstddef>
 #include <fstream>
-#include <range/v3/all.hpp>
-#include <sstream>
+#include <map>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
 namespace assembler {
 struct turbo_asm {
+  // Sources smaller than this per thread are assembled on the calling thread
+  static constexpr std::size_t min_chunk_size = 256 * 1024;
+
  private:
-  std::string m_file_contents;
+  using LabelMap = std::unordered_map<std::string_view, std::int32_t>;
+
+  // Line aligned piece of the source that is parsed independently. Label
+  // addresses and instruction addresses are relative to the chunk until the
+  // chunk base addresses have been computed.
+  struct Chunk {
+    std::string_view source;
+    std::vector<Instruction> instructions;
+    std::vector<std::int32_t> lines;  // Per instruction, chunk relative
+    LabelMap label_adr_map;
+    std::int32_t code_size = 0;
+    std::int32_t base_address = 0;
+    std::size_t first_instruction = 0;
+    std::int32_t num_lines = 0;
+    std::int32_t first_line = 0;
+  };
+
+  // Instructions and labels view into the mapped source
+  common::MappedFile m_source;
   std::vector<Instruction> m_instructions;
-  std::unordered_map<std::string, std::int32_t> m_label_adr_map;
+  std::vector<std::int32_t> m_instruction_lines;  // Source line, 1 based
+  LabelMap m_label_adr_map;
+  std::int32_t m_num_threads;
 
  public:
-  turbo_asm( const std::string& filename )
-      : m_file_contents( readFile( filename ) ) {
-    auto raw_instructions = getRawInstructions();
+  // num_threads = 0 picks one thread per hardware thread for large sources
+  turbo_asm( const std::string& filename, std::int32_t num_threads = 0 )
+      : m_source( filename ),
+        m_num_threads( num_threads > 0
+                           ? num_threads
+                           : common::ThreadPool::defaultThreadCount() ) {
+    std::vector<Chunk> chunks = splitSource();
+
+    if ( chunks.size() == 1 ) {
+      Chunk& chunk = chunks.front();
+      parseInstructions( chunk );
+      m_instructions = std::move( chunk.instructions );
+      m_instruction_lines = std::move( chunk.lines );
+      m_label_adr_map = std::move( chunk.label_adr_map );
+      resolveLabels( 0, 0, m_instructions.size() );
+      return;
+    }
 
-    m_instructions.reserve( raw_instructions.size() );
+    common::ThreadPool pool( chunks.size() );
+    pool.parallelFor( chunks.size(), [&chunks]( std::size_t i ) {
+      parseInstructions( chunks[i] );
+    } );
 
-    parseInstructions( raw_instructions );
+    mergeChunks( chunks );
 
-    resolveLabels();
+    pool.parallelFor( chunks.size(), [this, &chunks]( std::size_t i ) {
+      Chunk& chunk = chunks[i];
+      std::copy( chunk.instructions.begin(), chunk.instructions.end(),
+                 m_instructions.begin() + chunk.first_instruction );
+      std::transform( chunk.lines.begin(), chunk.lines.end(),
+                      m_instruction_lines.begin() + chunk.first_instruction,
+                      [&chunk]( std::int32_t line ) {
+                        return chunk.first_line + line;
+                      } );
+      resolveLabels( chunk.base_address, chunk.first_instruction,
+                     chunk.instructions.size() );
+    } );
   }
 
   void dumpBinary( const std::string& filename, const char delim = 0 ) {
@@ -36,8 +93,78 @@ struct turbo_asm {
   }
 
   std::string dumpBinary( const char delim = 0 ) {
+    std::size_t num_parts = std::min<std::size_t>(
+        m_num_threads, m_source.size() / min_chunk_size );
+    if ( num_parts <= 1 ) {
+      return encodeInstructions( 0, m_instructions.size(), delim );
+    }
+
+    // Encode contiguous slices in parallel and stitch them back in order
+    std::vector<std::string> parts( num_parts );
+    std::size_t part_size =
+        ( m_instructions.size() + num_parts - 1 ) / num_parts;
+    common::ThreadPool pool( num_parts );
+    pool.parallelFor( num_parts, [&]( std::size_t i ) {
+      std::size_t first = std::min( i * part_size, m_instructions.size() );
+      std::size_t last = std::min( first + part_size, m_instructions.size() );
+      parts[i] = encodeInstructions( first, last, delim );
+    } );
+
+    std::size_t total_size = 0;
+    for ( auto& part : parts ) {
+      total_size += part.size();
+    }
+    std::string result_binary;
+    result_binary.reserve( total_size );
+    for ( auto& part : parts ) {
+      result_binary += part;
+    }
+    return result_binary;
+  }
+
+  // Instructions view into this assembler's copy of the source file
+  const std::vector<Instruction>& getInstructions() const {
+    return m_instructions;
+  }
+
+  // Source line of every instruction in the binary
+  LineTable getLineTable() const {
+    std::vector<std::int32_t> lines;
+    lines.reserve( m_instructions.size() );
+    for ( std::size_t i = 0; i < m_instructions.size(); i++ ) {
+      const Instruction& instruction = m_instructions[i];
+      if ( !instruction.hasLabel() || !instruction.getName().empty() ) {
+        lines.push_back( m_instruction_lines[i] );
+      }
+    }
+    return LineTable( std::move( lines ) );
+  }
+
+  // Label of every labelled address, the first by name if there are several
+  std::map<std::int32_t, std::string> getSymbols() const {
+    std::map<std::int32_t, std::string> symbols;
+    for ( auto& [label_name, address] : m_label_adr_map ) {
+      auto [symbol, inserted] =
+          symbols.try_emplace( address, std::string( label_name ) );
+      if ( !inserted && label_name < symbol->second ) {
+        symbol->second = label_name;
+      }
+    }
+    return symbols;
+  }
+
+  void dumpLineTable( const std::string& filename ) const {
+    std::fstream file( filename, std::fstream::out );
+    getLineTable().write( file );
+  }
+
+ private:
+  std::string encodeInstructions( std::size_t first, std::size_t last,
+                                  const char delim ) {
     std::string result_binary;
-    for ( auto& instruction : m_instructions ) {
+    result_binary.reserve( ( last - first ) * ( delim != 0 ? 33 : 32 ) );
+    for ( auto i = first; i < last; i++ ) {
+      Instruction& instruction = m_instructions[i];
       if ( instruction.hasLabel() && instruction.getName().empty() ) {
         continue;
       }
@@ -50,28 +177,48 @@ struct turbo_asm {
     return result_binary;
   }
 
-  std::vector<Instruction> getInstructions() { return m_instructions; }
+  std::vector<Chunk> splitSource() {
+    std::string_view source = m_source.view();
+    std::size_t num_chunks = std::clamp<std::size_t>(
+        source.size() / min_chunk_size, 1, m_num_threads );
 
- private:
-  std::vector<std::string_view> getRawInstructions() {
-    auto raw_instructions =
-        m_file_contents | ranges::views::split( '\n' ) |
-        ranges::views::transform( []( auto&& component ) {
-          return std::string_view( &*component.begin(),
-                                   ranges::distance( component ) );
-        } ) |
-        ranges::to_vector;
-    return raw_instructions;
+    std::vector<Chunk> chunks( num_chunks );
+    std::size_t start = 0;
+    for ( std::size_t i = 0; i < num_chunks; i++ ) {
+      std::size_t end = source.size();
+      if ( i + 1 < num_chunks ) {
+        // Move the even split point just past the next newline
+        auto newline_pos = source.find(
+            '\n', std::max( start, source.size() * ( i + 1 ) / num_chunks ) );
+        end = newline_pos == std::string_view::npos ? source.size()
+                                                    : newline_pos + 1;
+      }
+      chunks[i].source = source.substr( start, end - start );
+      start = end;
+    }
+    return chunks;
   }
 
-  void parseInstructions( std::vector<std::string_view>& raw_instructions ) {
+  static void parseInstructions( Chunk& chunk ) {
+    chunk.num_lines =
+        std::count( chunk.source.begin(), chunk.source.end(), '\n' );
+    chunk.instructions.reserve( chunk.num_lines + 1 );
+    chunk.lines.reserve( chunk.num_lines + 1 );
+
     std::int32_t current_instr_address = 0;
-    for ( auto& raw_instruction : raw_instructions ) {
-      Instruction instr = Instruction( std::string( raw_instruction ) );
+    std::int32_t line = 0;
+    LineReader lines( chunk.source );
+    std::string_view raw_instruction;
+    while ( lines.next( raw_instruction ) ) {
+      line++;
+      Instruction instr = Instruction( raw_instruction );
+
+      if ( !instr.hasLabel() && instr.getName().empty() ) {
+        continue;  // Blank line, takes no space in the binary
+      }
 
       if ( instr.hasLabel() ) {
-        m_label_adr_map[std::string( instr.getLabelName() )] =
-            current_instr_address;
+        chunk.label_adr_map[instr.getLabelName()] = current_instr_address;
 
         if ( !instr.getName().empty() ) {
           current_instr_address += 4;
@@ -80,24 +227,51 @@ struct turbo_asm {
       } else {
         current_instr_address += 4;
       }
-      m_instructions.emplace_back( instr );
+      chunk.instructions.emplace_back( instr );
+      chunk.lines.push_back( line );
     }
+    chunk.code_size = current_instr_address;
   }
 
-  void resolveLabels() {
-    std::int32_t current_instruction_loc = 0;
-    for ( auto& instruction : m_instructions ) {
-      if ( instruction.hasLabel() && instruction.getName().empty() ) {
+  // Prefix sum over the chunk sizes gives every chunk its base address. Later
+  // chunks overwrite earlier definitions of the same label, just like a
+  // single pass over the whole file does.
+  void mergeChunks( std::vector<Chunk>& chunks ) {
+    std::int32_t base_address = 0;
+    std::size_t first_instruction = 0;
+    std::int32_t first_line = 0;
+    for ( auto& chunk : chunks ) {
+      chunk.base_address = base_address;
+      chunk.first_instruction = first_instruction;
+      chunk.first_line = first_line;
+      for ( auto& [label_name, address] : chunk.label_adr_map ) {
+        m_label_adr_map[label_name] = base_address + address;
+      }
+      base_address += chunk.code_size;
+      first_instruction += chunk.instructions.size();
+      first_line += chunk.num_lines;
+    }
+    m_instructions.resize( first_instruction );
+    m_instruction_lines.resize( first_instruction );
+  }
+
+  // Read only on m_label_adr_map, so chunks can be resolved concurrently
+  void resolveLabels( std::int32_t base_address, std::size_t first_instruction,
+                      std::size_t num_instructions ) {
+    std::int32_t current_instruction_loc = base_address;
+    auto first = m_instructions.begin() + first_instruction;
+    auto last = first + num_instructions;
+    for ( auto instruction = first; instruction != last; instruction++ ) {
+      if ( instruction->hasLabel() && instruction->getName().empty() ) {
         continue;  // No changes to current instr location
       }
 
       //-----------------------------------------------------------------
-      for ( auto operand : instruction.getOperands() ) {
-        if ( operand->getOperandType() == Operand::OperandType::LabelOp ) {
-          Label* label_operand = (Label*)operand.get();
-          label_operand->setAddress( m_label_adr_map[label_operand->getName()] -
-                                     current_instruction_loc );
-          // label_operand->setOperandLength( 12 );
+      for ( auto& operand : instruction->getOperands() ) {
+        if ( auto* label_operand = std::get_if<Label>( &operand ) ) {
+          label_operand->setAddress(
+              getLabelAddress( label_operand->getName() ) -
+              current_instruction_loc );
         }
       }
       //-----------------------------------------------------------------
@@ -105,12 +279,11 @@ struct turbo_asm {
       current_instruction_loc += 4;
     }
   }
-  std::string readFile( const std::string& filename ) {
-    std::fstream file( filename );
-    std::stringstream file_stream;
-    file_stream << file.rdbuf();
-    std::string file_contents( file_stream.str() );
-    return file_contents;
+
+  // Undefined labels resolve to address 0
+  std::int32_t getLabelAddress( std::string_view label_name ) const {
+    auto label_loc = m_label_adr_map.find( label_name );
+    return label_loc == m_label_adr_map.end() ? 0 : label_loc->second;
   }
 };
-}  // namespace assembler
\ No newline at end of file
+}  // namespace assembler
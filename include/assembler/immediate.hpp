@@ -1,7 +1,8 @@
 #pragma once
 
 #include <bitset>
-#include <range/v3/all.hpp>
+#include <cstdint>
+#include <string>
 
 #include "operand.hpp"
 
@@ -9,9 +10,8 @@ namespace assembler {
 
 struct Immediate : Operand {
  private:
-  std::bitset<64> binary_value;
-  std::int64_t m_value;
-  std::int32_t m_operand_length;
+  std::int64_t m_value = 0;
+  std::int32_t m_operand_length = 12;
 
  public:
   Immediate() = default;
@@ -21,14 +21,11 @@ struct Immediate : Operand {
 
   std::int32_t getOperandLength() { return m_operand_length; }
 
-  OperandType getOperandType() override { return OperandType::ImmediateOp; }
+  OperandType getOperandType() { return OperandType::ImmediateOp; }
 
-  std::string getBinaryValue() override {
-    binary_value = m_value;
-    std::string result = binary_value.to_string() |
-                         ranges::actions::drop( 64 - m_operand_length );
-    // std::reverse( result.begin(), result.end() );
-    return result;
+  std::string getBinaryValue() {
+    std::string result = std::bitset<64>( m_value ).to_string();
+    return result.substr( 64 - m_operand_length );
   }
 };
-}  // namespace assembler
\ No newline at end of file
+}  // namespace assembler
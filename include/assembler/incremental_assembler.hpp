@@ -0,0 +1,396 @@
+#pragma once
+
+#include <algorithm>
+#include <assembler/instruction.hpp>
+#include <assembler/line_reader.hpp>
+#include <common/fenwick_tree.hpp>
+#include <common/mapped_file.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace assembler {
+// Assembler for edit-and-rerun loops. The parsed instructions, their
+// encodings and the label tables are kept between edits, and an edit only
+// parses the lines it replaces:
+//   - lines are grouped in blocks and keep their address relative to the
+//     block, the block start addresses are prefix sums in a Fenwick tree,
+//     so a change in code size is O(log n) instead of moving later lines
+//   - label definitions and users are indexed by label name, and
+//     dumpBinary re-encodes only the users whose PC-relative offset changed
+// Produces the same binary as turbo_asm for the same source.
+struct incremental_asm {
+ private:
+  struct Block;
+
+  struct Line {
+    std::string text;  // Owned here, the Instruction views into it
+    Instruction instruction;
+    Block* block = nullptr;
+    std::size_t index = 0;    // Position in the block
+    std::int32_t offset = 0;  // Address of the ( next ) instruction in block
+    std::string binary_encoding;
+
+    bool isEmitted() { return !instruction.getName().empty(); }
+  };
+
+  struct Block {
+    std::vector<std::unique_ptr<Line>> lines;
+    std::size_t index = 0;  // Position in m_blocks
+    std::int32_t code_size = 0;
+  };
+
+  // Blocks are split once they grow past twice this
+  static constexpr std::size_t block_lines = 256;
+
+  // Lines and blocks are pinned on the heap so the views into the line text
+  // and the pointers in the label tables survive edits
+  std::vector<std::unique_ptr<Block>> m_blocks;
+  common::FenwickTree<std::size_t> m_block_line_counts;
+  common::FenwickTree<std::int32_t> m_block_code_sizes;
+  std::size_t m_num_lines = 0;
+
+  std::unordered_map<std::string, std::vector<Line*>> m_label_defs;
+  std::unordered_map<std::string, std::unordered_set<Line*>> m_label_users;
+  std::unordered_set<Line*> m_unresolved_lines;  // Need ( re-) encoding
+  bool m_offsets_changed = false;  // Code size or label definitions changed
+
+  std::size_t m_reparsed_lines = 0;
+  std::size_t m_resolved_lines = 0;
+
+ public:
+  incremental_asm() {
+    m_blocks.push_back( std::make_unique<Block>() );
+    rebuildBlockSums();
+  }
+  incremental_asm( const std::string& filename ) : incremental_asm() {
+    reload( filename );
+  }
+
+  // Re-reads filename and re-assembles what differs from the last version
+  void reload( const std::string& filename ) {
+    common::MappedFile source( filename );
+    update( source.view() );
+  }
+
+  // Diffs source against the current lines ( common prefix and suffix ) and
+  // replaces the differing range. This is O(file), editors that know the
+  // changed lines should call replaceLines directly.
+  void update( std::string_view source ) {
+    std::vector<std::string_view> new_lines;
+    LineReader lines( source );
+    std::string_view line;
+    while ( lines.next( line ) ) {
+      new_lines.push_back( line );
+    }
+    std::vector<std::string_view> old_lines;
+    old_lines.reserve( m_num_lines );
+    for ( auto& block : m_blocks ) {
+      for ( auto& old_line : block->lines ) {
+        old_lines.push_back( old_line->text );
+      }
+    }
+
+    std::size_t prefix = 0;
+    while ( prefix < old_lines.size() && prefix < new_lines.size() &&
+            old_lines[prefix] == new_lines[prefix] ) {
+      prefix++;
+    }
+    std::size_t suffix = 0;
+    while ( suffix < old_lines.size() - prefix &&
+            suffix < new_lines.size() - prefix &&
+            old_lines[old_lines.size() - 1 - suffix] ==
+                new_lines[new_lines.size() - 1 - suffix] ) {
+      suffix++;
+    }
+
+    replaceLines( prefix, old_lines.size() - prefix - suffix,
+                  std::vector<std::string_view>(
+                      new_lines.begin() + prefix,
+                      new_lines.end() - suffix ) );
+  }
+
+  // Replaces num_lines lines starting at first_line ( 0 based ) by new_lines.
+  // Costs O(log n) plus the size of the edit, the label operands are
+  // resolved by the next dumpBinary.
+  void replaceLines( std::size_t first_line, std::size_t num_lines,
+                     const std::vector<std::string_view>& new_lines ) {
+    if ( first_line > m_num_lines || num_lines > m_num_lines - first_line ) {
+      throw std::out_of_range( "Line range out of range" );
+    }
+    m_reparsed_lines = new_lines.size();
+    std::int32_t old_code_size = getCodeSize();
+
+    // A first_line past the end appends to the last block
+    std::size_t block_index =
+        std::min( m_block_line_counts.findPrefix( first_line ),
+                  m_blocks.size() - 1 );
+    Block* block = m_blocks[block_index].get();
+    std::size_t position =
+        first_line - m_block_line_counts.prefixSum( block_index );
+    std::vector<Block*> touched_blocks{ block };
+
+    // The removed lines can reach into the following blocks
+    std::size_t remaining = num_lines;
+    for ( auto i = block_index; remaining > 0; i++ ) {
+      Block* current = m_blocks[i].get();
+      auto& lines = current->lines;
+      std::size_t begin = current == block ? position : 0;
+      std::size_t end = std::min( lines.size(), begin + remaining );
+      for ( auto j = begin; j < end; j++ ) {
+        unregisterLine( lines[j].get() );
+      }
+      lines.erase( lines.begin() + begin, lines.begin() + end );
+      remaining -= end - begin;
+      if ( current != block ) {
+        touched_blocks.push_back( current );
+      }
+    }
+
+    std::vector<std::unique_ptr<Line>> parsed_lines;
+    parsed_lines.reserve( new_lines.size() );
+    for ( auto raw_line : new_lines ) {
+      auto line = std::make_unique<Line>();
+      line->text = raw_line;
+      line->instruction = Instruction( line->text );
+      registerLine( line.get() );
+      parsed_lines.push_back( std::move( line ) );
+    }
+    block->lines.insert( block->lines.begin() + position,
+                         std::make_move_iterator( parsed_lines.begin() ),
+                         std::make_move_iterator( parsed_lines.end() ) );
+    m_num_lines = m_num_lines - num_lines + new_lines.size();
+
+    bool blocks_changed = false;
+    if ( block->lines.size() > 2 * block_lines ) {
+      splitBlock( block_index, touched_blocks );
+      blocks_changed = true;
+    }
+    for ( Block* touched : touched_blocks ) {
+      renumberBlock( touched );
+      blocks_changed |= touched->lines.empty();
+    }
+
+    // Changing the set of blocks is O(blocks), which splitting at twice the
+    // block size keeps rare
+    if ( blocks_changed ) {
+      std::erase_if( m_blocks,
+                     []( auto& current ) { return current->lines.empty(); } );
+      if ( m_blocks.empty() ) {
+        m_blocks.push_back( std::make_unique<Block>() );
+      }
+      rebuildBlockSums();
+    } else {
+      for ( Block* touched : touched_blocks ) {
+        m_block_line_counts.set( touched->index, touched->lines.size() );
+        m_block_code_sizes.set( touched->index, touched->code_size );
+      }
+    }
+    m_offsets_changed |= getCodeSize() != old_code_size;
+  }
+
+  std::string dumpBinary( const char delim = 0 ) {
+    resolveLabels();
+    std::string result_binary;
+    result_binary.reserve( getCodeSize() / 4 * ( delim != 0 ? 33 : 32 ) );
+    for ( auto& block : m_blocks ) {
+      for ( auto& line : block->lines ) {
+        if ( !line->isEmitted() ) {
+          continue;
+        }
+        result_binary += line->binary_encoding;
+        if ( delim != 0 ) {
+          result_binary += delim;
+        }
+      }
+    }
+    return result_binary;
+  }
+
+  void dumpBinary( const std::string& filename, const char delim = 0 ) {
+    std::fstream file( filename, std::fstream::out );
+    file << dumpBinary( delim );
+    file.close();
+  }
+
+  std::size_t getLineCount() { return m_num_lines; }
+
+  // Work done by the last edit and the last dumpBinary, for checking that
+  // edits stay incremental
+  std::size_t getReparsedLineCount() { return m_reparsed_lines; }
+  std::size_t getResolvedLineCount() { return m_resolved_lines; }
+
+ private:
+  std::int32_t getCodeSize() {
+    return m_block_code_sizes.prefixSum( m_blocks.size() );
+  }
+
+  std::int32_t getAddress( Line* line ) {
+    return m_block_code_sizes.prefixSum( line->block->index ) + line->offset;
+  }
+
+  // Moves the lines past block_lines into new blocks after it
+  void splitBlock( std::size_t block_index,
+                   std::vector<Block*>& touched_blocks ) {
+    auto& lines = m_blocks[block_index]->lines;
+    std::vector<std::unique_ptr<Block>> new_blocks;
+    for ( auto begin = block_lines; begin < lines.size();
+          begin += block_lines ) {
+      auto end = std::min( begin + block_lines, lines.size() );
+      auto new_block = std::make_unique<Block>();
+      new_block->lines.assign(
+          std::make_move_iterator( lines.begin() + begin ),
+          std::make_move_iterator( lines.begin() + end ) );
+      touched_blocks.push_back( new_block.get() );
+      new_blocks.push_back( std::move( new_block ) );
+    }
+    lines.resize( block_lines );
+    m_blocks.insert( m_blocks.begin() + block_index + 1,
+                     std::make_move_iterator( new_blocks.begin() ),
+                     std::make_move_iterator( new_blocks.end() ) );
+  }
+
+  void renumberBlock( Block* block ) {
+    std::int32_t offset = 0;
+    for ( std::size_t i = 0; i < block->lines.size(); i++ ) {
+      Line* line = block->lines[i].get();
+      line->block = block;
+      line->index = i;
+      line->offset = offset;
+      offset += line->isEmitted() ? 4 : 0;
+    }
+    block->code_size = offset;
+  }
+
+  void rebuildBlockSums() {
+    std::vector<std::size_t> line_counts;
+    std::vector<std::int32_t> code_sizes;
+    for ( std::size_t i = 0; i < m_blocks.size(); i++ ) {
+      m_blocks[i]->index = i;
+      line_counts.push_back( m_blocks[i]->lines.size() );
+      code_sizes.push_back( m_blocks[i]->code_size );
+    }
+    m_block_line_counts.assign( std::move( line_counts ) );
+    m_block_code_sizes.assign( std::move( code_sizes ) );
+  }
+
+  // Lines without label operands are encoded right away
+  void registerLine( Line* line ) {
+    Instruction& instr = line->instruction;
+    if ( instr.hasLabel() ) {
+      m_label_defs[std::string( instr.getLabelName() )].push_back( line );
+      m_offsets_changed = true;
+    }
+    bool uses_labels = false;
+    for ( auto& operand : instr.getOperands() ) {
+      if ( auto* label_operand = std::get_if<Label>( &operand ) ) {
+        m_label_users[std::string( label_operand->getName() )].insert( line );
+        uses_labels = true;
+      }
+    }
+    if ( uses_labels ) {
+      m_unresolved_lines.insert( line );
+    } else if ( line->isEmitted() ) {
+      line->binary_encoding = instr.getBinaryEncoding();
+    }
+  }
+
+  void unregisterLine( Line* line ) {
+    Instruction& instr = line->instruction;
+    if ( instr.hasLabel() ) {
+      std::string label_name( instr.getLabelName() );
+      auto& defs = m_label_defs[label_name];
+      defs.erase( std::find( defs.begin(), defs.end(), line ) );
+      if ( defs.empty() ) {
+        m_label_defs.erase( label_name );
+      }
+      m_offsets_changed = true;
+    }
+    for ( auto& operand : instr.getOperands() ) {
+      if ( auto* label_operand = std::get_if<Label>( &operand ) ) {
+        std::string label_name( label_operand->getName() );
+        auto& users = m_label_users[label_name];
+        users.erase( line );
+        if ( users.empty() ) {
+          m_label_users.erase( label_name );
+        }
+      }
+    }
+    m_unresolved_lines.erase( line );
+  }
+
+  // The last definition in the source wins, undefined labels resolve to
+  // address 0 like in turbo_asm
+  std::int32_t getLabelAddress( const std::string& label_name ) {
+    auto defs_loc = m_label_defs.find( label_name );
+    if ( defs_loc == m_label_defs.end() ) {
+      return 0;
+    }
+    auto& defs = defs_loc->second;
+    Line* last_def =
+        *std::max_element( defs.begin(), defs.end(), []( Line* a, Line* b ) {
+          return std::pair( a->block->index, a->index ) <
+                 std::pair( b->block->index, b->index );
+        } );
+    return getAddress( last_def );
+  }
+
+  // True if the offset of one of the line's label_name operands changed
+  bool setLabelOffset( Line* line, std::string_view label_name,
+                       std::int32_t offset ) {
+    bool changed = false;
+    for ( auto& operand : line->instruction.getOperands() ) {
+      auto* label_operand = std::get_if<Label>( &operand );
+      if ( label_operand != nullptr && label_operand->getName() == label_name &&
+           label_operand->getAddressValue() != offset ) {
+        label_operand->setAddress( offset );
+        changed = true;
+      }
+    }
+    return changed;
+  }
+
+  // Encodes the new label users, and if code moved or label definitions
+  // changed, the users whose label offset changed. Every label address is
+  // looked up once.
+  void resolveLabels() {
+    if ( m_offsets_changed ) {
+      for ( auto& [label_name, users] : m_label_users ) {
+        std::int32_t label_address = getLabelAddress( label_name );
+        for ( Line* user : users ) {
+          if ( setLabelOffset( user, label_name,
+                               label_address - getAddress( user ) ) ) {
+            m_unresolved_lines.insert( user );
+          }
+        }
+      }
+      m_offsets_changed = false;
+    } else {
+      for ( Line* line : m_unresolved_lines ) {
+        for ( auto& operand : line->instruction.getOperands() ) {
+          if ( auto* label_operand = std::get_if<Label>( &operand ) ) {
+            std::string label_name( label_operand->getName() );
+            setLabelOffset(
+                line, label_name,
+                getLabelAddress( label_name ) - getAddress( line ) );
+          }
+        }
+      }
+    }
+
+    for ( Line* line : m_unresolved_lines ) {
+      line->binary_encoding = line->instruction.getBinaryEncoding();
+    }
+    m_resolved_lines = m_unresolved_lines.size();
+    m_unresolved_lines.clear();
+  }
+};
+}  // namespace assembler
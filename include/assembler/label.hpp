@@ -1,23 +1,26 @@
-#include <algorithm>
+#pragma once
+
 #include <assembler/operand.hpp>
+#include <bitset>
 #include <cstddef>
 #include <cstdint>
-#include <range/v3/all.hpp>
 #include <string>
 #include <string_view>
 
 namespace assembler {
 struct Label : Operand {
  private:
-  std::bitset<64> binary_value;
-  std::int32_t m_operand_length;
+  std::int32_t m_operand_length = 12;
   std::int32_t m_address = 0;
-  std::string m_label_name;
+  std::string_view m_label_name;  // View into the source text
 
  public:
-  Label( const std::string_view& label_name, std::int32_t operand_length=12 ) : m_label_name( label_name ), m_operand_length(operand_length) {}
-  std::string getName() { return m_label_name; }
+  Label() = default;
+  Label( std::string_view label_name, std::int32_t operand_length = 12 )
+      : m_operand_length( operand_length ), m_label_name( label_name ) {}
+  std::string_view getName() { return m_label_name; }
   void setAddress( std::int32_t address ) { m_address = address; }
+  std::int32_t getAddressValue() { return m_address; }
   std::string getAddress() {
     if ( m_address ) {
       return std::to_string( m_address );
@@ -30,16 +33,14 @@ struct Label : Operand {
     m_operand_length = operand_length;
   }
 
-  OperandType getOperandType() override { return OperandType::LabelOp; }
+  OperandType getOperandType() { return OperandType::LabelOp; }
 
-  std::string getBinaryValue() override {
-    binary_value = m_address;
-    std::string result =
-        m_address != 0 ? binary_value.to_string() |
-                             ranges::actions::drop( 64 - m_operand_length )
-                       : "";
-    // std::reverse( result.begin(), result.end() );
-    return result;
+  std::string getBinaryValue() {
+    if ( m_address == 0 ) {
+      return "";
+    }
+    std::string result = std::bitset<64>( m_address ).to_string();
+    return result.substr( 64 - m_operand_length );
   }
 };
 }  // namespace assembler
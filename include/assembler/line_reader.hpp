@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string_view>
+
+namespace assembler {
+// Splits source text into '\n' separated lines without copying
+struct LineReader {
+ private:
+  std::string_view m_remaining;
+  bool m_done = false;
+
+ public:
+  LineReader( std::string_view text ) : m_remaining( text ) {
+    m_done = text.empty();
+  }
+
+  bool next( std::string_view& line ) {
+    if ( m_done ) {
+      return false;
+    }
+    auto end_pos = m_remaining.find( '\n' );
+    line = m_remaining.substr( 0, end_pos );
+    if ( end_pos == std::string_view::npos ) {
+      m_done = true;
+    } else {
+      m_remaining.remove_prefix( end_pos + 1 );
+    }
+    return true;
+  }
+};
+}  // namespace assembler
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace assembler {
+// Source line ( 1 based ) of every encoded instruction, indexed by its
+// address / 4. Written as one "address line" pair per instruction, the
+// address in hex.
+struct LineTable {
+ private:
+  std::vector<std::int32_t> m_lines;
+
+ public:
+  LineTable() = default;
+  LineTable( std::vector<std::int32_t> lines )
+      : m_lines( std::move( lines ) ) {}
+
+  // 0 for addresses outside the program
+  std::int32_t getLine( std::int32_t address ) const {
+    std::size_t index = std::uint32_t( address ) >> 2;
+    return index < m_lines.size() ? m_lines[index] : 0;
+  }
+
+  std::size_t size() const { return m_lines.size(); }
+
+  const std::vector<std::int32_t>& getLines() const { return m_lines; }
+
+  void write( std::ostream& out ) const {
+    for ( std::size_t i = 0; i < m_lines.size(); i++ ) {
+      out << std::hex << i * 4 << std::dec << ' ' << m_lines[i] << '\n';
+    }
+  }
+
+  static LineTable read( std::istream& in ) {
+    std::vector<std::int32_t> lines;
+    std::uint32_t address;
+    std::int32_t line;
+    while ( in >> std::hex >> address >> std::dec >> line ) {
+      if ( address != lines.size() * 4 ) {
+        throw std::runtime_error( "Line table addresses must be consecutive" );
+      }
+      lines.push_back( line );
+    }
+    if ( !in.eof() ) {
+      throw std::runtime_error( "Invalid line table entry" );
+    }
+    return LineTable( std::move( lines ) );
+  }
+
+  bool operator==( const LineTable& ) const = default;
+};
+}  // namespace assembler
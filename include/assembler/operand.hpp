@@ -1,10 +1,17 @@
 #pragma once
 
 #include <cctype>
+#include <charconv>
+#include <cstdint>
 #include <cstdio>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 
 namespace assembler {
+// Common helpers for the operand types. Operands are plain value types held
+// inline by Instruction ( see OperandVariant ), so there is no virtual
+// interface here.
 struct Operand {
   enum OperandType { RegisterOp, ImmediateOp, LabelOp, RegisterDisplacementOp };
   static OperandType identifyType( std::string_view operand ) {
@@ -12,8 +19,21 @@ struct Operand {
            : operand.find( '(' ) == std::string::npos ? ImmediateOp
                                                       : RegisterDisplacementOp;
   }
-  virtual OperandType getOperandType() = 0;
-  virtual std::string getBinaryValue() = 0;
-  virtual ~Operand(){};
+
+  // Parses the leading integer of str, trailing characters ( ',' ')' ) are
+  // ignored the same way std::stoll ignores them
+  static std::int64_t parseInteger( std::string_view str ) {
+    if ( !str.empty() && str.front() == '+' ) {
+      str.remove_prefix( 1 );
+    }
+    std::int64_t value = 0;
+    auto [ptr, ec] =
+        std::from_chars( str.data(), str.data() + str.size(), value );
+    if ( ec != std::errc() ) {
+      throw std::invalid_argument( "Invalid integer operand : " +
+                                   std::string( str ) );
+    }
+    return value;
+  }
 };
-}  // namespace assembler
\ No newline at end of file
+}  // namespace assembler
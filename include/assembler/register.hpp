@@ -1,27 +1,29 @@
 #pragma once
 
-#include <algorithm>
 #include <bitset>
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 #include "operand.hpp"
 
 namespace assembler {
 struct Register : Operand {
  private:
-  std::string m_register_name;
+  std::string_view m_register_name;  // View into the source text
+  std::int32_t m_register_number = 0;
 
  public:
-  Register( const std::string_view reg_name ) : m_register_name( reg_name ) {}
+  Register() = default;
+  Register( const std::string_view reg_name )
+      : m_register_name( reg_name ),
+        m_register_number( parseInteger( reg_name.substr( 1 ) ) ) {}
 
-  OperandType getOperandType() override { return OperandType::RegisterOp; }
-  std::string getBinaryValue() override {
-    std::string_view str( m_register_name.begin() + 1, m_register_name.end() );
-
-    std::string result = std::bitset<5>( std::stoll( str.data() ) ).to_string();
-    // std::reverse( result.begin(), result.end() );
-    return result;
+  OperandType getOperandType() { return OperandType::RegisterOp; }
+  std::string getBinaryValue() {
+    return std::bitset<5>( m_register_number ).to_string();
   }
-  std::string getName() { return m_register_name; }
+  std::string_view getName() { return m_register_name; }
+  std::int32_t getNumber() { return m_register_number; }
 };
-}  // namespace assembler
\ No newline at end of file
+}  // namespace assembler
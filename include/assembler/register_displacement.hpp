@@ -1,25 +1,27 @@
+#pragma once
+
 #include <assembler/immediate.hpp>
 #include <assembler/operand.hpp>
 #include <assembler/register.hpp>
-#include <cstdlib>
-#include <range/v3/all.hpp>
+#include <cstdint>
+#include <string>
+#include <string_view>
 
 namespace assembler {
 struct RegisterDispOp : Operand {
  private:
-  std::int32_t m_displacement;
-  std::string m_register_name;
-  std::string m_operand;
+  std::int32_t m_displacement = 0;
+  std::string_view m_register_name;  // Views into the source text
+  std::string_view m_operand;
 
  public:
+  RegisterDispOp() = default;
   RegisterDispOp( const std::string_view operand ) : m_operand( operand ) {
     parseOperand();
   }
 
-  OperandType getOperandType() override {
-    return OperandType::RegisterDisplacementOp;
-  }
-  std::string getBinaryValue() override {
+  OperandType getOperandType() { return OperandType::RegisterDisplacementOp; }
+  std::string getBinaryValue() {
     return "";  // Not useful here
   }
 
@@ -31,23 +33,23 @@ struct RegisterDispOp : Operand {
   }
 
   std::int32_t getDisplacement() { return m_displacement; }
-  std::string getRegisterName() { return m_register_name; }
+  std::string_view getRegisterName() { return m_register_name; }
 
  private:
   void parseOperand() {
-    auto components =
-        m_operand | ranges::views::split( '(' ) |
-        ranges::views::transform( []( auto&& component ) {
-          return std::string_view( &*component.begin(),
-                                   ranges::distance( component ) );
-        } ) |
-        ranges::to_vector;
-
-    m_displacement = std::atoi( components[0].data() );
-
-    // Register name
-    components[1].remove_suffix( 1 );  // Remove the ending braces
-    m_register_name = components[1];
+    // <displacement>(<register>)
+    auto open_pos = m_operand.find( '(' );
+    auto close_pos = m_operand.find( ')', open_pos );
+
+    std::string_view displacement = m_operand.substr( 0, open_pos );
+    m_displacement = displacement.empty() || displacement.front() == '('
+                         ? 0
+                         : parseInteger( displacement );
+
+    m_register_name =
+        m_operand.substr( open_pos + 1, close_pos == std::string_view::npos
+                                            ? std::string_view::npos
+                                            : close_pos - open_pos - 1 );
   }
 };
 
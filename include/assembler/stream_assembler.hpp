@@ -0,0 +1,162 @@
+#pragma once
+
+#include <assembler/instruction.hpp>
+#include <assembler/line_reader.hpp>
+#include <common/mapped_file.hpp>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace assembler {
+// Single pass assembler for very large sources. The source is memory mapped
+// and each line is encoded and written out as soon as it is read, so memory
+// use is bounded by the label table and the forward references that are
+// still waiting for their label, not by the program size.
+//
+// Produces the same binary as turbo_asm for well formed programs, but
+// rejects references to labels that are never defined.
+struct stream_asm {
+  static constexpr std::int32_t instruction_width = 32;
+
+ private:
+  // Instruction whose label operand was not yet defined when it was read.
+  // A placeholder was written at position and is patched once the label
+  // appears.
+  struct Fixup {
+    std::streamoff position;
+    std::int32_t address;
+    Instruction instruction;
+  };
+
+  using LabelMap = std::unordered_map<std::string_view, std::int32_t>;
+  using FixupMap = std::unordered_map<std::string_view, std::vector<Fixup>>;
+
+  common::MappedFile m_source;
+
+ public:
+  stream_asm( const std::string& filename ) : m_source( filename ) {
+    m_source.adviseSequential();
+  }
+
+  // out must be seekable if the program contains forward references
+  void assemble( std::ostream& out, const char delim = 0 ) {
+    LabelMap label_adr_map;
+    FixupMap pending_fixups;
+    std::int32_t current_instr_address = 0;
+
+    LineReader lines( m_source.view() );
+    std::string_view raw_instruction;
+    while ( lines.next( raw_instruction ) ) {
+      Instruction instr( raw_instruction );
+
+      if ( instr.hasLabel() ) {
+        label_adr_map[instr.getLabelName()] = current_instr_address;
+        applyFixups( out, instr.getLabelName(), label_adr_map,
+                     pending_fixups );
+      }
+
+      if ( instr.getName().empty() ) {
+        continue;  // Label only or blank line, nothing to emit
+      }
+
+      std::string_view missing_label =
+          resolveLabels( instr, current_instr_address, label_adr_map );
+      if ( missing_label.empty() ) {
+        out << instr.getBinaryEncoding();
+      } else {
+        pending_fixups[missing_label].push_back(
+            { out.tellp(), current_instr_address, instr } );
+        out << std::string( instruction_width, '0' );
+      }
+      if ( delim != 0 ) {
+        out << delim;
+      }
+
+      current_instr_address += 4;
+    }
+
+    if ( !pending_fixups.empty() ) {
+      throw std::runtime_error( "Undefined label : " +
+                                std::string( pending_fixups.begin()->first ) );
+    }
+  }
+
+  void dumpBinary( const std::string& filename, const char delim = 0 ) {
+    std::fstream file( filename, std::fstream::out | std::fstream::trunc );
+    assemble( file, delim );
+    file.close();
+  }
+
+  std::string dumpBinary( const char delim = 0 ) {
+    std::stringstream binary_stream;
+    assemble( binary_stream, delim );
+    return binary_stream.str();
+  }
+
+ private:
+  // Sets the offset of every label operand whose label is known. Returns the
+  // name of the first label that is not known yet ( empty if none ).
+  static std::string_view resolveLabels( Instruction& instr,
+                                         std::int32_t instr_address,
+                                         const LabelMap& label_adr_map ) {
+    std::string_view missing_label;
+    for ( auto& operand : instr.getOperands() ) {
+      if ( auto* label_operand = std::get_if<Label>( &operand ) ) {
+        auto label_loc = label_adr_map.find( label_operand->getName() );
+        if ( label_loc == label_adr_map.end() ) {
+          if ( missing_label.empty() ) {
+            missing_label = label_operand->getName();
+          }
+          continue;
+        }
+        label_operand->setAddress( label_loc->second - instr_address );
+      }
+    }
+    return missing_label;
+  }
+
+  static void applyFixups( std::ostream& out, std::string_view label_name,
+                           const LabelMap& label_adr_map,
+                           FixupMap& pending_fixups ) {
+    auto fixups_loc = pending_fixups.find( label_name );
+    if ( fixups_loc == pending_fixups.end() ) {
+      return;
+    }
+    std::vector<Fixup> fixups = std::move( fixups_loc->second );
+    pending_fixups.erase( fixups_loc );
+
+    for ( auto& fixup : fixups ) {
+      std::string_view missing_label = resolveLabels(
+          fixup.instruction, fixup.address, label_adr_map );
+      if ( missing_label.empty() ) {
+        patch( out, fixup );
+      } else {
+        pending_fixups[missing_label].push_back( fixup );
+      }
+    }
+  }
+
+  static void patch( std::ostream& out, Fixup& fixup ) {
+    if ( fixup.position < 0 ) {
+      throw std::invalid_argument(
+          "Forward label references need a seekable output stream" );
+    }
+    std::string binary_encoding = fixup.instruction.getBinaryEncoding();
+    if ( binary_encoding.size() != instruction_width ) {
+      throw std::logic_error( "Unexpected encoding size for : " +
+                              std::string( fixup.instruction.getName() ) );
+    }
+
+    auto end_position = out.tellp();
+    out.seekp( fixup.position );
+    out << binary_encoding;
+    out.seekp( end_position );
+  }
+};
+}  // namespace assembler
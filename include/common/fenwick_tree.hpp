@@ -0,0 +1,69 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace common {
+
+// Prefix sums over a sequence of values, with O(log n) updates and queries.
+// Changing the length of the sequence means building it again with assign.
+template <typename T>
+struct FenwickTree {
+ private:
+  std::vector<T> m_values;
+  std::vector<T> m_tree;  // 1 based, m_tree[i] sums the values ( i - lsb, i ]
+
+  static std::size_t lowestBit( std::size_t i ) { return i & ( ~i + 1 ); }
+
+ public:
+  FenwickTree() = default;
+
+  // O(n)
+  void assign( std::vector<T> values ) {
+    m_values = std::move( values );
+    m_tree.assign( m_values.size() + 1, T() );
+    for ( std::size_t i = 1; i < m_tree.size(); i++ ) {
+      m_tree[i] += m_values[i - 1];
+      std::size_t parent = i + lowestBit( i );
+      if ( parent < m_tree.size() ) {
+        m_tree[parent] += m_tree[i];
+      }
+    }
+  }
+
+  std::size_t size() const { return m_values.size(); }
+  T get( std::size_t index ) const { return m_values[index]; }
+
+  void set( std::size_t index, T value ) {
+    T delta = value - m_values[index];
+    m_values[index] = value;
+    for ( std::size_t i = index + 1; i < m_tree.size(); i += lowestBit( i ) ) {
+      m_tree[i] += delta;
+    }
+  }
+
+  // Sum of the first count values
+  T prefixSum( std::size_t count ) const {
+    T sum = T();
+    for ( std::size_t i = count; i > 0; i -= lowestBit( i ) ) {
+      sum += m_tree[i];
+    }
+    return sum;
+  }
+
+  // Largest count with prefixSum( count ) <= sum, for non-negative values
+  std::size_t findPrefix( T sum ) const {
+    std::size_t count = 0;
+    for ( std::size_t step = std::bit_floor( m_values.size() ); step > 0;
+          step >>= 1 ) {
+      if ( count + step < m_tree.size() && m_tree[count + step] <= sum ) {
+        count += step;
+        sum -= m_tree[count];
+      }
+    }
+    return count;
+  }
+};
+}  // namespace common
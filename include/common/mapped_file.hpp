@@ -0,0 +1,90 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace common {
+
+// Read only memory mapping of a whole file. Pages are file backed, so the
+// kernel can drop them again once they have been scanned.
+struct MappedFile {
+ private:
+  void* m_data = nullptr;
+  std::size_t m_size = 0;
+
+ public:
+  MappedFile() = default;
+  MappedFile( const std::string& filename ) {
+    int fd = ::open( filename.c_str(), O_RDONLY );
+    if ( fd < 0 ) {
+      throw std::runtime_error( "Unable to open file : " + filename );
+    }
+
+    struct stat file_stat;
+    if ( ::fstat( fd, &file_stat ) != 0 ) {
+      ::close( fd );
+      throw std::runtime_error( "Unable to stat file : " + filename );
+    }
+
+    m_size = file_stat.st_size;
+    if ( m_size != 0 ) {
+      m_data = ::mmap( nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    }
+    ::close( fd );
+
+    if ( m_data == MAP_FAILED ) {
+      m_data = nullptr;
+      m_size = 0;
+      throw std::runtime_error( "Unable to map file : " + filename );
+    }
+  }
+
+  MappedFile( const MappedFile& ) = delete;
+  MappedFile& operator=( const MappedFile& ) = delete;
+
+  MappedFile( MappedFile&& other ) noexcept
+      : m_data( std::exchange( other.m_data, nullptr ) ),
+        m_size( std::exchange( other.m_size, 0 ) ) {}
+
+  MappedFile& operator=( MappedFile&& other ) noexcept {
+    if ( this != &other ) {
+      unmap();
+      m_data = std::exchange( other.m_data, nullptr );
+      m_size = std::exchange( other.m_size, 0 );
+    }
+    return *this;
+  }
+
+  ~MappedFile() { unmap(); }
+
+  // Hint that the mapping will be read front to back exactly once
+  void adviseSequential() {
+    if ( m_data ) {
+      ::madvise( m_data, m_size, MADV_SEQUENTIAL );
+    }
+  }
+
+  std::string_view view() const {
+    return std::string_view( static_cast<const char*>( m_data ), m_size );
+  }
+  const char* data() const { return static_cast<const char*>( m_data ); }
+  std::size_t size() const { return m_size; }
+
+ private:
+  void unmap() {
+    if ( m_data ) {
+      ::munmap( m_data, m_size );
+      m_data = nullptr;
+      m_size = 0;
+    }
+  }
+};
+}  // namespace common
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace common {
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. Each side keeps a cached copy of the other side's index so it only
+// touches the shared cache line when the ring looks full ( or empty ).
+template <typename T>
+struct SpscRing {
+ private:
+  static constexpr std::size_t cache_line = 64;
+
+  std::vector<T> m_buffer;
+  std::size_t m_mask;
+
+  // Next slot to pop, written by the consumer
+  alignas( cache_line ) std::atomic<std::size_t> m_head{ 0 };
+  std::size_t m_cached_tail = 0;
+
+  // Next slot to push, written by the producer
+  alignas( cache_line ) std::atomic<std::size_t> m_tail{ 0 };
+  std::size_t m_cached_head = 0;
+
+ public:
+  // capacity is rounded up to a power of two
+  SpscRing( std::size_t capacity )
+      : m_buffer( std::bit_ceil( capacity ) ), m_mask( m_buffer.size() - 1 ) {
+    if ( capacity == 0 ) {
+      throw std::invalid_argument( "Ring capacity must be positive" );
+    }
+  }
+
+  SpscRing( const SpscRing& ) = delete;
+  SpscRing& operator=( const SpscRing& ) = delete;
+
+  std::size_t capacity() const { return m_buffer.size(); }
+
+  // Producer only, false if the ring is full. value is only moved from
+  // when it is pushed.
+  template <typename U>
+  bool tryPush( U&& value ) {
+    std::size_t tail = m_tail.load( std::memory_order_relaxed );
+    if ( tail - m_cached_head == m_buffer.size() ) {
+      m_cached_head = m_head.load( std::memory_order_acquire );
+      if ( tail - m_cached_head == m_buffer.size() ) {
+        return false;
+      }
+    }
+    m_buffer[tail & m_mask] = std::forward<U>( value );
+    m_tail.store( tail + 1, std::memory_order_release );
+    return true;
+  }
+
+  // Consumer only, false if the ring is empty
+  bool tryPop( T& value ) {
+    std::size_t head = m_head.load( std::memory_order_relaxed );
+    if ( head == m_cached_tail ) {
+      m_cached_tail = m_tail.load( std::memory_order_acquire );
+      if ( head == m_cached_tail ) {
+        return false;
+      }
+    }
+    value = std::move( m_buffer[head & m_mask] );
+    m_head.store( head + 1, std::memory_order_release );
+    return true;
+  }
+};
+}  // namespace common
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <common/string_utils.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace common {
+
+// Hierarchical set of named statistics such as "cpu.instructions" or
+// "cache.misses". Subsystems register references to the counters they
+// already keep, so incrementing a counter costs nothing extra; values are
+// only read when the registry is dumped. A registry must not outlive the
+// counters registered in it.
+struct StatsRegistry {
+  enum class Format { JSON, CSV };
+
+ private:
+  using Value = std::variant<const std::int64_t*, const std::int32_t*,
+                             std::function<double()>>;
+
+  struct Entry {
+    std::string name;
+    std::string description;
+    Value value;
+  };
+
+  // Keyed by the dot separated parts, which keeps every group contiguous
+  std::map<std::vector<std::string>, Entry> m_entries;
+
+ public:
+  void addCounter( const std::string& name, const std::int64_t& counter,
+                   std::string description = "" ) {
+    add( name, std::move( description ), &counter );
+  }
+
+  void addCounter( const std::string& name, const std::int32_t& counter,
+                   std::string description = "" ) {
+    add( name, std::move( description ), &counter );
+  }
+
+  // Value computed when read, e.g. a rate from two counters
+  void addFormula( const std::string& name, std::function<double()> formula,
+                   std::string description = "" ) {
+    add( name, std::move( description ), std::move( formula ) );
+  }
+
+  std::size_t size() const { return m_entries.size(); }
+
+  bool contains( const std::string& name ) const {
+    return m_entries.contains( split( name ) );
+  }
+
+  double getValue( const std::string& name ) const {
+    auto entry = m_entries.find( split( name ) );
+    if ( entry == m_entries.end() ) {
+      throw std::out_of_range( "Unknown statistic : " + name );
+    }
+    return toDouble( entry->second.value );
+  }
+
+  // Names in dump order
+  std::vector<std::string> getNames() const {
+    std::vector<std::string> names;
+    for ( auto& [parts, entry] : m_entries ) {
+      names.push_back( entry.name );
+    }
+    return names;
+  }
+
+  void write( std::ostream& output, Format format ) const {
+    if ( format == Format::JSON ) {
+      writeJSON( output );
+    } else {
+      writeCSV( output );
+    }
+  }
+
+  // Nested objects following the name hierarchy, on one line if indent is 0
+  void writeJSON( std::ostream& output, std::int32_t indent = 2 ) const {
+    std::string newline = indent > 0 ? "\n" : "";
+    std::string separator = indent > 0 ? ": " : ":";
+    auto pad = [&]( std::size_t depth ) {
+      return std::string( depth * indent, ' ' );
+    };
+
+    std::vector<std::string> open_groups;
+    bool first_in_group = true;
+    output << '{';
+    for ( auto& [parts, entry] : m_entries ) {
+      // Close the groups this entry is not in
+      std::size_t common = 0;
+      while ( common < open_groups.size() && common + 1 < parts.size() &&
+              open_groups[common] == parts[common] ) {
+        common++;
+      }
+      while ( open_groups.size() > common ) {
+        open_groups.pop_back();
+        output << newline << pad( open_groups.size() + 1 ) << '}';
+        first_in_group = false;
+      }
+      // Open the groups it is in
+      while ( open_groups.size() + 1 < parts.size() ) {
+        output << ( first_in_group ? "" : "," ) << newline
+               << pad( open_groups.size() + 1 ) << '"'
+               << parts[open_groups.size()] << '"' << separator << '{';
+        open_groups.push_back( parts[open_groups.size()] );
+        first_in_group = true;
+      }
+      output << ( first_in_group ? "" : "," ) << newline
+             << pad( open_groups.size() + 1 ) << '"' << parts.back() << '"'
+             << separator << formatValue( entry.value );
+      first_in_group = false;
+    }
+    while ( !open_groups.empty() ) {
+      open_groups.pop_back();
+      output << newline << pad( open_groups.size() + 1 ) << '}';
+    }
+    output << newline << "}\n";
+  }
+
+  // One "name,value,description" row per statistic
+  void writeCSV( std::ostream& output ) const {
+    output << "name,value,description\n";
+    for ( auto& [parts, entry] : m_entries ) {
+      output << entry.name << ',' << formatValue( entry.value ) << ','
+             << quoteCSV( entry.description ) << '\n';
+    }
+  }
+
+ private:
+  void add( const std::string& name, std::string description, Value value ) {
+    std::vector<std::string> parts = split( name );
+    for ( auto& part : parts ) {
+      for ( char c : part ) {
+        if ( !( ( c >= 'a' && c <= 'z' ) || ( c >= '0' && c <= '9' ) ||
+                c == '_' ) ) {
+          throw std::invalid_argument( "Invalid statistic name : " + name );
+        }
+      }
+    }
+    // A name can not be both a statistic and a group of statistics
+    for ( auto& [other_parts, entry] : m_entries ) {
+      std::size_t shorter = std::min( parts.size(), other_parts.size() );
+      if ( std::equal( parts.begin(), parts.begin() + shorter,
+                       other_parts.begin() ) ) {
+        throw std::invalid_argument( "Statistic " + name + " clashes with " +
+                                     entry.name );
+      }
+    }
+    m_entries.emplace( std::move( parts ),
+                       Entry{ name, std::move( description ),
+                              std::move( value ) } );
+  }
+
+  static std::vector<std::string> split( std::string_view name ) {
+    std::vector<std::string> parts;
+    std::size_t start = 0;
+    while ( true ) {
+      std::size_t end = name.find( '.', start );
+      parts.emplace_back( name.substr( start, end - start ) );
+      if ( parts.back().empty() ) {
+        throw std::invalid_argument( "Invalid statistic name : " +
+                                     std::string( name ) );
+      }
+      if ( end == std::string_view::npos ) {
+        return parts;
+      }
+      start = end + 1;
+    }
+  }
+
+  static double toDouble( const Value& value ) {
+    if ( auto counter = std::get_if<const std::int64_t*>( &value ) ) {
+      return **counter;
+    }
+    if ( auto counter = std::get_if<const std::int32_t*>( &value ) ) {
+      return **counter;
+    }
+    return std::get<std::function<double()>>( value )();
+  }
+
+  static std::string formatValue( const Value& value ) {
+    if ( auto counter = std::get_if<const std::int64_t*>( &value ) ) {
+      return fmt::format( "{}", **counter );
+    }
+    if ( auto counter = std::get_if<const std::int32_t*>( &value ) ) {
+      return fmt::format( "{}", **counter );
+    }
+    double result = std::get<std::function<double()>>( value )();
+    // JSON has no NaN or infinity
+    return result == result && result - result == 0
+               ? fmt::format( "{}", result )
+               : "null";
+  }
+};
+}  // namespace common
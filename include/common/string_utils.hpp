@@ -0,0 +1,56 @@
+#pragma once
+
+#include <fmt/core.h>
+
+#include <string>
+#include <string_view>
+
+namespace common {
+
+// str without leading and trailing blanks
+inline std::string_view trim( std::string_view str ) {
+  auto first = str.find_first_not_of( " \t\r" );
+  if ( first == std::string_view::npos ) {
+    return {};
+  }
+  auto last = str.find_last_not_of( " \t\r" );
+  return str.substr( first, last - first + 1 );
+}
+
+// CSV field holding value, only quoted if it has to be
+inline std::string quoteCSV( std::string_view value ) {
+  if ( value.find_first_of( ",\"\n" ) == std::string_view::npos ) {
+    return std::string( value );
+  }
+  std::string quoted = "\"";
+  for ( char c : value ) {
+    quoted += c;
+    if ( c == '"' ) {
+      quoted += '"';
+    }
+  }
+  return quoted + "\"";
+}
+
+// JSON string holding value, JSON allows no raw control characters
+inline std::string quoteJSON( std::string_view value ) {
+  std::string quoted = "\"";
+  for ( char c : value ) {
+    if ( c == '"' || c == '\\' ) {
+      quoted += '\\';
+      quoted += c;
+    } else if ( c == '\n' ) {
+      quoted += "\\n";
+    } else if ( c == '\r' ) {
+      quoted += "\\r";
+    } else if ( c == '\t' ) {
+      quoted += "\\t";
+    } else if ( static_cast<unsigned char>( c ) < 0x20 ) {
+      quoted += fmt::format( "\\u{:04x}", static_cast<unsigned char>( c ) );
+    } else {
+      quoted += c;
+    }
+  }
+  return quoted + "\"";
+}
+}  // namespace common
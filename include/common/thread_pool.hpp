@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <semaphore>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace common {
+
+// Fixed size pool of worker threads with one task queue per worker. Tasks
+// submitted from outside the pool are spread round robin, tasks submitted by
+// a task go to its own worker's queue. A worker runs its own queue newest
+// first and steals the oldest task of another queue when it runs dry, so
+// uneven task lengths do not leave workers idle.
+struct ThreadPool {
+ private:
+  struct WorkQueue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  std::vector<std::unique_ptr<WorkQueue>> m_queues;
+  std::vector<std::thread> m_workers;
+  // One count per queued task, plus one per worker when stopping
+  std::counting_semaphore<> m_task_available{ 0 };
+  std::atomic<std::size_t> m_num_queued{ 0 };
+  std::atomic<std::size_t> m_next_queue{ 0 };
+  std::atomic<bool> m_stopping{ false };
+
+  // Index of the worker running on this thread, for the pool it belongs to
+  static inline thread_local const ThreadPool* t_current_pool = nullptr;
+  static inline thread_local std::size_t t_worker_index = 0;
+
+ public:
+  // num_threads = 0 uses one worker per hardware thread
+  ThreadPool( std::int32_t num_threads = 0 ) {
+    if ( num_threads <= 0 ) {
+      num_threads = defaultThreadCount();
+    }
+    for ( auto i = 0; i < num_threads; i++ ) {
+      m_queues.push_back( std::make_unique<WorkQueue>() );
+    }
+    m_workers.reserve( num_threads );
+    for ( auto i = 0; i < num_threads; i++ ) {
+      m_workers.emplace_back( [this, i]() { workerLoop( i ); } );
+    }
+  }
+
+  ThreadPool( const ThreadPool& ) = delete;
+  ThreadPool& operator=( const ThreadPool& ) = delete;
+
+  // Runs the tasks that are still queued before joining
+  ~ThreadPool() {
+    m_stopping = true;
+    m_task_available.release( m_workers.size() );
+    for ( auto& worker : m_workers ) {
+      worker.join();
+    }
+  }
+
+  static std::int32_t defaultThreadCount() {
+    return std::max<std::int32_t>( 1, std::thread::hardware_concurrency() );
+  }
+
+  std::int32_t size() const { return m_workers.size(); }
+
+  template <typename Func>
+  auto submit( Func&& func ) -> std::future<std::invoke_result_t<Func>> {
+    using Result = std::invoke_result_t<Func>;
+    auto task = std::make_shared<std::packaged_task<Result()>>(
+        std::forward<Func>( func ) );
+    std::future<Result> result = task->get_future();
+
+    std::size_t queue_index = t_current_pool == this
+                                  ? t_worker_index
+                                  : m_next_queue++ % m_queues.size();
+    WorkQueue& queue = *m_queues[queue_index];
+    m_num_queued++;
+    {
+      std::lock_guard<std::mutex> lock( queue.mutex );
+      queue.tasks.emplace_back( [task]() { ( *task )(); } );
+    }
+    m_task_available.release();
+    return result;
+  }
+
+  // Runs func( i ) for every i in [0, count) and waits for all of them.
+  // The first exception thrown by a task is rethrown here.
+  template <typename Func>
+  void parallelFor( std::size_t count, Func&& func ) {
+    std::vector<std::future<void>> results;
+    results.reserve( count );
+    for ( std::size_t i = 0; i < count; i++ ) {
+      results.push_back( submit( [&func, i]() { func( i ); } ) );
+    }
+    for ( auto& result : results ) {
+      result.wait();
+    }
+    for ( auto& result : results ) {
+      result.get();
+    }
+  }
+
+ private:
+  // Own queue from the back, other queues from the front
+  bool popTask( std::size_t worker_index, std::function<void()>& task ) {
+    for ( std::size_t i = 0; i < m_queues.size(); i++ ) {
+      WorkQueue& queue = *m_queues[( worker_index + i ) % m_queues.size()];
+      std::lock_guard<std::mutex> lock( queue.mutex );
+      if ( queue.tasks.empty() ) {
+        continue;
+      }
+      if ( i == 0 ) {
+        task = std::move( queue.tasks.back() );
+        queue.tasks.pop_back();
+      } else {
+        task = std::move( queue.tasks.front() );
+        queue.tasks.pop_front();
+      }
+      m_num_queued--;
+      return true;
+    }
+    return false;
+  }
+
+  void workerLoop( std::size_t worker_index ) {
+    t_current_pool = this;
+    t_worker_index = worker_index;
+    while ( true ) {
+      m_task_available.acquire();
+      std::function<void()> task;
+      // A count guarantees a queued task, but another worker may grab it
+      // first and leave ours in a queue we already looked at
+      while ( !popTask( worker_index, task ) ) {
+        if ( m_stopping && m_num_queued == 0 ) {
+          return;  // Stopping and nothing left to run
+        }
+        std::this_thread::yield();
+      }
+      task();
+    }
+  }
+};
+}  // namespace common
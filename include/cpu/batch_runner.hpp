@@ -0,0 +1,345 @@
+#pragma once
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <common/string_utils.hpp>
+#include <common/thread_pool.hpp>
+#include <cpu/simulator.hpp>
+#include <cpu/timing_config.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <memory/common_enums.hpp>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace cpu {
+
+// One simulated machine configuration
+struct SweepPoint {
+  std::int32_t main_memory_size = 1024;
+  std::int32_t cache_size = 64;
+  std::int32_t block_size = 8;
+  memory::CacheWritePolicy write_policy = memory::CacheWritePolicy::WRITEBACK;
+  memory::CacheReplacementPolicy replacement_policy =
+      memory::CacheReplacementPolicy::FIFO;
+  TimingConfig timing;
+};
+
+// Cartesian product of configuration values. Every parameter has a single
+// default value unless it is given a list.
+struct SweepSpace {
+  std::vector<std::int32_t> main_memory_sizes{ 1024 };
+  std::vector<std::int32_t> cache_sizes{ 64 };
+  std::vector<std::int32_t> block_sizes{ 8 };
+  std::vector<memory::CacheWritePolicy> write_policies{
+      memory::CacheWritePolicy::WRITEBACK };
+  std::vector<memory::CacheReplacementPolicy> replacement_policies{
+      memory::CacheReplacementPolicy::FIFO };
+  // Swept TimingConfig parameters, the others keep their default
+  std::vector<std::pair<std::string, std::vector<std::int32_t>>> timing_values;
+
+  // Reads "key = value, value, ..." lines, '#' starts a comment. Keys are
+  // main_memory_size, cache_size, block_size, write_policy,
+  // replacement_policy and the TimingConfig parameter names.
+  static SweepSpace fromFile( const std::string& filename ) {
+    std::ifstream file( filename );
+    if ( !file ) {
+      throw std::runtime_error( "Unable to open sweep file : " + filename );
+    }
+    SweepSpace space;
+    std::string line;
+    std::int32_t line_number = 0;
+    while ( std::getline( file, line ) ) {
+      line_number++;
+      try {
+        space.parseLine( line );
+      } catch ( const std::invalid_argument& e ) {
+        throw std::invalid_argument( filename + ":" +
+                                     std::to_string( line_number ) + " : " +
+                                     e.what() );
+      }
+    }
+    return space;
+  }
+
+  void set( std::string_view key, const std::vector<std::string>& values ) {
+    if ( values.empty() ) {
+      throw std::invalid_argument( "No values for " + std::string( key ) );
+    }
+    if ( key == "main_memory_size" ) {
+      main_memory_sizes = parseIntegers( values );
+    } else if ( key == "cache_size" ) {
+      cache_sizes = parseIntegers( values );
+    } else if ( key == "block_size" ) {
+      block_sizes = parseIntegers( values );
+    } else if ( key == "write_policy" ) {
+      write_policies.clear();
+      for ( auto& value : values ) {
+        write_policies.push_back( memory::parseWritePolicy( value ) );
+      }
+    } else if ( key == "replacement_policy" ) {
+      replacement_policies.clear();
+      for ( auto& value : values ) {
+        replacement_policies.push_back(
+            memory::parseReplacementPolicy( value ) );
+      }
+    } else {
+      TimingConfig().get( key );  // Throws for unknown keys
+      std::erase_if( timing_values,
+                     [key]( auto& param ) { return param.first == key; } );
+      timing_values.emplace_back( key, parseIntegers( values ) );
+    }
+  }
+
+  std::size_t size() const {
+    std::size_t num_points = main_memory_sizes.size() * cache_sizes.size() *
+                             block_sizes.size() * write_policies.size() *
+                             replacement_policies.size();
+    for ( auto& [name, values] : timing_values ) {
+      num_points *= values.size();
+    }
+    return num_points;
+  }
+
+  // Point i of the product, the last parameter varies fastest
+  SweepPoint getPoint( std::size_t index ) const {
+    SweepPoint point;
+    for ( auto param = timing_values.rbegin(); param != timing_values.rend();
+          param++ ) {
+      point.timing.set( param->first, pick( param->second, index ) );
+    }
+    point.replacement_policy = pick( replacement_policies, index );
+    point.write_policy = pick( write_policies, index );
+    point.block_size = pick( block_sizes, index );
+    point.cache_size = pick( cache_sizes, index );
+    point.main_memory_size = pick( main_memory_sizes, index );
+    return point;
+  }
+
+  std::vector<SweepPoint> getPoints() const {
+    std::vector<SweepPoint> points;
+    points.reserve( size() );
+    for ( std::size_t i = 0; i < size(); i++ ) {
+      points.push_back( getPoint( i ) );
+    }
+    return points;
+  }
+
+ private:
+  template <typename T>
+  static T pick( const std::vector<T>& values, std::size_t& index ) {
+    T value = values[index % values.size()];
+    index /= values.size();
+    return value;
+  }
+
+  static std::vector<std::int32_t> parseIntegers(
+      const std::vector<std::string>& values ) {
+    std::vector<std::int32_t> integers;
+    for ( auto& value : values ) {
+      std::size_t end = 0;
+      std::int32_t integer = 0;
+      try {
+        integer = std::stoi( value, &end );
+      } catch ( const std::exception& ) {
+        end = 0;
+      }
+      if ( end == 0 || end != value.size() ) {
+        throw std::invalid_argument( "Invalid value : " + value );
+      }
+      integers.push_back( integer );
+    }
+    return integers;
+  }
+
+  void parseLine( std::string_view line ) {
+    line = common::trim( line.substr( 0, line.find( '#' ) ) );
+    if ( line.empty() ) {
+      return;
+    }
+    auto equal_pos = line.find( '=' );
+    if ( equal_pos == std::string_view::npos ) {
+      throw std::invalid_argument( "Expected key = value, ..." );
+    }
+    std::string_view key = common::trim( line.substr( 0, equal_pos ) );
+    std::string_view remaining = line.substr( equal_pos + 1 );
+    std::vector<std::string> values;
+    while ( true ) {
+      auto comma_pos = remaining.find( ',' );
+      values.emplace_back( common::trim( remaining.substr( 0, comma_pos ) ) );
+      if ( comma_pos == std::string_view::npos ) {
+        break;
+      }
+      remaining.remove_prefix( comma_pos + 1 );
+    }
+    set( key, values );
+  }
+};
+
+// Assembled program, binary as loaded by CPU::runProgram
+struct BatchProgram {
+  std::string name;
+  std::string binary;
+};
+
+struct RunResult {
+  std::size_t run_id = 0;  // program index * num points + point index
+  std::string_view program_name;
+  SweepPoint point;
+  std::int64_t instructions = 0;
+  std::int64_t cycles = 0;
+  std::int64_t cache_hits = 0;
+  std::int64_t cache_misses = 0;
+  std::string error;  // Empty when the run completed
+
+  double getCPI() const {
+    return instructions == 0 ? 0 : double( cycles ) / instructions;
+  }
+};
+
+// Writes one row per run as CSV or as JSON lines. write() may be called from
+// several threads, rows are never interleaved.
+struct ResultWriter {
+  enum Format { CSV, JSON };
+
+ private:
+  std::ostream& m_output;
+  Format m_format;
+  std::mutex m_mutex;
+
+ public:
+  ResultWriter( std::ostream& output, Format format = Format::CSV )
+      : m_output( output ), m_format( format ) {}
+
+  // CSV column names, nothing for JSON
+  void writeHeader() {
+    if ( m_format != Format::CSV ) {
+      return;
+    }
+    std::string header =
+        "run,program,main_memory_size,cache_size,block_size,write_policy,"
+        "replacement_policy";
+    for ( auto name : TimingConfig::getParameterNames() ) {
+      header += ",";
+      header += name;
+    }
+    header += ",instructions,cycles,cpi,cache_hits,cache_misses,error\n";
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_output << header << std::flush;
+  }
+
+  void write( const RunResult& result ) {
+    std::string row =
+        m_format == Format::CSV ? formatCSV( result ) : formatJSON( result );
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_output << row << std::flush;
+  }
+
+ private:
+  static std::string formatCSV( const RunResult& result ) {
+    const SweepPoint& point = result.point;
+    std::string row = fmt::format(
+        "{},{},{},{},{},{},{}", result.run_id,
+        common::quoteCSV( result.program_name ), point.main_memory_size,
+        point.cache_size, point.block_size, toString( point.write_policy ),
+        toString( point.replacement_policy ) );
+    for ( auto name : TimingConfig::getParameterNames() ) {
+      row += fmt::format( ",{}", point.timing.get( name ) );
+    }
+    row += fmt::format( ",{},{},{:.4f},{},{},{}\n", result.instructions,
+                        result.cycles, result.getCPI(), result.cache_hits,
+                        result.cache_misses, common::quoteCSV( result.error ) );
+    return row;
+  }
+
+  static std::string formatJSON( const RunResult& result ) {
+    const SweepPoint& point = result.point;
+    std::string row = fmt::format(
+        "{{\"run\":{},\"program\":{},\"main_memory_size\":{},"
+        "\"cache_size\":{},\"block_size\":{},\"write_policy\":\"{}\","
+        "\"replacement_policy\":\"{}\"",
+        result.run_id, common::quoteJSON( result.program_name ),
+        point.main_memory_size, point.cache_size, point.block_size,
+        toString( point.write_policy ), toString( point.replacement_policy ) );
+    for ( auto name : TimingConfig::getParameterNames() ) {
+      row += fmt::format( ",\"{}\":{}", name, point.timing.get( name ) );
+    }
+    row += fmt::format(
+        ",\"instructions\":{},\"cycles\":{},\"cpi\":{:.4f},"
+        "\"cache_hits\":{},\"cache_misses\":{},\"error\":{}}}\n",
+        result.instructions, result.cycles, result.getCPI(), result.cache_hits,
+        result.cache_misses, common::quoteJSON( result.error ) );
+    return row;
+  }
+};
+
+// Runs every program on every sweep point, each run on its own CPU. Runs are
+// independent, so they are spread over a work stealing thread pool and rows
+// are written as runs finish ( use the run column to restore the order ).
+struct BatchRunner {
+ private:
+  std::int32_t m_num_threads;
+
+ public:
+  // num_threads = 0 uses one thread per hardware thread
+  BatchRunner( std::int32_t num_threads = 0 )
+      : m_num_threads( num_threads > 0
+                           ? num_threads
+                           : common::ThreadPool::defaultThreadCount() ) {}
+
+  // Returns the number of runs that failed
+  std::size_t run( const std::vector<BatchProgram>& programs,
+                   const std::vector<SweepPoint>& points,
+                   ResultWriter& writer ) {
+    std::size_t num_runs = programs.size() * points.size();
+    std::vector<char> failed( num_runs, 0 );
+
+    common::ThreadPool pool( std::min<std::size_t>( m_num_threads,
+                                                    std::max<std::size_t>(
+                                                        num_runs, 1 ) ) );
+    pool.parallelFor( num_runs, [&]( std::size_t run_id ) {
+      RunResult result = runOne( programs[run_id / points.size()],
+                                 points[run_id % points.size()] );
+      result.run_id = run_id;
+      failed[run_id] = !result.error.empty();
+      writer.write( result );
+    } );
+
+    std::size_t num_failed = 0;
+    for ( char run_failed : failed ) {
+      num_failed += run_failed;
+    }
+    return num_failed;
+  }
+
+  // Simulates program on a fresh CPU, errors are reported in the result
+  static RunResult runOne( const BatchProgram& program,
+                           const SweepPoint& point ) {
+    RunResult result;
+    result.program_name = program.name;
+    result.point = point;
+    try {
+      CPU cpu( point.main_memory_size, point.cache_size, point.block_size,
+               point.write_policy, point.replacement_policy, point.timing );
+      cpu.runProgram( program.binary );
+
+      State& state = cpu.getSystemState();
+      result.instructions = state.instr_stats.instructions;
+      result.cycles = state.instr_stats.cycles;
+      result.cache_hits = state.cache_hits;
+      result.cache_misses = state.cache_miss;
+    } catch ( const std::exception& e ) {
+      result.error = e.what();
+    }
+    return result;
+  }
+};
+}  // namespace cpu
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <algorithm>
+#include <cpu/simulator.hpp>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cpu {
+// Instructions executed per basic block during one interval, as
+// ( block id, count ) pairs sorted by block id
+struct BasicBlockVector {
+  std::vector<std::pair<std::int32_t, std::int64_t>> counts;
+
+  std::int64_t getTotal() const {
+    std::int64_t total = 0;
+    for ( auto& [block, count] : counts ) {
+      total += count;
+    }
+    return total;
+  }
+};
+
+// Records a basic block vector for every interval_length instructions. A
+// basic block starts at the program entry and at the target of every
+// control transfer, and is identified by the order it was first reached in.
+struct BbvProfiler {
+ private:
+  std::int64_t m_interval_length;
+  std::unordered_map<std::int32_t, std::int32_t> m_block_ids;  // By address
+  std::vector<std::int32_t> m_block_addresses;                 // By id
+  std::vector<BasicBlockVector> m_intervals;
+
+ public:
+  BbvProfiler( std::int64_t interval_length )
+      : m_interval_length( interval_length ) {
+    if ( interval_length <= 0 ) {
+      throw std::invalid_argument( "Interval length must be positive" );
+    }
+  }
+
+  // Runs cpu functionally until it halts ( nothing is timed and the cache
+  // is left alone ), the last interval may be shorter
+  void profile( CPU& cpu ) {
+    State& state = cpu.getSystemState();
+    std::unordered_map<std::int32_t, std::int64_t> current;
+    std::int64_t num_in_interval = 0;
+    std::int32_t block = getBlockId( state.PC );
+    while ( !cpu.isHalted() ) {
+      std::int32_t next_sequential_pc = state.PC + 4;
+      cpu.fastForward( 1, false );
+      current[block]++;
+      if ( state.PC != next_sequential_pc ) {
+        block = getBlockId( state.PC );
+      }
+      if ( ++num_in_interval == m_interval_length ) {
+        addInterval( current );
+        num_in_interval = 0;
+      }
+    }
+    if ( num_in_interval != 0 ) {
+      addInterval( current );
+    }
+  }
+
+  std::int64_t getIntervalLength() const { return m_interval_length; }
+
+  const std::vector<BasicBlockVector>& getIntervals() const {
+    return m_intervals;
+  }
+
+  std::int32_t getNumBlocks() const { return m_block_addresses.size(); }
+
+  std::int32_t getBlockAddress( std::int32_t block ) const {
+    return m_block_addresses.at( block );
+  }
+
+  // SimPoint .bb format, one "T:id:count :id:count ..." line per interval
+  // with ids starting at 1
+  static void write( std::ostream& output,
+                     const std::vector<BasicBlockVector>& intervals ) {
+    for ( auto& interval : intervals ) {
+      output << 'T';
+      for ( auto& [block, count] : interval.counts ) {
+        output << ':' << block + 1 << ':' << count << ' ';
+      }
+      output << '\n';
+    }
+  }
+
+  static std::vector<BasicBlockVector> read( std::istream& input ) {
+    std::vector<BasicBlockVector> intervals;
+    std::string line;
+    while ( std::getline( input, line ) ) {
+      if ( line.empty() || line[0] != 'T' ) {
+        continue;  // Comments and blank lines
+      }
+      BasicBlockVector& interval = intervals.emplace_back();
+      std::istringstream fields( line.substr( 1 ) );
+      std::string field;
+      while ( fields >> field ) {
+        std::int64_t block = 0;
+        std::int64_t count = 0;
+        char separator = 0;
+        std::istringstream parts( field );
+        if ( !( parts >> separator >> block ) || separator != ':' ||
+             !( parts >> separator >> count ) || separator != ':' ||
+             block < 1 || count < 0 ) {
+          throw std::invalid_argument( "Invalid basic block vector entry : " +
+                                       field );
+        }
+        interval.counts.emplace_back( block - 1, count );
+      }
+      std::sort( interval.counts.begin(), interval.counts.end() );
+    }
+    return intervals;
+  }
+
+ private:
+  std::int32_t getBlockId( std::int32_t address ) {
+    auto [it, inserted] =
+        m_block_ids.try_emplace( address, m_block_addresses.size() );
+    if ( inserted ) {
+      m_block_addresses.push_back( address );
+    }
+    return it->second;
+  }
+
+  void addInterval( std::unordered_map<std::int32_t, std::int64_t>& current ) {
+    BasicBlockVector& interval = m_intervals.emplace_back();
+    interval.counts.assign( current.begin(), current.end() );
+    std::sort( interval.counts.begin(), interval.counts.end() );
+    current.clear();
+  }
+};
+}  // namespace cpu
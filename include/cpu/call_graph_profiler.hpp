@@ -0,0 +1,229 @@
+#pragma once
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cpu/run_observer.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <isa/encoding.hpp>
+#include <isa/isa_table.hpp>
+#include <map>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cpu {
+struct FunctionProfile {
+  std::int32_t address = 0;
+  std::string name;
+  std::int64_t calls = 0;
+  std::int64_t instructions = 0;  // Exclusive
+  std::int64_t inclusive_cycles = 0;
+  std::int64_t exclusive_cycles = 0;
+  std::int64_t inclusive_misses = 0;
+  std::int64_t exclusive_misses = 0;
+};
+
+// Attributes cycles and cache misses to functions through a shadow call
+// stack. A jal or jalr that writes a link register calls its target, a
+// jalr to the return address of a frame on the stack returns from it and
+// the frames above. Anything else, including a jump with link register r0,
+// stays in the current function. The program entry is the root function.
+//
+// Exclusive counts go to the function on top of the stack. Inclusive
+// counts are added when the outermost activation of a function returns,
+// so recursion is not counted twice. Every distinct stack also keeps its
+// exclusive counts for the folded stack output of flame graphs.
+struct CallGraphProfiler : RunObserver {
+  enum Metric { CYCLES, MISSES };
+
+ private:
+  struct Frame {
+    std::int32_t function;
+    std::int32_t return_address;
+    std::int32_t node;
+    std::int64_t cycles;  // Totals on entry
+    std::int64_t misses;
+  };
+
+  struct Node {
+    std::int32_t parent;  // -1 for the root
+    std::int32_t function;
+    std::int64_t cycles = 0;
+    std::int64_t misses = 0;
+  };
+
+  std::map<std::int32_t, std::string> m_symbols;
+  std::unordered_map<std::int32_t, FunctionProfile> m_functions;
+  std::unordered_map<std::int32_t, std::int32_t> m_active;  // Activations
+  std::vector<Frame> m_stack;
+  std::vector<Node> m_nodes;
+  std::unordered_map<std::uint64_t, std::int32_t> m_node_ids;
+  std::int64_t m_cycles = 0;
+  std::int64_t m_misses = 0;
+
+ public:
+  // symbols names functions by address, others are named by their address
+  CallGraphProfiler( std::map<std::int32_t, std::string> symbols = {} )
+      : m_symbols( std::move( symbols ) ) {}
+
+  bool isStarted() const { return !m_stack.empty(); }
+
+  // Enters the root function, done by the first record otherwise
+  void start( std::int32_t entry_pc ) { call( entry_pc, -1 ); }
+
+  // Adds an executed instruction, word being its encoding and next_pc the
+  // PC after it
+  void record( std::int32_t pc, std::uint32_t word, std::int32_t next_pc,
+               std::int64_t cycles, std::int64_t misses ) {
+    if ( !isStarted() ) {
+      start( pc );
+    }
+    Frame& top = m_stack.back();
+    FunctionProfile& function = m_functions[top.function];
+    function.instructions++;
+    function.exclusive_cycles += cycles;
+    function.exclusive_misses += misses;
+    m_nodes[top.node].cycles += cycles;
+    m_nodes[top.node].misses += misses;
+    m_cycles += cycles;
+    m_misses += misses;
+
+    std::uint32_t opcode = isa::Encoding::opcode( word );
+    if ( opcode != isa::IsaTable::op_jal && opcode != isa::IsaTable::op_jalr ) {
+      return;
+    }
+    if ( opcode == isa::IsaTable::op_jalr && returnTo( next_pc ) ) {
+      return;
+    }
+    if ( isa::Encoding::rd( word ) != 0 ) {
+      call( next_pc, pc + 4 );
+    }
+  }
+
+  void retire( const State&, const InstructionEvent& instruction ) override {
+    record( instruction.trace.pc, instruction.trace.word, instruction.next_pc,
+            instruction.cycles, instruction.cache_misses );
+  }
+
+  std::int32_t getDepth() const { return m_stack.size(); }
+
+  // Functions by inclusive cycles, highest first, including the counts of
+  // the functions still on the stack
+  std::vector<FunctionProfile> getFunctions() const {
+    std::unordered_map<std::int32_t, FunctionProfile> functions = m_functions;
+    std::unordered_map<std::int32_t, std::int32_t> seen;
+    for ( auto& frame : m_stack ) {
+      if ( seen[frame.function]++ == 0 ) {
+        FunctionProfile& function = functions[frame.function];
+        function.inclusive_cycles += m_cycles - frame.cycles;
+        function.inclusive_misses += m_misses - frame.misses;
+      }
+    }
+    std::vector<FunctionProfile> result;
+    for ( auto& [address, function] : functions ) {
+      result.push_back( function );
+    }
+    std::sort( result.begin(), result.end(), []( auto& a, auto& b ) {
+      return a.inclusive_cycles != b.inclusive_cycles
+                 ? a.inclusive_cycles > b.inclusive_cycles
+                 : a.address < b.address;
+    } );
+    return result;
+  }
+
+  // One "root;caller;callee count" line per stack with a non zero count
+  void writeFolded( std::ostream& out, Metric metric = CYCLES ) const {
+    std::vector<std::pair<std::string, std::int64_t>> stacks;
+    for ( std::size_t i = 0; i < m_nodes.size(); i++ ) {
+      const Node& node = m_nodes[i];
+      std::int64_t count = metric == CYCLES ? node.cycles : node.misses;
+      if ( count != 0 ) {
+        stacks.emplace_back( getStackName( i ), count );
+      }
+    }
+    std::sort( stacks.begin(), stacks.end() );
+    for ( auto& [stack, count] : stacks ) {
+      out << stack << ' ' << count << '\n';
+    }
+  }
+
+  void writeReport( std::ostream& out ) const {
+    out << fmt::format( "{:>12} {:>12} {:>12} {:>10} {:>10} {:>8}  {}\n",
+                        "incl cycles", "excl cycles", "instructions",
+                        "incl miss", "excl miss", "calls", "function" );
+    for ( auto& function : getFunctions() ) {
+      out << fmt::format( "{:>12} {:>12} {:>12} {:>10} {:>10} {:>8}  {}\n",
+                          function.inclusive_cycles, function.exclusive_cycles,
+                          function.instructions, function.inclusive_misses,
+                          function.exclusive_misses, function.calls,
+                          function.name );
+    }
+  }
+
+  std::string getName( std::int32_t address ) const {
+    auto symbol = m_symbols.find( address );
+    return symbol != m_symbols.end() ? symbol->second
+                                     : fmt::format( "{:#x}", address );
+  }
+
+ private:
+  void call( std::int32_t function, std::int32_t return_address ) {
+    std::int32_t parent = m_stack.empty() ? -1 : m_stack.back().node;
+    std::uint64_t key =
+        std::uint64_t( std::uint32_t( parent + 1 ) ) << 32 |
+        std::uint32_t( function );
+    auto [node, inserted] = m_node_ids.try_emplace( key, m_nodes.size() );
+    if ( inserted ) {
+      m_nodes.push_back( Node{ parent, function } );
+    }
+    m_stack.push_back(
+        Frame{ function, return_address, node->second, m_cycles, m_misses } );
+
+    FunctionProfile& profile = m_functions[function];
+    if ( profile.calls++ == 0 ) {
+      profile.address = function;
+      profile.name = getName( function );
+    }
+    m_active[function]++;
+  }
+
+  // Pops up to the innermost frame returning to target, false if there is
+  // none
+  bool returnTo( std::int32_t target ) {
+    std::size_t depth = m_stack.size();
+    while ( depth > 1 && m_stack[depth - 1].return_address != target ) {
+      depth--;
+    }
+    if ( depth <= 1 ) {
+      return false;
+    }
+    while ( m_stack.size() >= depth ) {
+      Frame& frame = m_stack.back();
+      if ( --m_active[frame.function] == 0 ) {
+        FunctionProfile& function = m_functions[frame.function];
+        function.inclusive_cycles += m_cycles - frame.cycles;
+        function.inclusive_misses += m_misses - frame.misses;
+      }
+      m_stack.pop_back();
+    }
+    return true;
+  }
+
+  std::string getStackName( std::size_t node ) const {
+    std::vector<std::int32_t> functions;
+    for ( std::int32_t i = node; i >= 0; i = m_nodes[i].parent ) {
+      functions.push_back( m_nodes[i].function );
+    }
+    std::string name;
+    for ( auto function = functions.rbegin(); function != functions.rend();
+          function++ ) {
+      name += ( name.empty() ? "" : ";" ) + getName( *function );
+    }
+    return name;
+  }
+};
+}  // namespace cpu
@@ -0,0 +1,428 @@
+#pragma once
+
+#include <common/mapped_file.hpp>
+#include <cpu/instruction_stats.hpp>
+#include <cpu/state.hpp>
+#include <cpu/timing_config.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <isa/isa_table.hpp>
+#include <list>
+#include <memory/cache.hpp>
+#include <memory/cache_block.hpp>
+#include <memory/common_enums.hpp>
+#include <memory/main_memory.hpp>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cpu {
+// Binary checkpoint of a whole State. Little endian, laid out as
+//   header  : magic "RVSIMCKP", version, page size
+//   config  : memory, cache and timing configuration
+//   cpu     : PC, IR, counters, register file, instruction statistics
+//   memory  : access counts, non zero pages as ( index, size, compressed
+//             bits )
+//   cache   : blocks in FIFO order with dirty flag and entries, LRU order,
+//             eviction counts, random replacement state
+// Bit strings are packed 8 bits per byte and memory pages are additionally
+// run length encoded ( PackBits ). Restoring maps the file and builds the
+// state straight from the mapping.
+struct Checkpoint {
+  static constexpr std::string_view magic = "RVSIMCKP";
+  static constexpr std::uint32_t version = 5;
+
+  static void save( const State& state, const std::string& filename ) {
+    std::string data = serialize( state );
+    std::ofstream file( filename, std::ios::binary | std::ios::trunc );
+    file.write( data.data(), data.size() );
+    if ( !file ) {
+      throw std::runtime_error( "Unable to write checkpoint : " + filename );
+    }
+  }
+
+  static State load( const std::string& filename ) {
+    common::MappedFile file( filename );
+    return deserialize( file.view() );
+  }
+
+  static std::string serialize( const State& state ) {
+    Writer out;
+    out.putBytes( magic );
+    out.putU32( version );
+    out.putU32( memory::MainMemory::page_size );
+
+    // config
+    const memory::MainMemory& main_memory =
+        state.memory_manager.getMainMemoryRef();
+    const memory::CacheMemory& cache = state.memory_manager.getCacheMemoryRef();
+    out.putI32( main_memory.getMemorySize() );
+    out.putI32( cache.getCacheSize() );
+    out.putI32( cache.getBlockSize() );
+    out.putI32( cache.getWritePolicy() );
+    out.putI32( cache.getReplacementPolicy() );
+    auto timing_names = TimingConfig::getParameterNames();
+    out.putU32( timing_names.size() );
+    for ( auto name : timing_names ) {
+      out.putString( name );
+      out.putI32( state.timing.get( name ) );
+    }
+
+    // cpu
+    out.putI32( state.PC );
+    out.putString( state.IR );
+    out.putI32( state.halt_adr );
+    out.putI32( state.total_instructions );
+    out.putI64( state.cycles_consumed );
+    out.putI64( state.cache_hits );
+    out.putI64( state.cache_miss );
+    for ( auto value : state.register_file ) {
+      out.putI32( value );
+    }
+    putStats( out, state.instr_stats );
+
+    // memory, pages that are all zero are left out
+    std::vector<std::int32_t> stored_pages;
+    for ( auto i = 0; i < main_memory.getNumPages(); i++ ) {
+      if ( main_memory.getPageData( i ).find( '1' ) != std::string::npos ) {
+        stored_pages.push_back( i );
+      }
+    }
+    out.putI64( main_memory.getNumReads() );
+    out.putI64( main_memory.getNumWrites() );
+    out.putU32( main_memory.getNumPages() );
+    out.putU32( stored_pages.size() );
+    for ( auto page_index : stored_pages ) {
+      std::string compressed =
+          packBitsEncode( packBinary( main_memory.getPageData( page_index ) ) );
+      out.putU32( page_index );
+      out.putU32( compressed.size() );
+      out.putBytes( compressed );
+    }
+
+    // cache
+    out.putU32( cache.getBlocks().size() );
+    for ( auto& block : cache.getBlocks() ) {
+      out.putU32( block.isDirty() );
+      out.putU32( block.getEntries().size() );
+      for ( auto& [address, value] : block.getEntries() ) {
+        out.putI32( address );
+        out.putBinary( value );
+      }
+    }
+    out.putU32( cache.getLruOrder().size() );
+    for ( auto address : cache.getLruOrder() ) {
+      out.putI32( address );
+    }
+    out.putI64( cache.getNumEvictions() );
+    out.putI64( cache.getNumWritebacks() );
+    out.putU64( cache.getRandomState() );
+    return std::move( out.data );
+  }
+
+  static State deserialize( std::string_view data ) {
+    Reader in( data );
+    if ( in.getBytes( magic.size() ) != magic ) {
+      throw std::runtime_error( "Not a checkpoint" );
+    }
+    if ( std::uint32_t file_version = in.getU32(); file_version != version ) {
+      throw std::runtime_error( "Unsupported checkpoint version " +
+                                std::to_string( file_version ) );
+    }
+    if ( in.getU32() != memory::MainMemory::page_size ) {
+      throw std::runtime_error( "Checkpoint page size does not match" );
+    }
+
+    // config
+    std::int32_t memory_size = in.getI32();
+    std::int32_t cache_size = in.getI32();
+    std::int32_t block_size = in.getI32();
+    auto write_policy = memory::CacheWritePolicy( in.getI32() );
+    auto replacement_policy = memory::CacheReplacementPolicy( in.getI32() );
+    TimingConfig timing;
+    for ( auto i = in.getU32(); i > 0; i-- ) {
+      std::string name = in.getString();
+      timing.set( name, in.getI32() );
+    }
+
+    State state( memory_size, cache_size, block_size, write_policy,
+                 replacement_policy, timing );
+
+    // cpu
+    state.PC = in.getI32();
+    state.IR = in.getString();
+    state.halt_adr = in.getI32();
+    state.total_instructions = in.getI32();
+    state.cycles_consumed = in.getI64();
+    state.cache_hits = in.getI64();
+    state.cache_miss = in.getI64();
+    for ( auto& value : state.register_file ) {
+      value = in.getI32();
+    }
+    getStats( in, state.instr_stats );
+
+    // memory
+    memory::MainMemory& main_memory = state.memory_manager.getMainMemoryRef();
+    std::int64_t num_reads = in.getI64();
+    main_memory.setAccessCounts( num_reads, in.getI64() );
+    if ( std::int32_t( in.getU32() ) != main_memory.getNumPages() ) {
+      throw std::runtime_error( "Checkpoint page count does not match" );
+    }
+    for ( auto i = in.getU32(); i > 0; i-- ) {
+      std::uint32_t page_index = in.getU32();
+      if ( page_index >= std::uint32_t( main_memory.getNumPages() ) ) {
+        throw std::runtime_error( "Checkpoint page out of range" );
+      }
+      std::string_view compressed = in.getBytes( in.getU32() );
+      main_memory.setPageData(
+          page_index, unpackBinary( packBitsDecode( compressed ),
+                                    memory::MainMemory::page_size * 8 ) );
+    }
+
+    // cache
+    std::list<memory::CacheBlock> blocks;
+    for ( auto i = in.getU32(); i > 0; i-- ) {
+      memory::CacheBlock& block = blocks.emplace_back( block_size );
+      block.setDirty( in.getU32() != 0 );
+      for ( auto j = in.getU32(); j > 0; j-- ) {
+        std::int32_t address = in.getI32();
+        block.add_entry( address, in.getBinary() );
+      }
+    }
+    std::deque<std::int32_t> lru_order;
+    for ( auto i = in.getU32(); i > 0; i-- ) {
+      lru_order.push_back( in.getI32() );
+    }
+    memory::CacheMemory& cache = state.memory_manager.getCacheMemoryRef();
+    cache.restoreBlocks( std::move( blocks ), std::move( lru_order ) );
+    std::int64_t num_evictions = in.getI64();
+    cache.setEvictionCounts( num_evictions, in.getI64() );
+    cache.setRandomState( in.getU64() );
+
+    if ( !in.atEnd() ) {
+      throw std::runtime_error( "Trailing data in checkpoint" );
+    }
+    return state;
+  }
+
+ private:
+  struct Writer {
+    std::string data;
+
+    void putBytes( std::string_view bytes ) { data.append( bytes ); }
+    void putU32( std::uint32_t value ) {
+      for ( auto i = 0; i < 4; i++ ) {
+        data.push_back( char( value >> ( 8 * i ) ) );
+      }
+    }
+    void putU64( std::uint64_t value ) {
+      putU32( value );
+      putU32( value >> 32 );
+    }
+    void putI32( std::int32_t value ) { putU32( value ); }
+    void putI64( std::int64_t value ) { putU64( value ); }
+    void putString( std::string_view value ) {
+      putU32( value.size() );
+      putBytes( value );
+    }
+    // String of '0' / '1' as its bit count and the packed bits
+    void putBinary( std::string_view value ) {
+      putU32( value.size() );
+      putBytes( packBinary( value ) );
+    }
+  };
+
+  // Bounds checked reads from the mapped checkpoint
+  struct Reader {
+    std::string_view data;
+    std::size_t position = 0;
+
+    Reader( std::string_view data ) : data( data ) {}
+
+    bool atEnd() const { return position == data.size(); }
+
+    std::string_view getBytes( std::size_t size ) {
+      if ( size > data.size() - position ) {
+        throw std::runtime_error( "Truncated checkpoint" );
+      }
+      std::string_view bytes = data.substr( position, size );
+      position += size;
+      return bytes;
+    }
+    std::uint32_t getU32() {
+      std::string_view bytes = getBytes( 4 );
+      std::uint32_t value = 0;
+      for ( auto i = 0; i < 4; i++ ) {
+        value |= std::uint32_t( std::uint8_t( bytes[i] ) ) << ( 8 * i );
+      }
+      return value;
+    }
+    std::uint64_t getU64() {
+      std::uint64_t low = getU32();
+      return low | ( std::uint64_t( getU32() ) << 32 );
+    }
+    std::int32_t getI32() { return getU32(); }
+    std::int64_t getI64() { return getU64(); }
+    std::string getString() { return std::string( getBytes( getU32() ) ); }
+    std::string getBinary() {
+      std::uint32_t num_bits = getU32();
+      return unpackBinary( getBytes( ( std::size_t( num_bits ) + 7 ) / 8 ),
+                           num_bits );
+    }
+    // Rejects counts that cannot fit in the remaining data before they are
+    // used to reserve memory
+    std::size_t checkCount( std::uint64_t count, std::size_t item_size ) {
+      if ( count > ( data.size() - position ) / item_size ) {
+        throw std::runtime_error( "Truncated checkpoint" );
+      }
+      return count;
+    }
+  };
+
+  // Arrays are written with their length so the ISA table, histogram and
+  // cycle causes can not silently change size between versions
+  static void putStats( Writer& out, const InstructionStats& stats ) {
+    out.putI64( stats.instructions );
+    out.putI64( stats.cycles );
+    out.putU32( stats.opcode_counts.size() );
+    for ( std::size_t i = 0; i < stats.opcode_counts.size(); i++ ) {
+      out.putI64( stats.opcode_counts[i] );
+      out.putI64( stats.opcode_cycles[i] );
+    }
+    out.putU32( stats.latency_histogram.size() );
+    for ( auto count : stats.latency_histogram ) {
+      out.putI64( count );
+    }
+    out.putU32( stats.cause_cycles.size() );
+    for ( auto count : stats.cause_cycles ) {
+      out.putI64( count );
+    }
+    std::vector<InstructionRecord> history = stats.getHistory();
+    out.putU64( stats.getHistoryCapacity() );
+    out.putU64( history.size() );
+    for ( auto& record : history ) {
+      out.putI64( record.index );
+      out.putI32( record.pc );
+      out.putI32( record.instr_id );
+      out.putI64( record.cycles );
+    }
+  }
+
+  static void getStats( Reader& in, InstructionStats& stats ) {
+    stats.instructions = in.getI64();
+    stats.cycles = in.getI64();
+    if ( in.getU32() != stats.opcode_counts.size() ) {
+      throw std::runtime_error( "Checkpoint opcode count does not match" );
+    }
+    for ( std::size_t i = 0; i < stats.opcode_counts.size(); i++ ) {
+      stats.opcode_counts[i] = in.getI64();
+      stats.opcode_cycles[i] = in.getI64();
+    }
+    if ( in.getU32() != stats.latency_histogram.size() ) {
+      throw std::runtime_error( "Checkpoint histogram size does not match" );
+    }
+    for ( auto& count : stats.latency_histogram ) {
+      count = in.getI64();
+    }
+    if ( in.getU32() != stats.cause_cycles.size() ) {
+      throw std::runtime_error( "Checkpoint cycle causes do not match" );
+    }
+    for ( auto& count : stats.cause_cycles ) {
+      count = in.getI64();
+    }
+    std::uint64_t capacity = in.getU64();
+    std::uint64_t history_size = in.checkCount( in.getU64(), 24 );
+    if ( history_size > capacity ) {
+      throw std::runtime_error( "Checkpoint history exceeds its capacity" );
+    }
+    std::vector<InstructionRecord> history( history_size );
+    for ( auto& record : history ) {
+      record.index = in.getI64();
+      record.pc = in.getI32();
+      record.instr_id = in.getI32();
+      if ( record.instr_id < 0 ||
+           record.instr_id >= std::int32_t( isa::IsaTable::size() ) ) {
+        throw std::runtime_error( "Checkpoint instruction id out of range" );
+      }
+      record.cycles = in.getI64();
+    }
+    stats.restoreHistory( capacity, std::move( history ) );
+  }
+
+  // MSB first, the last byte is padded with zeros
+  static std::string packBinary( std::string_view bits ) {
+    std::string packed( ( bits.size() + 7 ) / 8, '\0' );
+    for ( std::size_t i = 0; i < bits.size(); i++ ) {
+      if ( bits[i] == '1' ) {
+        packed[i / 8] |= char( 0x80 >> ( i % 8 ) );
+      } else if ( bits[i] != '0' ) {
+        throw std::invalid_argument( "Memory holds a non binary value" );
+      }
+    }
+    return packed;
+  }
+
+  static std::string unpackBinary( std::string_view packed,
+                                   std::size_t num_bits ) {
+    if ( packed.size() * 8 < num_bits ) {
+      throw std::runtime_error( "Corrupt checkpoint data" );
+    }
+    std::string bits( num_bits, '0' );
+    for ( std::size_t i = 0; i < num_bits; i++ ) {
+      if ( std::uint8_t( packed[i / 8] ) & ( 0x80 >> ( i % 8 ) ) ) {
+        bits[i] = '1';
+      }
+    }
+    return bits;
+  }
+
+  // PackBits: a control byte n < 128 is followed by n + 1 literal bytes,
+  // n > 128 by one byte repeated 257 - n times
+  static std::string packBitsEncode( std::string_view input ) {
+    std::string output;
+    std::size_t i = 0;
+    while ( i < input.size() ) {
+      std::size_t run = 1;
+      while ( i + run < input.size() && run < 128 &&
+              input[i + run] == input[i] ) {
+        run++;
+      }
+      if ( run >= 2 ) {
+        output.push_back( char( 257 - run ) );
+        output.push_back( input[i] );
+        i += run;
+        continue;
+      }
+      // Literals up to the next run of at least 2
+      std::size_t start = i;
+      while ( i < input.size() && i - start < 128 &&
+              !( i + 1 < input.size() && input[i + 1] == input[i] ) ) {
+        i++;
+      }
+      if ( i == start ) {
+        i++;  // Single byte before a run that hit the 128 limit
+      }
+      output.push_back( char( i - start - 1 ) );
+      output.append( input.substr( start, i - start ) );
+    }
+    return output;
+  }
+
+  static std::string packBitsDecode( std::string_view input ) {
+    std::string output;
+    Reader in( input );
+    while ( !in.atEnd() ) {
+      std::uint8_t control = in.getBytes( 1 )[0];
+      if ( control < 128 ) {
+        output.append( in.getBytes( control + 1 ) );
+      } else if ( control > 128 ) {
+        output.append( 257 - control, in.getBytes( 1 )[0] );
+      }
+    }
+    return output;
+  }
+};
+}  // namespace cpu
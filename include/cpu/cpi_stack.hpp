@@ -0,0 +1,160 @@
+#pragma once
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <cpu/cycle_cause.hpp>
+#include <cpu/run_observer.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace cpu {
+// Cycles of a number of instructions split by cause, each cause giving
+// its share of the CPI
+struct CpiStack {
+  static constexpr std::array<std::string_view, num_cycle_causes> names{
+      "base",      "decode",     "fetch",      "fetch_miss",
+      "load",      "load_miss",  "store_miss", "redirect" };
+
+  std::int64_t instructions = 0;
+  CycleBreakdown cycles{};
+
+  void add( const CycleBreakdown& instruction_cycles ) {
+    instructions++;
+    for ( std::size_t i = 0; i < num_cycle_causes; i++ ) {
+      cycles[i] += instruction_cycles[i];
+    }
+  }
+
+  void add( const CpiStack& other ) {
+    instructions += other.instructions;
+    for ( std::size_t i = 0; i < num_cycle_causes; i++ ) {
+      cycles[i] += other.cycles[i];
+    }
+  }
+
+  std::int64_t getCycles() const {
+    std::int64_t total = 0;
+    for ( auto count : cycles ) {
+      total += count;
+    }
+    return total;
+  }
+
+  double getCPI() const {
+    return instructions == 0 ? 0 : getCycles() / double( instructions );
+  }
+
+  double getCPI( CycleCause cause ) const {
+    return instructions == 0 ? 0 : cycles[cause] / double( instructions );
+  }
+
+  bool operator==( const CpiStack& ) const = default;
+};
+
+struct CodeRegion {
+  std::int32_t begin = 0;  // First address
+  std::int32_t end = 0;    // Past the last address
+  std::string name;
+};
+
+// CPI stacks of the whole run and of every code region, e.g. the code
+// between one label and the next. Regions are sorted and must not overlap,
+// instructions outside all of them are only part of the total.
+struct CpiStackProfiler : RunObserver {
+ private:
+  std::vector<CodeRegion> m_regions;
+  std::vector<CpiStack> m_stacks;  // Per region
+  CpiStack m_total;
+
+ public:
+  CpiStackProfiler( std::vector<CodeRegion> regions = {} )
+      : m_regions( std::move( regions ) ), m_stacks( m_regions.size() ) {
+    std::sort( m_regions.begin(), m_regions.end(),
+               []( auto& a, auto& b ) { return a.begin < b.begin; } );
+    for ( std::size_t i = 0; i < m_regions.size(); i++ ) {
+      if ( m_regions[i].end < m_regions[i].begin ||
+           ( i > 0 && m_regions[i].begin < m_regions[i - 1].end ) ) {
+        throw std::invalid_argument( "Code regions must not overlap" );
+      }
+    }
+  }
+
+  // One region from every symbol to the next one or to end_address. Code
+  // before the first symbol is named "[entry]".
+  static CpiStackProfiler fromSymbols(
+      const std::map<std::int32_t, std::string>& symbols,
+      std::int32_t end_address ) {
+    std::vector<CodeRegion> regions;
+    std::int32_t begin = 0;
+    std::string name = "[entry]";
+    for ( auto& [address, symbol] : symbols ) {
+      if ( address >= end_address ) {
+        break;
+      }
+      if ( address > begin ) {
+        regions.push_back( CodeRegion{ begin, address, name } );
+      }
+      begin = address;
+      name = symbol;
+    }
+    if ( end_address > begin ) {
+      regions.push_back( CodeRegion{ begin, end_address, name } );
+    }
+    return CpiStackProfiler( std::move( regions ) );
+  }
+
+  void record( std::int32_t pc, const CycleBreakdown& cycles ) {
+    m_total.add( cycles );
+    auto region = std::upper_bound(
+        m_regions.begin(), m_regions.end(), pc,
+        []( std::int32_t pc, auto& region ) { return pc < region.begin; } );
+    if ( region != m_regions.begin() && pc < ( region - 1 )->end ) {
+      m_stacks[region - m_regions.begin() - 1].add( cycles );
+    }
+  }
+
+  void retire( const State&, const InstructionEvent& instruction ) override {
+    record( instruction.trace.pc, instruction.cycle_causes );
+  }
+
+  const CpiStack& getTotal() const { return m_total; }
+  const std::vector<CodeRegion>& getRegions() const { return m_regions; }
+  const std::vector<CpiStack>& getStacks() const { return m_stacks; }
+
+  // The CPI of every cause per region, regions that never ran left out
+  void write( std::ostream& out ) const {
+    out << fmt::format( "{:<20} {:>12} {:>8}", "region", "instructions",
+                        "cpi" );
+    for ( auto name : CpiStack::names ) {
+      out << fmt::format( " {:>10}", name );
+    }
+    out << '\n';
+    for ( std::size_t i = 0; i < m_regions.size(); i++ ) {
+      if ( m_stacks[i].instructions != 0 ) {
+        writeRow( out, m_regions[i].name, m_stacks[i] );
+      }
+    }
+    writeRow( out, "total", m_total );
+  }
+
+ private:
+  static void writeRow( std::ostream& out, std::string_view name,
+                        const CpiStack& stack ) {
+    out << fmt::format( "{:<20} {:>12} {:>8.3f}", name, stack.instructions,
+                        stack.getCPI() );
+    for ( std::size_t i = 0; i < num_cycle_causes; i++ ) {
+      out << fmt::format( " {:>10.3f}", stack.getCPI( CycleCause( i ) ) );
+    }
+    out << '\n';
+  }
+};
+}  // namespace cpu
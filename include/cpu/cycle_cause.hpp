@@ -0,0 +1,27 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace cpu {
+// What a cycle was charged for. BASE is the execute latency of ALU
+// instructions, loads, stores and branches that fall through, REDIRECT that
+// of taken branches and jumps. FETCH and LOAD are cache hit times, the
+// _MISS causes the memory time of misses. Store hits take no time.
+enum CycleCause {
+  BASE,
+  DECODE,
+  FETCH,
+  FETCH_MISS,
+  LOAD,
+  LOAD_MISS,
+  STORE_MISS,
+  REDIRECT
+};
+
+constexpr std::size_t num_cycle_causes = 8;
+
+// Cycles per CycleCause
+using CycleBreakdown = std::array<std::int64_t, num_cycle_causes>;
+}  // namespace cpu
@@ -3,14 +3,15 @@
 #include <cpu/decoder/instruction_type.hpp>
 #include <cstdint>
 #include <numeric>
-#include <string>
+#include <string_view>
 
 namespace cpu {
 struct ConnectionInfo {
   InstructionType instr_type;
-  std::string instr_name;
+  std::string_view instr_name;  // Views into isa::IsaTable
   std::int32_t operand1 = std::numeric_limits<std::int32_t>::max();
   std::int32_t operand2 = std::numeric_limits<std::int32_t>::max();
   std::int32_t operand3 = std::numeric_limits<std::int32_t>::max();
+  std::int32_t instr_id = -1;  // Index into isa::IsaTable::instructions
 };
-}  // namespace cpu
\ No newline at end of file
+}  // namespace cpu
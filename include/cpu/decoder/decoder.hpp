@@ -1,149 +1,95 @@
 #pragma once
 
-#include <limits.h>
-
-#include <algorithm>
 #include <cpu/decoder/connection_info.hpp>
-#include <cpu/decoder/i_instr.hpp>
 #include <cpu/decoder/instruction_type.hpp>
-#include <cpu/decoder/r_instr.hpp>
-#include <cpu/decoder/s_instr.hpp>
-#include <cpu/decoder/sb_instr.hpp>
-#include <cpu/decoder/u_instr.hpp>
-#include <cpu/decoder/uj_instr.hpp>
+#include <cstdint>
+#include <isa/decode_table.hpp>
+#include <isa/encoding.hpp>
+#include <isa/isa_table.hpp>
+#include <stdexcept>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <utility>
 
 namespace cpu {
 struct Decoder {
- private:
-  inline static std::unordered_map<std::string, InstructionType> m_type_map{
-      { "1100110", InstructionType::R },  { "1100100", InstructionType::I },
-      { "1100000", InstructionType::I },  { "1100010", InstructionType::S },
-      { "1100011", InstructionType::SB }, { "1110110", InstructionType::U },
-      { "1111011", InstructionType::UJ }, { "1110011", InstructionType::UJ } };
-
  public:
   static std::pair<std::int32_t, ConnectionInfo> decode(
       const std::string& instruction ) {
-    InstructionType instr_type = getType( instruction );
-    ConnectionInfo info{ instr_type,
-                         getInstructionName( instruction, instr_type ),
-                         getOperand1( instruction, instr_type ),
-                         getOperand2( instruction, instr_type ),
-                         getOperand3( instruction, instr_type ) };
+    return decode( isa::Encoding::toWord( instruction ) );
+  }
+
+  static std::pair<std::int32_t, ConnectionInfo> decode( std::uint32_t word ) {
+    std::int32_t instr_id = isa::DecodeTable::decode( word );
+    if ( instr_id == isa::DecodeTable::invalid ) {
+      throw std::invalid_argument( "Unknown instruction : " +
+                                   isa::Encoding::toBinaryString( word ) );
+    }
+    const isa::InstrDesc& desc = isa::IsaTable::instructions[instr_id];
+    isa::Operands operands =
+        isa::Encoding::getOperands( desc.immediate_layout, word );
+    ConnectionInfo info{ desc.format,         desc.name,
+                         operands.operand1,   operands.operand2,
+                         operands.operand3,   instr_id };
     return std::make_pair( 1, info );
   }
+
   static InstructionType getType( const std::string& instruction ) {
-    std::string opcode( instruction.rbegin(), instruction.rbegin() + 7 );
-    return m_type_map[opcode];
+    return getDesc( instruction ).format;
   }
-  static std::string getInstructionName( const std::string& instruction,
-                                         InstructionType instr_type ) {
-    std::string instruction_name;
 
-    switch ( instr_type ) {
-      case InstructionType::R:
-        instruction_name = RInstr::getInstructionName( instruction );
-        break;
-      case InstructionType::I:
-        instruction_name = IInstr::getInstructionName( instruction );
-        break;
-      case InstructionType::S:
-        instruction_name = SInstr::getInstructionName( instruction );
-        break;
-      case InstructionType::SB:
-        instruction_name = SBInstr::getInstructionName( instruction );
-        break;
-      case InstructionType::U:
-        instruction_name = UInstr::getInstructionName( instruction );
-        break;
-      case InstructionType::UJ:
-        instruction_name = UJInstr::getInstructionName( instruction );
-        break;
-    }
-    return instruction_name;
+  static std::string getInstructionName( const std::string& instruction ) {
+    return std::string( getDesc( instruction ).name );
+  }
+
+  static std::int32_t getOperand1( const std::string& instruction ) {
+    return getOperands( instruction ).operand1;
+  }
+
+  static std::int32_t getOperand2( const std::string& instruction ) {
+    return getOperands( instruction ).operand2;
   }
+
+  static std::int32_t getOperand3( const std::string& instruction ) {
+    return getOperands( instruction ).operand3;
+  }
+
+  // The instruction type is implied by the encoding, these overloads are
+  // kept for existing callers
+  static std::string getInstructionName( const std::string& instruction,
+                                         InstructionType ) {
+    return getInstructionName( instruction );
+  }
+
   static std::int32_t getOperand1( const std::string& instruction,
-                                   InstructionType instr_type ) {
-    std::int32_t op1;
-    switch ( instr_type ) {
-      case InstructionType::R:
-        op1 = RInstr::getOperand1( instruction );
-        break;
-      case InstructionType::I:
-        op1 = IInstr::getOperand1( instruction );
-        break;
-      case InstructionType::S:
-        op1 = SInstr::getOperand1( instruction );
-        break;
-      case InstructionType::SB:
-        op1 = SBInstr::getOperand1( instruction );
-        break;
-      case InstructionType::U:
-        op1 = UInstr::getOperand1( instruction );
-        break;
-      case InstructionType::UJ:
-        op1 = UJInstr::getOperand1( instruction );
-        break;
-    }
-    return op1;
+                                   InstructionType ) {
+    return getOperand1( instruction );
   }
 
   static std::int32_t getOperand2( const std::string& instruction,
-                                   InstructionType instr_type ) {
-    std::int32_t op2;
-    switch ( instr_type ) {
-      case InstructionType::R:
-        op2 = RInstr::getOperand2( instruction );
-        break;
-      case InstructionType::I:
-        op2 = IInstr::getOperand2( instruction );
-        break;
-      case InstructionType::S:
-        op2 = SInstr::getOperand2( instruction );
-        break;
-      case InstructionType::SB:
-        op2 = SBInstr::getOperand2( instruction );
-        break;
-      case InstructionType::U:
-        op2 = UInstr::getOperand2( instruction );
-        break;
-      case InstructionType::UJ:
-        op2 = UJInstr::getOperand2( instruction );
-        break;
-    }
-    return op2;
+                                   InstructionType ) {
+    return getOperand2( instruction );
   }
 
   static std::int32_t getOperand3( const std::string& instruction,
-                                   InstructionType instr_type ) {
-    std::int32_t op3;
-    switch ( instr_type ) {
-      case InstructionType::R:
-        op3 = RInstr::getOperand3( instruction );
-        break;
-      case InstructionType::I:
-        op3 = IInstr::getOperand3( instruction );
-        break;
-      case InstructionType::S:
-        op3 = SInstr::getOperand3( instruction );
-        break;
-      case InstructionType::SB:
-        op3 = SBInstr::getOperand3( instruction );
-        break;
-      case InstructionType::U:
-        op3 = UInstr::getOperand3( instruction );
-        break;
-      case InstructionType::UJ:
-        op3 = UJInstr::getOperand3( instruction );
-        break;
-    }
-    return op3;
+                                   InstructionType ) {
+    return getOperand3( instruction );
   }
 
  private:
+  static const isa::InstrDesc& getDesc( const std::string& instruction ) {
+    std::int32_t instr_id =
+        isa::DecodeTable::decode( isa::Encoding::toWord( instruction ) );
+    if ( instr_id == isa::DecodeTable::invalid ) {
+      throw std::invalid_argument( "Unknown instruction : " + instruction );
+    }
+    return isa::IsaTable::instructions[instr_id];
+  }
+
+  static isa::Operands getOperands( const std::string& instruction ) {
+    return isa::Encoding::getOperands( getDesc( instruction ).immediate_layout,
+                                       isa::Encoding::toWord( instruction ) );
+  }
 };
 
-}  // namespace cpu
\ No newline at end of file
+}  // namespace cpu
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <isa/isa_table.hpp>
+
 namespace cpu {
-enum InstructionType { R, I, S, SB, U, UJ };
+using InstructionType = isa::Format;
 }
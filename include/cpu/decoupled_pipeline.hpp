@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <common/spsc_ring.hpp>
+#include <cpu/decoder/decoder.hpp>
+#include <cpu/executor..hpp>
+#include <cpu/simulator.hpp>
+#include <cpu/state.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <isa/isa_table.hpp>
+#include <string>
+#include <thread>
+
+namespace cpu {
+// What the timing model needs to know about one executed instruction
+struct RetiredInstruction {
+  std::int32_t pc = 0;
+  std::int32_t instr_id = 0;  // Index into isa::IsaTable
+  std::int32_t decode_stages = 0;
+  std::int32_t address = 0;      // Effective address of loads and stores
+  std::int32_t store_value = 0;  // Value written by stores
+  bool branch_taken = false;
+};
+
+// Cache and latency accounting for a stream of retired instructions. Given
+// the same stream it charges exactly what the Executor and MemoryManager
+// charge when executing, so the two can run on separate threads. This is
+// the default timing consumer of DecoupledPipeline::run.
+struct TimingModel {
+  // Returns the cycles consumed by instr, updating the memory system and
+  // the counters of sys_state
+  static std::int64_t account( State& sys_state,
+                               const RetiredInstruction& instr ) {
+    const TimingConfig& timing = sys_state.timing;
+    const isa::InstrDesc& desc = isa::IsaTable::instructions[instr.instr_id];
+    sys_state.startInstruction();
+    sys_state.memory_manager.read( instr.pc, 4, true );  // Fetch
+    sys_state.charge( DECODE, instr.decode_stages * timing.decode_time );
+
+    if ( desc.semantics == isa::Load ) {
+      sys_state.memory_manager.read( instr.address, 4 );
+    } else if ( desc.semantics == isa::Store ) {
+      // Same little endian bit order as the executor stores
+      std::string value = std::bitset<32>( instr.store_value ).to_string();
+      std::reverse( value.begin(), value.end() );
+      sys_state.memory_manager.write( instr.address, value );
+    }
+    Executor::chargeLatency( sys_state, desc.semantics, instr.branch_taken );
+    return sys_state.cycles_consumed;
+  }
+
+  // Accounts instr and records it in the instruction statistics
+  void retire( State& sys_state, const RetiredInstruction& instr ) {
+    std::int64_t cycles = account( sys_state, instr );
+    sys_state.instr_stats.record( instr.pc, instr.instr_id, cycles,
+                                  sys_state.cycle_causes );
+  }
+};
+
+// Runs a program as two pipelined halves: a functional core executes it
+// ahead on its own thread, only touching registers and memory contents, and
+// passes each retired instruction through a lock-free ring to the timing
+// model on the calling thread. At the end the CPU holds the same state as
+// after CPU::run.
+struct DecoupledPipeline {
+  static void run( CPU& cpu, std::size_t ring_capacity = 4096 ) {
+    TimingModel timing_model;
+    run( cpu, timing_model, ring_capacity );
+  }
+
+  // consumer.retire( State&, const RetiredInstruction& ) is called on the
+  // calling thread for every instruction, in program order, with the state
+  // of cpu. It takes the place of the default TimingModel.
+  template <typename TimingConsumer>
+  static void run( CPU& cpu, TimingConsumer& consumer,
+                   std::size_t ring_capacity = 4096 ) {
+    common::SpscRing<RetiredInstruction> ring( ring_capacity );
+    std::atomic<bool> producer_done{ false };
+    std::atomic<bool> consumer_stopped{ false };
+    std::exception_ptr producer_error;
+
+    CPU functional = cpu.fork();
+    functional.getSystemState().memory_manager.setMode(
+        memory::MemoryManager::FUNCTIONAL );
+    std::thread producer( [&]() {
+      try {
+        runFunctional( functional, ring, consumer_stopped );
+      } catch ( ... ) {
+        producer_error = std::current_exception();
+      }
+      producer_done.store( true, std::memory_order_release );
+    } );
+
+    State& state = cpu.getSystemState();
+    try {
+      RetiredInstruction instr;
+      while ( true ) {
+        if ( ring.tryPop( instr ) ) {
+          consumer.retire( state, instr );
+        } else if ( producer_done.load( std::memory_order_acquire ) ) {
+          if ( !ring.tryPop( instr ) ) {
+            break;  // Everything pushed before done has been consumed
+          }
+          consumer.retire( state, instr );
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    } catch ( ... ) {
+      consumer_stopped = true;
+      producer.join();
+      throw;
+    }
+    producer.join();
+    if ( producer_error ) {
+      std::rethrow_exception( producer_error );
+    }
+
+    // Architectural state comes from the functional core, memory contents
+    // are already identical as the timing model replayed every store
+    State& functional_state = functional.getSystemState();
+    std::copy( std::begin( functional_state.register_file ),
+               std::end( functional_state.register_file ),
+               std::begin( state.register_file ) );
+    state.PC = functional_state.PC;
+    state.IR = functional_state.IR;
+  }
+
+ private:
+  static void runFunctional( CPU& cpu,
+                             common::SpscRing<RetiredInstruction>& ring,
+                             const std::atomic<bool>& consumer_stopped ) {
+    State& state = cpu.getSystemState();
+    while ( !cpu.isHalted() ) {
+      RetiredInstruction instr;
+      instr.pc = state.PC;
+      state.IR = cpu.fetchInstruction();
+      auto [decode_stages, conn_info] = Decoder::decode( state.IR );
+      instr.instr_id = conn_info.instr_id;
+      instr.decode_stages = decode_stages;
+      instr.address = Executor::getEffectiveAddress( state, conn_info );
+      const isa::InstrDesc& desc = isa::IsaTable::instructions[instr.instr_id];
+      if ( desc.semantics == isa::Store ) {
+        instr.store_value = state.register_file[conn_info.operand1];
+      } else if ( desc.semantics == isa::Branch ) {
+        const std::int32_t* rf = state.register_file;
+        instr.branch_taken =
+            desc.alu( rf[conn_info.operand1], rf[conn_info.operand2] );
+      }
+      Executor::execute( state, conn_info );
+
+      while ( !ring.tryPush( instr ) ) {
+        if ( consumer_stopped ) {
+          return;
+        }
+        std::this_thread::yield();
+      }
+    }
+  }
+};
+}  // namespace cpu
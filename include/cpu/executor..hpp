@@ -1,58 +1,19 @@
 #pragma once
+#include <algorithm>
+#include <array>
 #include <bitset>
 #include <cpu/decoder/connection_info.hpp>
 #include <cpu/state.hpp>
-#include <functional>
-#include <unordered_map>
+#include <cstddef>
+#include <isa/encoding.hpp>
+#include <isa/isa_table.hpp>
+#include <stdexcept>
+#include <string>
+#include <utility>
 
 namespace cpu {
 struct Executor {
-  // R Type
  private:
-  static void add_func( State& sys_state, const ConnectionInfo& conn_info ) {
-    int* rf = sys_state.register_file;
-    rf[conn_info.operand1] = rf[conn_info.operand2] + rf[conn_info.operand3];
-
-    sys_state.cycles_consumed += sys_state.execute_time;
-  }
-  static void sub_func( State& sys_state, const ConnectionInfo& conn_info ) {
-    int* rf = sys_state.register_file;
-    rf[conn_info.operand1] = rf[conn_info.operand2] - rf[conn_info.operand3];
-
-    sys_state.cycles_consumed += sys_state.execute_time;
-  }
-  static void xor_func( State& sys_state, const ConnectionInfo& conn_info ) {
-    int* rf = sys_state.register_file;
-    rf[conn_info.operand1] = rf[conn_info.operand2] ^ rf[conn_info.operand3];
-
-    sys_state.cycles_consumed += sys_state.execute_time;
-  }
-  static void and_func( State& sys_state, const ConnectionInfo& conn_info ) {
-    int* rf = sys_state.register_file;
-    rf[conn_info.operand1] = rf[conn_info.operand2] & rf[conn_info.operand3];
-
-    sys_state.cycles_consumed += sys_state.execute_time;
-  }
-  static void or_func( State& sys_state, const ConnectionInfo& conn_info ) {
-    int* rf = sys_state.register_file;
-    rf[conn_info.operand1] = rf[conn_info.operand2] | rf[conn_info.operand3];
-
-    sys_state.cycles_consumed += sys_state.execute_time;
-  }
-  static void sll_func( State& sys_state, const ConnectionInfo& conn_info ) {
-    int* rf = sys_state.register_file;
-    rf[conn_info.operand1] = rf[conn_info.operand2] << rf[conn_info.operand3];
-
-    sys_state.cycles_consumed += sys_state.execute_time;
-  }
-  static void sra_func( State& sys_state, const ConnectionInfo& conn_info ) {
-    int* rf = sys_state.register_file;
-    rf[conn_info.operand1] = rf[conn_info.operand2] >> rf[conn_info.operand3];
-
-    sys_state.cycles_consumed += sys_state.execute_time;
-  }
-
-  // SB Type
   static std::int32_t sext( const std::int32_t value,
                             const std::int32_t msb_position ) {
     std::int32_t result = value;
@@ -71,135 +32,66 @@ struct Executor {
     return value;  // Same value is returned in case the msb is 0
   }
 
-  static void beq_func( State& sys_state, const ConnectionInfo& conn_info ) {
-    int* rf = sys_state.register_file;
-
-    std::int32_t rs1 = rf[conn_info.operand1];
-    std::int32_t rs2 = rf[conn_info.operand2];
-    std::int32_t offset = sext( conn_info.operand3, 12 );
-
-    if ( rs1 == rs2 ) {
-      sys_state.PC -= 4;  // Reverse the change made by fetch
-      sys_state.PC += offset;
-    }
-    sys_state.cycles_consumed += sys_state.execute_time;
-  }
-
-  static void blt_func( State& sys_state, const ConnectionInfo& conn_info ) {
-    int* rf = sys_state.register_file;
-
-    std::int32_t rs1 = rf[conn_info.operand1];
-    std::int32_t rs2 = rf[conn_info.operand2];
-    std::int32_t offset = sext( conn_info.operand3, 12 );
-
-    if ( rs1 < rs2 ) {
-      sys_state.PC -= 4;  // Reverse the change made by fetch
-      sys_state.PC += offset;
-    }
-    sys_state.cycles_consumed += sys_state.execute_time;
-  }
-  static void bge_func( State& sys_state, const ConnectionInfo& conn_info ) {
-    int* rf = sys_state.register_file;
-
-    std::int32_t rs1 = rf[conn_info.operand1];
-    std::int32_t rs2 = rf[conn_info.operand2];
-    std::int32_t offset = sext( conn_info.operand3, 12 );
-
-    if ( rs1 >= rs2 ) {
-      sys_state.PC -= 4;  // Reverse the change made by fetch
-      sys_state.PC += offset;
+  // One instantiation per IsaTable entry, the ALU / compare function and the
+  // immediate width are compile time constants in each of them
+  template <std::size_t InstrId>
+  static void executeInstr( State& sys_state,
+                            const ConnectionInfo& conn_info ) {
+    constexpr const isa::InstrDesc& desc = isa::IsaTable::instructions[InstrId];
+    constexpr std::int32_t imm_width =
+        isa::Encoding::immediateWidth( desc.immediate_layout );
+    int* rf = sys_state.register_file;
+    bool branch_taken = false;
+
+    if constexpr ( desc.semantics == isa::AluReg ) {
+      rf[conn_info.operand1] =
+          desc.alu( rf[conn_info.operand2], rf[conn_info.operand3] );
+
+    } else if constexpr ( desc.semantics == isa::AluImm ) {
+      std::int32_t immediate = sext( conn_info.operand3, imm_width );
+      rf[conn_info.operand1] = desc.alu( rf[conn_info.operand2], immediate );
+
+    } else if constexpr ( desc.semantics == isa::Branch ) {
+      std::int32_t rs1 = rf[conn_info.operand1];
+      std::int32_t rs2 = rf[conn_info.operand2];
+      std::int32_t offset = sext( conn_info.operand3, imm_width );
+
+      branch_taken = desc.alu( rs1, rs2 );
+      if ( branch_taken ) {
+        sys_state.PC -= 4;  // Reverse the change made by fetch
+        sys_state.PC += offset;
+      }
+
+    } else if constexpr ( desc.semantics == isa::Lui ) {
+      std::int32_t immediate = conn_info.operand2;
+      immediate = ( immediate << 12 ) & ( ( ~0 ) << 12 );
+      rf[conn_info.operand1] = sext( immediate, 32 );
+
+    } else if constexpr ( desc.semantics == isa::Load ) {
+      // Memory accesses are charged by the memory manager
+      std::int32_t rs1 = rf[conn_info.operand2];
+      std::int32_t offset = sext( conn_info.operand3, imm_width );
+      rf[conn_info.operand1] =
+          sext( loadFromMemory( sys_state, rs1 + offset, 4 ), 32 );
+
+    } else if constexpr ( desc.semantics == isa::Store ) {
+      std::int32_t rs2 = rf[conn_info.operand1];
+      std::int32_t rs1 = rf[conn_info.operand2];
+      std::int32_t offset = sext( conn_info.operand3, imm_width );
+      storeToMemory( sys_state, rs1 + offset, rs2 );
+
+    } else if constexpr ( desc.semantics == isa::Jalr ) {
+      std::int32_t rs1 = rf[conn_info.operand2];
+      std::int32_t offset = sext( conn_info.operand3, imm_width );
+      sys_state.PC = rs1 + offset;
+      rf[conn_info.operand1] = sys_state.PC;  // t possibly
+
+    } else if constexpr ( desc.semantics == isa::Jal ) {
+      std::int32_t offset = sext( conn_info.operand2, imm_width );
+      rf[conn_info.operand1] = sys_state.PC;  // Already updated by fetch
+      sys_state.PC += offset - 4;             // Already updated by fetch
     }
-    sys_state.cycles_consumed += sys_state.execute_time;
-  }
-  static void bne_func( State& sys_state, const ConnectionInfo& conn_info ) {
-    int* rf = sys_state.register_file;
-
-    std::int32_t rs1 = rf[conn_info.operand1];
-    std::int32_t rs2 = rf[conn_info.operand2];
-    std::int32_t offset = sext( conn_info.operand3, 12 );
-
-    if ( rs1 != rs2 ) {
-      sys_state.PC -= 4;  // Reverse the change made by fetch
-      sys_state.PC += offset;
-    }
-    sys_state.cycles_consumed += sys_state.execute_time;
-  }
-
-  // U Type Support
-  static void lui_func( State& sys_state, const ConnectionInfo& conn_info ) {
-    int* rf = sys_state.register_file;
-
-    std::int32_t& rd = rf[conn_info.operand1];
-    std::int32_t immediate = conn_info.operand2;
-
-    immediate = ( immediate << 12 ) & ( ( ~0 ) << 12 );
-
-    rd = sext( immediate, 32 );
-
-    sys_state.cycles_consumed += sys_state.execute_time;
-  }
-
-  // I Type Support
-  static void addi_func( State& sys_state, const ConnectionInfo& conn_info ) {
-    int* rf = sys_state.register_file;
-
-    std::int32_t& rd = rf[conn_info.operand1];
-    std::int32_t rs1 = rf[conn_info.operand2];
-    std::int32_t immediate = sext( conn_info.operand3, 12 );
-
-    rd = rs1 + immediate;
-
-    sys_state.cycles_consumed += sys_state.execute_time;
-  }
-
-  static void lw_func( State& sys_state, const ConnectionInfo& conn_info ) {
-    int* rf = sys_state.register_file;
-
-    std::int32_t& rd = rf[conn_info.operand1];
-    std::int32_t rs1 = rf[conn_info.operand2];
-    std::int32_t offset = sext( conn_info.operand3, 12 );
-
-    rd = sext( loadFromMemory( sys_state, rs1 + offset, 4 ), 32 );
-    // rd = sext( loadFromMemory( sys_state.memory, rs1 + offset, 4 ), 32 );
-  }
-
-  // S Type
-  static void sw_func( State& sys_state, const ConnectionInfo& conn_info ) {
-    int* rf = sys_state.register_file;
-
-    std::int32_t rs2 = rf[conn_info.operand1];
-    std::int32_t rs1 = rf[conn_info.operand2];
-    std::int32_t offset = sext( conn_info.operand3, 12 );
-
-    // storeToMemory( rs2, sys_state.memory, rs1 + offset );
-    storeToMemory( sys_state, rs1 + offset, rs2 );
-  }
-
-  static void jalr_func( State& sys_state, const ConnectionInfo& conn_info ) {
-    int* rf = sys_state.register_file;
-
-    std::int32_t& rd = rf[conn_info.operand1];
-    std::int32_t rs1 = rf[conn_info.operand2];
-    std::int32_t offset = sext( conn_info.operand3, 12 );
-
-    std::int32_t t = sys_state.PC;
-    sys_state.PC = rs1 + sext( offset, 12 );
-    rd = sys_state.PC;  // t possibly
-
-    sys_state.cycles_consumed += sys_state.execute_time;
-  }
-
-  static void jal_func( State& sys_state, const ConnectionInfo& conn_info ) {
-    int* rf = sys_state.register_file;
-
-    std::int32_t& rd = rf[conn_info.operand1];
-    std::int32_t offset = sext( conn_info.operand2, 12 );
-
-    rd = sys_state.PC;  // Already updated by fetch
-
-    sys_state.PC += offset - 4;  // Already updated by fetch
-
-    sys_state.cycles_consumed += sys_state.execute_time;
+    chargeLatency( sys_state, desc.semantics, branch_taken );
   }
 
   // static std::int32_t loadFromMemory( const std::string& mem,
@@ -237,51 +129,75 @@ struct Executor {
     sys_state.memory_manager.write( address, binary_value );
   }
 
- private:
-  static inline std::unordered_map<
-      std::string, std::function<void( State&, const ConnectionInfo& )>>
-      m_instr_func_map{ { "add", std::bind( &add_func, std::placeholders::_1,
-                                            std::placeholders::_2 ) },
-                        { "sub", std::bind( &sub_func, std::placeholders::_1,
-                                            std::placeholders::_2 ) },
-                        { "xor", std::bind( &xor_func, std::placeholders::_1,
-                                            std::placeholders::_2 ) },
-                        { "and", std::bind( &and_func, std::placeholders::_1,
-                                            std::placeholders::_2 ) },
-                        { "or", std::bind( &or_func, std::placeholders::_1,
-                                           std::placeholders::_2 ) },
-                        { "sll", std::bind( &sll_func, std::placeholders::_1,
-                                            std::placeholders::_2 ) },
-                        { "sra", std::bind( &sra_func, std::placeholders::_1,
-                                            std::placeholders::_2 ) },
-                        { "addi", std::bind( &addi_func, std::placeholders::_1,
-                                             std::placeholders::_2 ) },
-                        { "lw", std::bind( &lw_func, std::placeholders::_1,
-                                           std::placeholders::_2 ) },
-                        { "sw", std::bind( &sw_func, std::placeholders::_1,
-                                           std::placeholders::_2 ) },
-                        { "jalr", std::bind( &jalr_func, std::placeholders::_1,
-                                             std::placeholders::_2 ) },
-                        { "jal", std::bind( &jal_func, std::placeholders::_1,
-                                            std::placeholders::_2 ) },
-                        { "beq", std::bind( &beq_func, std::placeholders::_1,
-                                            std::placeholders::_2 ) },
-                        { "bne", std::bind( &bne_func, std::placeholders::_1,
-                                            std::placeholders::_2 ) },
-                        { "blt", std::bind( &blt_func, std::placeholders::_1,
-                                            std::placeholders::_2 ) },
-                        { "bge", std::bind( &bge_func, std::placeholders::_1,
-                                            std::placeholders::_2 ) },
-                        { "lui", std::bind( &lui_func, std::placeholders::_1,
-                                            std::placeholders::_2 ) },
-                        { "jal", std::bind( &jal_func, std::placeholders::_1,
-                                            std::placeholders::_2 ) },
-                        { "jalr", std::bind( &jalr_func, std::placeholders::_1,
-                                             std::placeholders::_2 ) } };
+  using InstrFunc = void ( * )( State&, const ConnectionInfo& );
+
+  template <std::size_t... InstrIds>
+  static constexpr std::array<InstrFunc, sizeof...( InstrIds )> makeDispatch(
+      std::index_sequence<InstrIds...> ) {
+    return { &executeInstr<InstrIds>... };
+  }
+
+  // Indexed by ConnectionInfo::instr_id
+  static const std::array<InstrFunc, isa::IsaTable::size()> m_dispatch;
 
  public:  // API
   static void execute( State& sys_state, const ConnectionInfo& conn_info ) {
-    m_instr_func_map[conn_info.instr_name]( sys_state, conn_info );
+    if ( conn_info.instr_id < 0 ||
+         conn_info.instr_id >= std::int32_t( m_dispatch.size() ) ) {
+      throw std::invalid_argument( "Unknown instruction : " +
+                                   std::string( conn_info.instr_name ) );
+    }
+    m_dispatch[conn_info.instr_id]( sys_state, conn_info );
+  }
+
+  // Charges the execute latency of an instruction with the given semantics
+  // to its cycle cause. The decoupled timing model charges through here too.
+  // Memory accesses are charged by the memory manager.
+  static void chargeLatency( State& sys_state, isa::Semantics semantics,
+                             bool branch_taken ) {
+    const TimingConfig& timing = sys_state.timing;
+    switch ( semantics ) {
+      case isa::AluReg:
+      case isa::AluImm:
+      case isa::Lui:
+        sys_state.charge( BASE, timing.alu_latency );
+        break;
+      case isa::Branch:
+        if ( branch_taken ) {
+          sys_state.charge( REDIRECT, timing.branch_taken_latency );
+        } else {
+          sys_state.charge( BASE, timing.branch_not_taken_latency );
+        }
+        break;
+      case isa::Load:
+        sys_state.charge( BASE, timing.load_latency );
+        break;
+      case isa::Store:
+        sys_state.charge( BASE, timing.store_latency );
+        break;
+      case isa::Jal:
+      case isa::Jalr:
+        sys_state.charge( REDIRECT, timing.jump_latency );
+        break;
+    }
+  }
+
+  // Address a load or store will access, 0 for other instructions. Must be
+  // called before the instruction executes.
+  static std::int32_t getEffectiveAddress( const State& sys_state,
+                                           const ConnectionInfo& conn_info ) {
+    const isa::InstrDesc& desc = isa::IsaTable::instructions.at(
+        conn_info.instr_id );
+    if ( desc.semantics != isa::Load && desc.semantics != isa::Store ) {
+      return 0;
+    }
+    return sys_state.register_file[conn_info.operand2] +
+           sext( conn_info.operand3,
+                 isa::Encoding::immediateWidth( desc.immediate_layout ) );
   }
 };
-}  // namespace cpu
\ No newline at end of file
+
+inline constexpr std::array<Executor::InstrFunc, isa::IsaTable::size()>
+    Executor::m_dispatch = Executor::makeDispatch(
+        std::make_index_sequence<isa::IsaTable::size()>() );
+}  // namespace cpu
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cpu/cpi_stack.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <isa/isa_table.hpp>
+#include <utility>
+#include <vector>
+
+namespace cpu {
+struct InstructionRecord {
+  std::int64_t index = 0;  // Position in the run
+  std::int32_t pc = 0;
+  std::int32_t instr_id = 0;
+  std::int64_t cycles = 0;
+
+  bool operator==( const InstructionRecord& ) const = default;
+};
+
+// Fixed size statistics of the executed instructions: totals, count and
+// cycles per opcode, cycles per cause, a histogram of instruction latencies
+// and, if enabled, the last history_capacity instructions.
+struct InstructionStats {
+  // Bucket 0 holds latency 0, bucket b latencies in [2^(b-1), 2^b)
+  static constexpr std::size_t num_buckets = 64;
+
+  std::int64_t instructions = 0;
+  std::int64_t cycles = 0;
+  std::array<std::int64_t, isa::IsaTable::size()> opcode_counts{};
+  std::array<std::int64_t, isa::IsaTable::size()> opcode_cycles{};
+  std::array<std::int64_t, num_buckets> latency_histogram{};
+  CycleBreakdown cause_cycles{};
+
+ private:
+  std::vector<InstructionRecord> m_history;  // Ring once it is full
+  std::size_t m_history_capacity = 0;
+  std::size_t m_history_next = 0;  // Oldest entry of a full ring
+
+ public:
+  void record( std::int32_t pc, std::int32_t instr_id, std::int64_t cycles,
+               const CycleBreakdown& causes = {} ) {
+    if ( m_history_capacity != 0 ) {
+      InstructionRecord record{ instructions, pc, instr_id, cycles };
+      if ( m_history.size() < m_history_capacity ) {
+        m_history.push_back( record );
+      } else {
+        m_history[m_history_next] = record;
+        m_history_next = ( m_history_next + 1 ) % m_history_capacity;
+      }
+    }
+    instructions++;
+    this->cycles += cycles;
+    opcode_counts[instr_id]++;
+    opcode_cycles[instr_id] += cycles;
+    latency_histogram[getBucket( cycles )]++;
+    for ( std::size_t i = 0; i < num_cycle_causes; i++ ) {
+      cause_cycles[i] += causes[i];
+    }
+  }
+
+  static std::size_t getBucket( std::int64_t cycles ) {
+    return cycles <= 0 ? 0 : std::bit_width( std::uint64_t( cycles ) );
+  }
+
+  double getCPI() const {
+    return instructions == 0 ? 0 : cycles / double( instructions );
+  }
+
+  CpiStack getCpiStack() const {
+    return CpiStack{ instructions, cause_cycles };
+  }
+
+  // Keeps the last capacity instructions from now on, 0 disables
+  void setHistoryCapacity( std::size_t capacity ) {
+    restoreHistory( capacity, {} );
+  }
+
+  // Sets the capacity and the history ( oldest first ), of which only the
+  // last capacity records are kept
+  void restoreHistory( std::size_t capacity,
+                       std::vector<InstructionRecord> history ) {
+    if ( history.size() > capacity ) {
+      history.erase( history.begin(), history.end() - capacity );
+    }
+    m_history = std::move( history );
+    m_history_capacity = capacity;
+    m_history_next = 0;
+  }
+
+  std::size_t getHistoryCapacity() const { return m_history_capacity; }
+
+  // Oldest first
+  std::vector<InstructionRecord> getHistory() const {
+    std::vector<InstructionRecord> history;
+    history.reserve( m_history.size() );
+    std::size_t oldest =
+        m_history.size() < m_history_capacity ? 0 : m_history_next;
+    for ( std::size_t i = 0; i < m_history.size(); i++ ) {
+      history.push_back( m_history[( oldest + i ) % m_history.size()] );
+    }
+    return history;
+  }
+
+  // Zeroes the statistics, keeping the history capacity
+  void reset() {
+    std::size_t capacity = m_history_capacity;
+    *this = InstructionStats();
+    setHistoryCapacity( capacity );
+  }
+
+  bool operator==( const InstructionStats& ) const = default;
+};
+}  // namespace cpu
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cpu/run_observer.hpp>
+#include <cpu/state.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+namespace cpu {
+// Progress of a running simulation as seen by a monitor
+struct LiveCounters {
+  std::int64_t instructions = 0;
+  std::int64_t cycles = 0;
+  std::int64_t cache_hits = 0;
+  std::int64_t cache_misses = 0;
+  std::int64_t pc = 0;
+  std::int64_t updates = 0;  // Number of publishes so far
+  std::int64_t time_ns = 0;  // Steady clock time of the last publish
+  std::int64_t finished = 0;
+
+  static constexpr std::size_t num_values = 8;
+
+  std::array<std::int64_t, num_values> getValues() const {
+    return { instructions, cycles, cache_hits, cache_misses,
+             pc,           updates, time_ns,   finished };
+  }
+
+  static LiveCounters fromValues(
+      const std::array<std::int64_t, num_values>& values ) {
+    return { values[0], values[1], values[2], values[3],
+             values[4], values[5], values[6], values[7] };
+  }
+};
+
+// Layout of the shared file. The single writer makes sequence odd while it
+// updates the values ( a seqlock ), readers retry until they see the same
+// even sequence before and after reading. Readers never write, so the
+// simulation thread never waits for them.
+struct LiveCounterSegment {
+  static constexpr std::string_view magic{ "RVSIMLIV", 8 };
+  static constexpr std::uint32_t version = 1;
+
+  char file_magic[8];
+  std::uint32_t file_version;
+  std::uint32_t pid;
+  std::atomic<std::uint64_t> sequence;
+  std::array<std::atomic<std::int64_t>, LiveCounters::num_values> values;
+
+  static_assert( std::atomic<std::uint64_t>::is_always_lock_free &&
+                 std::atomic<std::int64_t>::is_always_lock_free );
+};
+
+// Publishes the counters of a run in a file under /dev/shm, every period
+// instructions and at the end when it observes CPU::run. The file is
+// removed again when the publisher is destroyed, monitors that still have
+// it mapped see the finished flag. The file is set up under a temporary
+// name and renamed into place, so readers never see it half written.
+struct LiveCounterPublisher : RunObserver {
+ private:
+  std::string m_path;
+  std::int64_t m_period;
+  LiveCounterSegment* m_segment = nullptr;
+  std::int64_t m_updates = 0;
+  std::int64_t m_countdown = 0;  // Instructions until the next publish
+
+ public:
+  LiveCounterPublisher( const std::string& path = getDefaultPath( ::getpid() ),
+                        std::int64_t period = 1 << 16 )
+      : m_path( path ), m_period( period ) {
+    if ( m_period <= 0 ) {
+      throw std::invalid_argument( "Publish period must be positive" );
+    }
+    std::string temp_path = m_path + ".tmp";
+    int fd = ::open( temp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+    if ( fd < 0 ) {
+      throw std::runtime_error( "Unable to create counter file : " + m_path );
+    }
+    void* data = MAP_FAILED;
+    if ( ::ftruncate( fd, sizeof( LiveCounterSegment ) ) == 0 ) {
+      data = ::mmap( nullptr, sizeof( LiveCounterSegment ),
+                     PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    }
+    ::close( fd );
+    if ( data == MAP_FAILED ) {
+      ::unlink( temp_path.c_str() );
+      throw std::runtime_error( "Unable to map counter file : " + m_path );
+    }
+
+    m_segment = new ( data ) LiveCounterSegment();
+    std::memcpy( m_segment->file_magic, LiveCounterSegment::magic.data(),
+                 LiveCounterSegment::magic.size() );
+    m_segment->file_version = LiveCounterSegment::version;
+    m_segment->pid = ::getpid();
+    if ( ::rename( temp_path.c_str(), m_path.c_str() ) != 0 ) {
+      ::munmap( m_segment, sizeof( LiveCounterSegment ) );
+      ::unlink( temp_path.c_str() );
+      throw std::runtime_error( "Unable to create counter file : " + m_path );
+    }
+  }
+
+  LiveCounterPublisher( const LiveCounterPublisher& ) = delete;
+  LiveCounterPublisher& operator=( const LiveCounterPublisher& ) = delete;
+
+  ~LiveCounterPublisher() {
+    LiveCounters last = read();
+    last.finished = 1;
+    publish( last );
+    ::munmap( m_segment, sizeof( LiveCounterSegment ) );
+    ::unlink( m_path.c_str() );
+  }
+
+  static std::string getDefaultPath( std::int64_t pid ) {
+    return "/dev/shm/rvsim." + std::to_string( pid );
+  }
+
+  const std::string& getPath() const { return m_path; }
+  std::int64_t getPeriod() const { return m_period; }
+
+  void publish( const State& state, bool finished = false ) {
+    LiveCounters counters;
+    counters.instructions = state.instr_stats.instructions;
+    counters.cycles = state.instr_stats.cycles;
+    counters.cache_hits = state.cache_hits;
+    counters.cache_misses = state.cache_miss;
+    counters.pc = state.PC;
+    counters.finished = finished;
+    publish( counters );
+  }
+
+  void start( const State& ) override { m_countdown = m_period; }
+
+  void retire( const State& state, const InstructionEvent& ) override {
+    if ( --m_countdown == 0 ) {
+      publish( state );
+      m_countdown = m_period;
+    }
+  }
+
+  void finish( const State& state, bool halted ) override {
+    publish( state, halted );
+  }
+
+  // Sets updates and time_ns itself
+  void publish( LiveCounters counters ) {
+    counters.updates = ++m_updates;
+    counters.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now().time_since_epoch() )
+                           .count();
+    std::uint64_t sequence =
+        m_segment->sequence.load( std::memory_order_relaxed );
+    m_segment->sequence.store( sequence + 1, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+    auto values = counters.getValues();
+    for ( std::size_t i = 0; i < values.size(); i++ ) {
+      m_segment->values[i].store( values[i], std::memory_order_relaxed );
+    }
+    m_segment->sequence.store( sequence + 2, std::memory_order_release );
+  }
+
+ private:
+  // Only the writer calls this, so no retry is needed
+  LiveCounters read() const {
+    std::array<std::int64_t, LiveCounters::num_values> values;
+    for ( std::size_t i = 0; i < values.size(); i++ ) {
+      values[i] = m_segment->values[i].load( std::memory_order_relaxed );
+    }
+    return LiveCounters::fromValues( values );
+  }
+};
+
+// Read only view of a publisher's file, usable from another process
+struct LiveCounterReader {
+ private:
+  const LiveCounterSegment* m_segment = nullptr;
+
+ public:
+  LiveCounterReader( const std::string& path ) {
+    int fd = ::open( path.c_str(), O_RDONLY );
+    if ( fd < 0 ) {
+      throw std::runtime_error( "Unable to open counter file : " + path );
+    }
+    // Mapping past the end of a shorter file would fault on the first read
+    struct stat file_stat;
+    if ( ::fstat( fd, &file_stat ) != 0 ||
+         file_stat.st_size < off_t( sizeof( LiveCounterSegment ) ) ) {
+      ::close( fd );
+      throw std::runtime_error( "Not a counter file : " + path );
+    }
+    void* data = ::mmap( nullptr, sizeof( LiveCounterSegment ), PROT_READ,
+                         MAP_SHARED, fd, 0 );
+    ::close( fd );
+    if ( data == MAP_FAILED ) {
+      throw std::runtime_error( "Unable to map counter file : " + path );
+    }
+    m_segment = static_cast<const LiveCounterSegment*>( data );
+    if ( std::string_view( m_segment->file_magic, 8 ) !=
+             LiveCounterSegment::magic ||
+         m_segment->file_version != LiveCounterSegment::version ) {
+      ::munmap( data, sizeof( LiveCounterSegment ) );
+      throw std::runtime_error( "Not a counter file : " + path );
+    }
+  }
+
+  LiveCounterReader( const LiveCounterReader& ) = delete;
+  LiveCounterReader& operator=( const LiveCounterReader& ) = delete;
+
+  ~LiveCounterReader() {
+    ::munmap( const_cast<LiveCounterSegment*>( m_segment ),
+              sizeof( LiveCounterSegment ) );
+  }
+
+  std::uint32_t getPid() const { return m_segment->pid; }
+
+  // Consistent snapshot of the last publish
+  LiveCounters read() const {
+    std::array<std::int64_t, LiveCounters::num_values> values;
+    while ( true ) {
+      std::uint64_t before =
+          m_segment->sequence.load( std::memory_order_acquire );
+      if ( before % 2 == 0 ) {
+        for ( std::size_t i = 0; i < values.size(); i++ ) {
+          values[i] = m_segment->values[i].load( std::memory_order_relaxed );
+        }
+        std::atomic_thread_fence( std::memory_order_acquire );
+        if ( m_segment->sequence.load( std::memory_order_relaxed ) == before ) {
+          return LiveCounters::fromValues( values );
+        }
+      }
+      std::this_thread::yield();
+    }
+  }
+};
+}  // namespace cpu
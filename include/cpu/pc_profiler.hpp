@@ -0,0 +1,130 @@
+#pragma once
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <assembler/line_reader.hpp>
+#include <assembler/line_table.hpp>
+#include <cpu/run_observer.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+namespace cpu {
+struct PcCounters {
+  std::int64_t instructions = 0;
+  std::int64_t cycles = 0;
+  // Fetch and data accesses of the instruction together
+  std::int64_t cache_hits = 0;
+  std::int64_t cache_misses = 0;
+
+  void add( const PcCounters& other ) {
+    instructions += other.instructions;
+    cycles += other.cycles;
+    cache_hits += other.cache_hits;
+    cache_misses += other.cache_misses;
+  }
+
+  bool operator==( const PcCounters& ) const = default;
+};
+
+// Counters of every retired instruction, in a flat array indexed by
+// PC / 4 so recording is a single indexed update. Sized for the program up
+// front, it only grows if the PC leaves it.
+struct PcProfiler : RunObserver {
+ private:
+  std::vector<PcCounters> m_counters;
+
+ public:
+  PcProfiler( std::size_t num_instructions = 0 )
+      : m_counters( num_instructions ) {}
+
+  void record( std::int32_t pc, std::int64_t cycles, std::int64_t cache_hits,
+               std::int64_t cache_misses ) {
+    std::size_t index = std::uint32_t( pc ) >> 2;
+    if ( index >= m_counters.size() ) {
+      m_counters.resize( index + 1 );
+    }
+    PcCounters& counters = m_counters[index];
+    counters.instructions++;
+    counters.cycles += cycles;
+    counters.cache_hits += cache_hits;
+    counters.cache_misses += cache_misses;
+  }
+
+  void retire( const State&, const InstructionEvent& instruction ) override {
+    record( instruction.trace.pc, instruction.cycles, instruction.cache_hits,
+            instruction.cache_misses );
+  }
+
+  // Zeroes for a PC that never retired
+  PcCounters getCounters( std::int32_t pc ) const {
+    std::size_t index = std::uint32_t( pc ) >> 2;
+    return index < m_counters.size() ? m_counters[index] : PcCounters();
+  }
+
+  // Indexed by PC / 4
+  const std::vector<PcCounters>& getAllCounters() const { return m_counters; }
+
+  PcCounters getTotal() const {
+    PcCounters total;
+    for ( auto& counters : m_counters ) {
+      total.add( counters );
+    }
+    return total;
+  }
+
+  // Counters summed per source line, indexed by line. PCs outside the line
+  // table end up in line 0.
+  std::vector<PcCounters> getLineCounters(
+      const assembler::LineTable& line_table ) const {
+    std::vector<PcCounters> lines;
+    for ( std::size_t i = 0; i < m_counters.size(); i++ ) {
+      std::size_t line = line_table.getLine( i * 4 );
+      if ( line >= lines.size() ) {
+        lines.resize( line + 1 );
+      }
+      lines[line].add( m_counters[i] );
+    }
+    return lines;
+  }
+
+  // Writes source with the counters of each line in front of it, cycles
+  // also as a share of the total so hot lines stand out
+  void annotate( std::ostream& out, std::string_view source,
+                 const assembler::LineTable& line_table ) const {
+    std::vector<PcCounters> lines = getLineCounters( line_table );
+    PcCounters total = getTotal();
+    out << fmt::format( "{:>10} {:>10} {:>6} {:>8} {:>8} {:>6}  {}\n",
+                        "count", "cycles", "cyc %", "hits", "misses", "line",
+                        "source" );
+
+    if ( !source.empty() && source.back() == '\n' ) {
+      source.remove_suffix( 1 );
+    }
+    assembler::LineReader reader( source );
+    std::string_view text;
+    for ( std::size_t line = 1; reader.next( text ); line++ ) {
+      const PcCounters counters =
+          line < lines.size() ? lines[line] : PcCounters();
+      if ( counters.instructions == 0 ) {
+        out << fmt::format( "{:>46} {:>6}  {}\n", "", line, text );
+        continue;
+      }
+      out << fmt::format( "{:>10} {:>10} {:>6.2f} {:>8} {:>8} {:>6}  {}\n",
+                          counters.instructions, counters.cycles,
+                          100.0 * counters.cycles / std::max<std::int64_t>(
+                                                        total.cycles, 1 ),
+                          counters.cache_hits, counters.cache_misses, line,
+                          text );
+    }
+    out << fmt::format( "{:>10} {:>10} {:>6.2f} {:>8} {:>8} {:>6}  total\n",
+                        total.instructions, total.cycles, 100.0,
+                        total.cache_hits, total.cache_misses, "" );
+  }
+
+  void reset() { m_counters.assign( m_counters.size(), PcCounters() ); }
+};
+}  // namespace cpu
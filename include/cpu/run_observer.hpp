@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cpu/cycle_cause.hpp>
+#include <cpu/trace_record.hpp>
+#include <cstdint>
+
+namespace cpu {
+struct State;
+
+// What CPU::run tells its observers about an executed instruction
+struct InstructionEvent {
+  TraceRecord trace;  // PC, encoding, data address and hits
+  std::int32_t next_pc = 0;
+  std::int64_t cycles = 0;
+  CycleBreakdown cycle_causes{};
+  // Of the fetch and data access together, write hits are not counted
+  std::int64_t cache_hits = 0;
+  std::int64_t cache_misses = 0;
+};
+
+// Watches a CPU::run, any number of observers can watch the same run.
+// They are called in the order they were passed, after the state has been
+// updated.
+struct RunObserver {
+  virtual ~RunObserver() = default;
+
+  // Before the first instruction of the run
+  virtual void start( const State& ) {}
+  virtual void retire( const State& state,
+                       const InstructionEvent& instruction ) = 0;
+  // After the last instruction of the run, halted if the program ended
+  virtual void finish( const State&, bool ) {}
+};
+}  // namespace cpu
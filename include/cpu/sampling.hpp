@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+namespace cpu {
+// Systematic sampling ( SMARTS ). Every period instructions the CPU runs
+//   period - warmup - window  functionally, only keeping caches warm
+//                             ( CPU::fastForward )
+//   warmup                    in detail, not measured
+//   window                    in detail, measured as one CPI sample
+struct SamplingConfig {
+  std::int64_t period = 10000;
+  std::int64_t warmup = 100;
+  std::int64_t window = 1000;
+  double confidence = 0.997;  // Of the reported intervals
+
+  void validate() const {
+    if ( window <= 0 || warmup < 0 || warmup + window > period ) {
+      throw std::invalid_argument(
+          "Sampling needs 0 < window and warmup + window <= period" );
+    }
+    if ( confidence <= 0 || confidence >= 1 ) {
+      throw std::invalid_argument( "Sampling confidence must be in (0, 1)" );
+    }
+  }
+};
+
+// Estimate from the measured windows. The intervals are mean +- error.
+struct SamplingResult {
+  std::int64_t instructions = 0;           // Executed in total
+  std::int64_t measured_instructions = 0;  // In measurement windows
+  std::int64_t num_samples = 0;
+  double confidence = 0;
+  double cpi = 0;
+  double cpi_error = 0;
+  double cycles = 0;  // Estimated for the whole run
+  double cycles_error = 0;
+
+  // Relative half width of the CPI interval
+  double getRelativeError() const { return cpi == 0 ? 0 : cpi_error / cpi; }
+};
+
+// Running mean and variance of the window CPIs ( Welford )
+struct SampleAccumulator {
+ private:
+  std::int64_t m_count = 0;
+  double m_mean = 0;
+  double m_squared_diff = 0;
+
+ public:
+  void add( double value ) {
+    m_count++;
+    double delta = value - m_mean;
+    m_mean += delta / m_count;
+    m_squared_diff += delta * ( value - m_mean );
+  }
+
+  std::int64_t getCount() const { return m_count; }
+  double getMean() const { return m_mean; }
+  double getVariance() const {
+    return m_count < 2 ? 0 : m_squared_diff / ( m_count - 1 );
+  }
+
+  SamplingResult getResult( std::int64_t instructions,
+                            std::int64_t measured_instructions,
+                            double confidence ) const {
+    SamplingResult result;
+    result.instructions = instructions;
+    result.measured_instructions = measured_instructions;
+    result.num_samples = m_count;
+    result.confidence = confidence;
+    result.cpi = m_mean;
+    if ( m_count > 0 ) {
+      result.cpi_error = zScore( confidence ) *
+                         std::sqrt( getVariance() / double( m_count ) );
+    }
+    result.cycles = result.cpi * instructions;
+    result.cycles_error = result.cpi_error * instructions;
+    return result;
+  }
+
+  // z such that a standard normal lies within +-z with probability confidence
+  static double zScore( double confidence ) {
+    double low = 0;
+    double high = 40;
+    for ( auto i = 0; i < 100; i++ ) {
+      double middle = ( low + high ) / 2;
+      if ( std::erf( middle / std::sqrt( 2.0 ) ) < confidence ) {
+        low = middle;
+      } else {
+        high = middle;
+      }
+    }
+    return ( low + high ) / 2;
+  }
+};
+}  // namespace cpu
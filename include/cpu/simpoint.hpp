@@ -0,0 +1,345 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cpu/bbv_profiler.hpp>
+#include <cpu/checkpoint.hpp>
+#include <cpu/simulator.hpp>
+#include <cstdint>
+#include <limits>
+#include <numbers>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace cpu {
+// Interval chosen to represent a cluster of similar intervals, weight is
+// the fraction of all intervals in the cluster
+struct SimulationPoint {
+  std::int64_t interval;
+  double weight;
+};
+
+struct SimPointConfig {
+  std::int32_t max_k = 10;
+  std::int32_t dimensions = 15;  // Of the random projection
+  std::int32_t max_iterations = 100;
+  std::uint32_t seed = 1;
+  // Smallest k whose BIC reaches this fraction of the observed BIC range
+  double bic_threshold = 0.9;
+};
+
+// Whole program numbers extrapolated from the simulation points
+struct SimPointEstimate {
+  std::int64_t instructions = 0;
+  double cpi = 0;
+  double cycles = 0;
+  double miss_rate = 0;
+};
+
+// SimPoint phase selection: basic block vectors are normalised, randomly
+// projected to a few dimensions and clustered with k-means for every k up
+// to max_k, and the clustering is picked by its Bayesian information
+// criterion.
+struct SimPoint {
+  using Point = std::vector<double>;
+
+  static std::vector<SimulationPoint> select(
+      const std::vector<BasicBlockVector>& intervals, std::int32_t num_blocks,
+      const SimPointConfig& config = SimPointConfig() ) {
+    if ( intervals.empty() ) {
+      return {};
+    }
+    std::mt19937 rng( config.seed );
+    std::vector<Point> data =
+        project( intervals, num_blocks, config.dimensions, rng );
+
+    std::int32_t max_k =
+        std::min<std::int32_t>( config.max_k, intervals.size() );
+    std::vector<std::vector<std::int32_t>> assignments( max_k + 1 );
+    std::vector<double> scores( max_k + 1 );
+    for ( auto k = 1; k <= max_k; k++ ) {
+      std::vector<Point> centroids;
+      assignments[k] = kMeans( data, k, config.max_iterations, rng, centroids );
+      scores[k] = bic( data, assignments[k], centroids );
+    }
+
+    auto [min_score, max_score] =
+        std::minmax_element( scores.begin() + 1, scores.end() );
+    std::int32_t best_k = 1;
+    while ( scores[best_k] < *min_score + config.bic_threshold *
+                                              ( *max_score - *min_score ) ) {
+      best_k++;
+    }
+    return pickPoints( data, assignments[best_k], best_k );
+  }
+
+  // Fast forwards cpu ( with the program loaded, not yet started ) to each
+  // point with functional warming and simulates that interval in detail on
+  // a fork of it
+  static SimPointEstimate estimate( CPU cpu,
+                                    std::vector<SimulationPoint> points,
+                                    std::int64_t interval_length,
+                                    std::int64_t total_instructions ) {
+    sortPoints( points );
+    SimPointEstimate result;
+    double total_weight = 0;
+    std::int64_t position = 0;
+    for ( auto& point : points ) {
+      position +=
+          cpu.fastForward( point.interval * interval_length - position );
+      CPU detailed = cpu.fork();
+      measure( detailed, point.weight, interval_length, result, total_weight );
+    }
+    return finish( result, total_weight, total_instructions );
+  }
+
+  // Fast forwards cpu like estimate and saves the warmed state at the start
+  // of each point to checkpoint_dir/simpoint_<interval>.ckp
+  static void writeCheckpoints( CPU cpu, std::vector<SimulationPoint> points,
+                                std::int64_t interval_length,
+                                const std::string& checkpoint_dir ) {
+    sortPoints( points );
+    std::int64_t position = 0;
+    for ( auto& point : points ) {
+      position +=
+          cpu.fastForward( point.interval * interval_length - position );
+      Checkpoint::save( cpu.getSystemState(),
+                        getCheckpointName( checkpoint_dir, point.interval ) );
+    }
+  }
+
+  // Like estimate, restoring each point from the checkpoints written by
+  // writeCheckpoints instead of fast forwarding to it
+  static SimPointEstimate estimateFromCheckpoints(
+      const std::vector<SimulationPoint>& points,
+      std::int64_t interval_length, std::int64_t total_instructions,
+      const std::string& checkpoint_dir ) {
+    SimPointEstimate result;
+    double total_weight = 0;
+    for ( auto& point : points ) {
+      CPU detailed( Checkpoint::load(
+          getCheckpointName( checkpoint_dir, point.interval ) ) );
+      measure( detailed, point.weight, interval_length, result, total_weight );
+    }
+    return finish( result, total_weight, total_instructions );
+  }
+
+  static std::string getCheckpointName( const std::string& checkpoint_dir,
+                                        std::int64_t interval ) {
+    return checkpoint_dir + "/simpoint_" + std::to_string( interval ) +
+           ".ckp";
+  }
+
+ private:
+  static void sortPoints( std::vector<SimulationPoint>& points ) {
+    std::sort( points.begin(), points.end(),
+               []( auto& a, auto& b ) { return a.interval < b.interval; } );
+  }
+
+  // Runs one interval of cpu in detail and adds its weighted CPI and miss
+  // rate to result
+  static void measure( CPU& cpu, double weight, std::int64_t interval_length,
+                       SimPointEstimate& result, double& total_weight ) {
+    State& state = cpu.getSystemState();
+    state.instr_stats.reset();
+    std::int64_t accesses = state.cache_hits + state.cache_miss;
+    std::int64_t misses = state.cache_miss;
+    std::int64_t executed = cpu.run( interval_length );
+    if ( executed == 0 ) {
+      return;
+    }
+    accesses = state.cache_hits + state.cache_miss - accesses;
+    misses = state.cache_miss - misses;
+    std::int64_t cycles = state.instr_stats.cycles;
+
+    result.cpi += weight * cycles / double( executed );
+    if ( accesses != 0 ) {
+      result.miss_rate += weight * misses / double( accesses );
+    }
+    total_weight += weight;
+  }
+
+  static SimPointEstimate finish( SimPointEstimate result,
+                                  double total_weight,
+                                  std::int64_t total_instructions ) {
+    if ( total_weight > 0 ) {
+      result.cpi /= total_weight;
+      result.miss_rate /= total_weight;
+    }
+    result.instructions = total_instructions;
+    result.cycles = result.cpi * total_instructions;
+    return result;
+  }
+
+  static double distance2( const Point& a, const Point& b ) {
+    double sum = 0;
+    for ( std::size_t i = 0; i < a.size(); i++ ) {
+      sum += ( a[i] - b[i] ) * ( a[i] - b[i] );
+    }
+    return sum;
+  }
+
+  // Each vector is normalised to sum to 1, then multiplied by a random
+  // num_blocks x dimensions matrix with entries in [-1, 1]
+  static std::vector<Point> project(
+      const std::vector<BasicBlockVector>& intervals, std::int32_t num_blocks,
+      std::int32_t dimensions, std::mt19937& rng ) {
+    std::uniform_real_distribution<double> uniform( -1, 1 );
+    std::vector<Point> matrix( num_blocks, Point( dimensions ) );
+    for ( auto& row : matrix ) {
+      for ( auto& value : row ) {
+        value = uniform( rng );
+      }
+    }
+
+    std::vector<Point> data;
+    data.reserve( intervals.size() );
+    for ( auto& interval : intervals ) {
+      Point& point = data.emplace_back( dimensions, 0.0 );
+      double total = interval.getTotal();
+      for ( auto& [block, count] : interval.counts ) {
+        if ( block < 0 || block >= num_blocks ) {
+          throw std::out_of_range( "Basic block id out of range" );
+        }
+        for ( auto i = 0; i < dimensions; i++ ) {
+          point[i] += matrix[block][i] * count / total;
+        }
+      }
+    }
+    return data;
+  }
+
+  // Returns the cluster of every point, k-means++ seeding
+  static std::vector<std::int32_t> kMeans( const std::vector<Point>& data,
+                                           std::int32_t k,
+                                           std::int32_t max_iterations,
+                                           std::mt19937& rng,
+                                           std::vector<Point>& centroids ) {
+    centroids.assign( 1, data[rng() % data.size()] );
+    std::vector<double> nearest( data.size() );
+    while ( std::int32_t( centroids.size() ) < k ) {
+      for ( std::size_t i = 0; i < data.size(); i++ ) {
+        nearest[i] = std::numeric_limits<double>::max();
+        for ( auto& centroid : centroids ) {
+          nearest[i] = std::min( nearest[i], distance2( data[i], centroid ) );
+        }
+      }
+      // Points far from every centroid are more likely to be picked
+      if ( std::all_of( nearest.begin(), nearest.end(),
+                        []( double d ) { return d == 0; } ) ) {
+        centroids.push_back( data[rng() % data.size()] );
+      } else {
+        std::discrete_distribution<std::size_t> choose( nearest.begin(),
+                                                        nearest.end() );
+        centroids.push_back( data[choose( rng )] );
+      }
+    }
+
+    std::vector<std::int32_t> assignment( data.size(), -1 );
+    for ( auto iteration = 0; iteration < max_iterations; iteration++ ) {
+      bool changed = false;
+      for ( std::size_t i = 0; i < data.size(); i++ ) {
+        std::int32_t best = 0;
+        for ( auto c = 1; c < k; c++ ) {
+          if ( distance2( data[i], centroids[c] ) <
+               distance2( data[i], centroids[best] ) ) {
+            best = c;
+          }
+        }
+        changed |= assignment[i] != best;
+        assignment[i] = best;
+      }
+      if ( !changed ) {
+        break;
+      }
+
+      std::vector<Point> sums( k, Point( data[0].size(), 0.0 ) );
+      std::vector<std::int64_t> sizes( k, 0 );
+      for ( std::size_t i = 0; i < data.size(); i++ ) {
+        sizes[assignment[i]]++;
+        for ( std::size_t d = 0; d < data[i].size(); d++ ) {
+          sums[assignment[i]][d] += data[i][d];
+        }
+      }
+      for ( auto c = 0; c < k; c++ ) {
+        if ( sizes[c] == 0 ) {
+          continue;  // Keeps its old centroid
+        }
+        for ( auto& value : sums[c] ) {
+          value /= sizes[c];
+        }
+        centroids[c] = std::move( sums[c] );
+      }
+    }
+    return assignment;
+  }
+
+  // Spherical Gaussian BIC as used by X-means and SimPoint, higher is better
+  static double bic( const std::vector<Point>& data,
+                     const std::vector<std::int32_t>& assignment,
+                     const std::vector<Point>& centroids ) {
+    double num_points = data.size();
+    double k = centroids.size();
+    double dimensions = data[0].size();
+    std::vector<double> sizes( centroids.size(), 0 );
+    double squared_error = 0;
+    for ( std::size_t i = 0; i < data.size(); i++ ) {
+      sizes[assignment[i]]++;
+      squared_error += distance2( data[i], centroids[assignment[i]] );
+    }
+    double variance =
+        num_points > k ? squared_error / ( num_points - k ) : 0;
+    variance = std::max( variance, 1e-12 );
+
+    double log_likelihood = 0;
+    for ( double size : sizes ) {
+      if ( size == 0 ) {
+        continue;
+      }
+      log_likelihood += size * std::log( size ) -
+                        size * std::log( num_points ) -
+                        size / 2 * std::log( 2 * std::numbers::pi * variance ) -
+                        ( size - 1 ) * dimensions / 2;
+    }
+    double num_parameters = ( k - 1 ) + dimensions * k + 1;
+    return log_likelihood - num_parameters / 2 * std::log( num_points );
+  }
+
+  // The interval closest to each non empty cluster's centre
+  static std::vector<SimulationPoint> pickPoints(
+      const std::vector<Point>& data,
+      const std::vector<std::int32_t>& assignment, std::int32_t k ) {
+    std::vector<Point> centres( k, Point( data[0].size(), 0.0 ) );
+    std::vector<std::int64_t> sizes( k, 0 );
+    for ( std::size_t i = 0; i < data.size(); i++ ) {
+      sizes[assignment[i]]++;
+      for ( std::size_t d = 0; d < data[i].size(); d++ ) {
+        centres[assignment[i]][d] += data[i][d];
+      }
+    }
+
+    std::vector<SimulationPoint> points;
+    for ( auto c = 0; c < k; c++ ) {
+      if ( sizes[c] == 0 ) {
+        continue;
+      }
+      for ( auto& value : centres[c] ) {
+        value /= sizes[c];
+      }
+      std::int64_t closest = -1;
+      for ( std::size_t i = 0; i < data.size(); i++ ) {
+        if ( assignment[i] == c &&
+             ( closest < 0 || distance2( data[i], centres[c] ) <
+                                  distance2( data[closest], centres[c] ) ) ) {
+          closest = i;
+        }
+      }
+      points.push_back( { closest, sizes[c] / double( data.size() ) } );
+    }
+    sortPoints( points );
+    return points;
+  }
+};
+}  // namespace cpu
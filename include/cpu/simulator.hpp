@@ -4,16 +4,30 @@
 #include <cpu/decoder/connection_info.hpp>
 #include <cpu/decoder/decoder.hpp>
 #include <cpu/executor..hpp>
+#include <cpu/run_observer.hpp>
+#include <cpu/sampling.hpp>
 #include <cpu/state.hpp>
+#include <cpu/timing_config.hpp>
+#include <cpu/trace_record.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <isa/encoding.hpp>
+#include <isa/isa_table.hpp>
 #include <memory/common_enums.hpp>
 #include <memory/memory_manager.hpp>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace cpu {
 
 struct CPU {
  private:
   State sys_state;
+  // Decoded program for fastForward, by PC / 4. Entries with instr_id -1
+  // are not decoded yet, all are dropped when code_version changes.
+  std::vector<ConnectionInfo> m_decoded;
+  std::int64_t m_decoded_version = -1;
 
  public:
   CPU( const std::int32_t main_mem_size = 512,
@@ -21,34 +35,190 @@ struct CPU {
        memory::CacheWritePolicy write_policy =
            memory::CacheWritePolicy::WRITEBACK,
        memory::CacheReplacementPolicy replacement_policy =
-           memory::CacheReplacementPolicy::FIFO )
+           memory::CacheReplacementPolicy::FIFO,
+       const TimingConfig& timing_config = TimingConfig() )
       : sys_state( main_mem_size, cache_size, block_size, write_policy,
-                   replacement_policy )
+                   replacement_policy, timing_config )
 
   {}
 
+  // Continues from an existing state, e.g. one restored from a checkpoint
+  CPU( const State& state ) : sys_state( state ) {}
+
   void runProgram( const std::string& program, const char delim = 0 ) {
     loadProgram( program, delim );
-    // Logic for this needs to be changed
-    while ( sys_state.PC != sys_state.halt_adr ) {
-      // Reset cycles consumed for every new instruction
-      sys_state.cycles_consumed = 0;
-      // fetch Instruction
-      sys_state.IR = fetchInstruction();
-      // Decode Instruction and Get Connection Information
-      auto [cycles_consumed, conn_info] = Decoder::decode( sys_state.IR );
-      sys_state.cycles_consumed += cycles_consumed;
-      // Execute Instruction
-      Executor::execute( sys_state, conn_info );
-
-      sys_state.instr_cycles_consumed.push_back( sys_state.cycles_consumed );
+    run();
+  }
+
+  void runProgram( const std::string& program,
+                   const std::vector<RunObserver*>& observers,
+                   const char delim = 0 ) {
+    loadProgram( program, delim );
+    run( observers );
+  }
+
+  // Runs the loaded program from the current state until it halts or
+  // max_instructions have been executed ( negative for no limit ). Returns
+  // the number of instructions executed.
+  std::int64_t run( std::int64_t max_instructions = -1 ) {
+    return run( std::vector<RunObserver*>(), max_instructions );
+  }
+
+  // Like run, passing every instruction to each of observers
+  std::int64_t run( const std::vector<RunObserver*>& observers,
+                    std::int64_t max_instructions = -1 ) {
+    for ( RunObserver* observer : observers ) {
+      observer->start( sys_state );
+    }
+    std::int64_t num_executed = 0;
+    InstructionEvent instruction;
+    TraceRecord* trace = observers.empty() ? nullptr : &instruction.trace;
+    while ( !isHalted() && num_executed != max_instructions ) {
+      std::int64_t hits = sys_state.cache_hits;
+      std::int64_t misses = sys_state.cache_miss;
+      instruction.cycles = step( true, trace );
+      num_executed++;
+      if ( !trace ) {
+        continue;
+      }
+      instruction.next_pc = sys_state.PC;
+      instruction.cycle_causes = sys_state.cycle_causes;
+      instruction.cache_hits = sys_state.cache_hits - hits;
+      instruction.cache_misses = sys_state.cache_miss - misses;
+      for ( RunObserver* observer : observers ) {
+        observer->retire( sys_state, instruction );
+      }
     }
+    for ( RunObserver* observer : observers ) {
+      observer->finish( sys_state, isHalted() );
+    }
+    return num_executed;
   }
 
+  // Executes up to num_instructions functionally: registers and memory are
+  // updated, but nothing is timed or counted and each instruction is only
+  // decoded the first time its PC is reached. With warm_caches the cache
+  // ends up as after detailed execution ( functional warming ), otherwise
+  // it is left alone. IR is not updated. Returns the number of
+  // instructions executed.
+  std::int64_t fastForward( std::int64_t num_instructions,
+                            bool warm_caches = true ) {
+    memory::MemoryManager& memory_manager = sys_state.memory_manager;
+    memory::MemoryManager::Mode mode = memory_manager.getMode();
+    memory_manager.setMode( warm_caches ? memory::MemoryManager::WARMING
+                                        : memory::MemoryManager::FUNCTIONAL );
+    std::int64_t num_executed = 0;
+    try {
+      for ( ; num_executed < num_instructions && !isHalted();
+            num_executed++ ) {
+        Executor::execute( sys_state, fetchDecoded() );
+      }
+    } catch ( ... ) {
+      memory_manager.setMode( mode );
+      throw;
+    }
+    memory_manager.setMode( mode );
+    return num_executed;
+  }
+
+  SamplingResult runProgram( const std::string& program,
+                             const SamplingConfig& config,
+                             const char delim = 0 ) {
+    loadProgram( program, delim );
+    return runSampled( config );
+  }
+
+  // Runs the loaded program to the end with systematic sampling, see
+  // SamplingConfig. Between the windows the program is fast forwarded with
+  // functional warming, so only the warmup and window instructions are
+  // timed and counted. Instructions are not added to instr_stats.
+  SamplingResult runSampled( const SamplingConfig& config ) {
+    config.validate();
+    SampleAccumulator samples;
+    std::int64_t num_executed = 0;
+    std::int64_t num_measured = 0;
+
+    // Executes up to count instructions in detail, returns how many ran and
+    // their cycles
+    auto run_phase = [&]( std::int64_t count ) {
+      std::pair<std::int64_t, std::int64_t> executed{ 0, 0 };
+      for ( ; executed.first < count && !isHalted(); executed.first++ ) {
+        executed.second += step();
+      }
+      num_executed += executed.first;
+      return executed;
+    };
+
+    // A window cut short by the end of the program is only used if there
+    // is no complete one
+    std::pair<std::int64_t, std::int64_t> partial_window{ 0, 0 };
+    while ( !isHalted() ) {
+      num_executed +=
+          fastForward( config.period - config.warmup - config.window );
+      run_phase( config.warmup );
+      auto [instructions, cycles] = run_phase( config.window );
+      if ( instructions == config.window ) {
+        samples.add( cycles / double( instructions ) );
+        num_measured += instructions;
+      } else if ( instructions > 0 ) {
+        partial_window = { instructions, cycles };
+      }
+    }
+    if ( samples.getCount() == 0 && partial_window.first > 0 ) {
+      samples.add( partial_window.second / double( partial_window.first ) );
+      num_measured += partial_window.first;
+    }
+    return samples.getResult( num_executed, num_measured, config.confidence );
+  }
+
+  bool isHalted() { return sys_state.PC == sys_state.halt_adr; }
+
+  // Independent CPU continuing from this one's state, see State::fork
+  CPU fork() const { return CPU( *this ); }
+
   State& getSystemState() { return sys_state; }
 
+  // Executes one instruction, returns the cycles it consumed. It is added
+  // to instr_stats if record is set and described in trace if given.
+  std::int64_t step( bool record = false, TraceRecord* trace = nullptr ) {
+    std::int32_t pc = sys_state.PC;
+    std::int64_t misses = sys_state.cache_miss;
+    // Reset cycles consumed for every new instruction
+    sys_state.startInstruction();
+    // fetch Instruction
+    sys_state.IR = fetchInstruction();
+    // Decode Instruction and Get Connection Information
+    auto [decode_stages, conn_info] = Decoder::decode( sys_state.IR );
+    sys_state.charge( DECODE, decode_stages * sys_state.timing.decode_time );
+    if ( trace ) {
+      const isa::InstrDesc& desc =
+          isa::IsaTable::instructions[conn_info.instr_id];
+      trace->pc = pc;
+      trace->word = isa::Encoding::toWord( sys_state.IR );
+      trace->has_address =
+          desc.semantics == isa::Load || desc.semantics == isa::Store;
+      trace->is_store = desc.semantics == isa::Store;
+      trace->address = Executor::getEffectiveAddress( sys_state, conn_info );
+      // Write hits are not counted, so hits are told apart by the misses
+      trace->fetch_hit = sys_state.cache_miss == misses;
+      misses = sys_state.cache_miss;
+    }
+    // Execute Instruction
+    Executor::execute( sys_state, conn_info );
+    if ( trace ) {
+      trace->data_hit = trace->has_address && sys_state.cache_miss == misses;
+    }
+    if ( record ) {
+      sys_state.instr_stats.record( pc, conn_info.instr_id,
+                                    sys_state.cycles_consumed,
+                                    sys_state.cycle_causes );
+    }
+    return sys_state.cycles_consumed;
+  }
+
   std::string fetchInstruction() {
-    std::string instruction( sys_state.memory_manager.read( sys_state.PC, 4 ) );
+    std::string instruction(
+        sys_state.memory_manager.read( sys_state.PC, 4, true ) );
     sys_state.PC += 4;
     // sys_state.cycles_consumed += sys_state.memory_access_latency;
     return instruction;
@@ -67,6 +237,29 @@ struct CPU {
 
     sys_state.cache_miss = 0;
     sys_state.total_instructions = program_string.size() / ( 4 * 8 );
+    sys_state.code_version++;
+  }
+
+ private:
+  // Fetches the instruction at PC like fetchInstruction, but decodes it
+  // only if it has not been decoded before
+  ConnectionInfo fetchDecoded() {
+    if ( m_decoded_version != sys_state.code_version ) {
+      m_decoded.assign( std::max( sys_state.halt_adr, 0 ) / 4,
+                        ConnectionInfo() );
+      m_decoded_version = sys_state.code_version;
+    }
+    std::size_t index = std::uint32_t( sys_state.PC ) >> 2;
+    if ( index < m_decoded.size() && m_decoded[index].instr_id != -1 ) {
+      sys_state.memory_manager.touch( sys_state.PC );
+      sys_state.PC += 4;
+      return m_decoded[index];
+    }
+    ConnectionInfo info = Decoder::decode( fetchInstruction() ).second;
+    if ( index < m_decoded.size() ) {
+      m_decoded[index] = info;
+    }
+    return info;
   }
 };
 
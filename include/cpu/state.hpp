@@ -3,10 +3,16 @@
 #include <fmt/core.h>
 #include <fmt/format.h>
 
-#include <cpu/state.hpp>
+#include <common/stats_registry.hpp>
+#include <cpu/instruction_stats.hpp>
+#include <cpu/state_data.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <isa/isa_table.hpp>
 #include <iostream>
 #include <memory/common_enums.hpp>
 #include <memory/memory_manager.hpp>
+#include <ostream>
 #include <string>
 #include <vector>
 
@@ -17,34 +23,123 @@ struct State : public StateData {
 
   State( std::int32_t memory_size, std::int32_t cache_size,
          std::int32_t block_size, memory::CacheWritePolicy write_policy,
-         memory::CacheReplacementPolicy replacement_policy )
-      : memory_manager( memory_size, cache_size, block_size, write_policy,
+         memory::CacheReplacementPolicy replacement_policy,
+         const TimingConfig& timing_config = TimingConfig() )
+      : StateData( timing_config ),
+        memory_manager( memory_size, cache_size, block_size, write_policy,
                         replacement_policy, (StateData*)this ) {}
 
+  // Copies share main memory pages until either side writes to them
+  State( const State& other )
+      : StateData( other ),
+        memory_manager( other.memory_manager, (StateData*)this ) {}
+  State& operator=( const State& ) = delete;
+
+  // Independent copy of this state, cheap as long as little memory is
+  // written afterwards. Registers, counters and the cache are copied.
+  State fork() const { return State( *this ); }
+
+  // Registers every statistic of the CPU and its memory system. The
+  // registry refers to this state and must not outlive it.
+  void registerStats( common::StatsRegistry& stats ) const {
+    stats.addCounter( "cpu.program_instructions", total_instructions,
+                      "Instructions in the loaded program" );
+    stats.addCounter( "cpu.instructions", instr_stats.instructions,
+                      "Executed instructions" );
+    stats.addCounter( "cpu.cycles", instr_stats.cycles );
+    stats.addFormula( "cpu.cpi", [this]() { return instr_stats.getCPI(); },
+                      "Cycles per instruction" );
+    for ( std::size_t i = 0; i < isa::IsaTable::size(); i++ ) {
+      std::string prefix =
+          fmt::format( "cpu.opcode.{}", isa::IsaTable::instructions[i].name );
+      stats.addCounter( prefix + ".count", instr_stats.opcode_counts[i] );
+      stats.addCounter( prefix + ".cycles", instr_stats.opcode_cycles[i] );
+    }
+    for ( std::size_t i = 0; i < num_cycle_causes; i++ ) {
+      std::string name = fmt::format( "cpu.cpi_stack.{}", CpiStack::names[i] );
+      stats.addCounter( name + ".cycles", instr_stats.cause_cycles[i] );
+      stats.addFormula( name + ".cpi", [this, i]() {
+        return instr_stats.getCpiStack().getCPI( CycleCause( i ) );
+      } );
+    }
+    // Zero padded so the buckets sort in order
+    for ( std::size_t b = 0; b < InstructionStats::num_buckets; b++ ) {
+      std::uint64_t low = b == 0 ? 0 : std::uint64_t( 1 ) << ( b - 1 );
+      stats.addCounter(
+          fmt::format( "cpu.latency.bucket_{:02}", b ),
+          instr_stats.latency_histogram[b],
+          b == 0 ? "Instructions taking no cycles"
+                 : fmt::format( "Instructions taking {} to {} cycles", low,
+                                ( low << 1 ) - 1 ) );
+    }
+    for ( auto name : TimingConfig::getParameterNames() ) {
+      stats.addFormula( fmt::format( "timing.{}", name ),
+                        [this, name]() { return timing.get( name ); } );
+    }
+    memory_manager.registerStats( stats );
+  }
+
+  common::StatsRegistry getStats() const {
+    common::StatsRegistry stats;
+    registerStats( stats );
+    return stats;
+  }
+
+  void dumpStats( std::ostream& output,
+                  common::StatsRegistry::Format format ) const {
+    getStats().write( output, format );
+  }
+
   void dumpState() {
+    const memory::CacheMemory& cache = memory_manager.getCacheMemoryRef();
     fmt::print( "Main Memory Size : {}\n",
-                memory_manager.getMainMemory().getSize() );
+                memory_manager.getMainMemoryRef().getSize() );
     fmt::print( "Total Instructions : {}\n", total_instructions );
-    for ( auto i = 0; i < instr_cycles_consumed.size(); i++ ) {
-      fmt::print( "\t Instr {} : {}\n", i, instr_cycles_consumed[i] );
+    fmt::print( "Executed Instructions : {}\n", instr_stats.instructions );
+    fmt::print( "Total Cycles : {}\n", instr_stats.cycles );
+    fmt::print( "CPI : {}\n", instr_stats.getCPI() );
+    for ( std::size_t i = 0; i < isa::IsaTable::size(); i++ ) {
+      if ( instr_stats.opcode_counts[i] != 0 ) {
+        fmt::print( "\t {} : {} instructions, {} cycles\n",
+                    isa::IsaTable::instructions[i].name,
+                    instr_stats.opcode_counts[i],
+                    instr_stats.opcode_cycles[i] );
+      }
     }
-    fmt::print( "Memory access latency : {}\n", memory_access_latency );
-    fmt::print( "Decode time : {}\n", decode_time );
-    fmt::print( "Execute time : {}\n", execute_time );
+    CpiStack cpi_stack = instr_stats.getCpiStack();
+    fmt::print( "CPI Stack ( cause : cycles, CPI )\n" );
+    for ( std::size_t i = 0; i < num_cycle_causes; i++ ) {
+      fmt::print( "\t {} : {}, {:.4f}\n", CpiStack::names[i],
+                  cpi_stack.cycles[i], cpi_stack.getCPI( CycleCause( i ) ) );
+    }
+    fmt::print( "Latency Histogram ( cycles : instructions )\n" );
+    for ( std::size_t b = 0; b < InstructionStats::num_buckets; b++ ) {
+      if ( instr_stats.latency_histogram[b] != 0 ) {
+        std::uint64_t low = b == 0 ? 0 : std::uint64_t( 1 ) << ( b - 1 );
+        std::uint64_t high = b == 0 ? 0 : ( low << 1 ) - 1;
+        fmt::print( "\t {} - {} : {}\n", low, high,
+                    instr_stats.latency_histogram[b] );
+      }
+    }
+    fmt::print( "Memory access latency : {}\n", timing.memory_access_latency );
+    fmt::print( "Decode time : {}\n", timing.decode_time );
+    fmt::print( "ALU latency : {}\n", timing.alu_latency );
+    fmt::print( "Branch latency ( taken / not taken ) : {} / {}\n",
+                timing.branch_taken_latency, timing.branch_not_taken_latency );
+    fmt::print( "Load / Store latency : {} / {}\n", timing.load_latency,
+                timing.store_latency );
+    fmt::print( "Jump latency : {}\n", timing.jump_latency );
     fmt::print( "Cache Stats\n-----------------\n" );
-    fmt::print( "Cache Size : {}\n",
-                memory_manager.getCacheMemory().getCacheSize() );
-    fmt::print( "Block Size : {}\n",
-                memory_manager.getCacheMemory().getBlockSize() );
-    fmt::print( "Num Blocks : {}\n",
-                memory_manager.getCacheMemory().getNumofBlocks() );
+    fmt::print( "Cache Size : {}\n", cache.getCacheSize() );
+    fmt::print( "Block Size : {}\n", cache.getBlockSize() );
+    fmt::print( "Num Blocks : {}\n", cache.getNumofBlocks() );
     fmt::print( "Replacement Policy : {}\n",
-                memory_manager.getCacheMemory().getReplacementPolicy() );
+                memory::toString( cache.getReplacementPolicy() ) );
     fmt::print( "WritePolicy : {}\n",
-                memory_manager.getCacheMemory().getWritePolicy() );
+                memory::toString( cache.getWritePolicy() ) );
 
-    fmt::print( "Cache Hit Time : {}\n", cache_hit_time );
-    fmt::print( "Cache Miss Time : {}\n", cache_miss_penalty );
+    fmt::print( "Cache Hit Time : {}\n", timing.cache_hit_time );
+    fmt::print( "Cache Miss Time : {}\n", timing.cache_miss_penalty );
 
     fmt::print( "Cache Hits : {}\n", cache_hits );
     fmt::print( "Cache Misses : {}\n", cache_miss );
@@ -53,6 +148,14 @@ struct State : public StateData {
                 ( cache_hits / float( cache_hits + cache_miss ) * 100 ) );
     fmt::print( "Miss Rate: {}%\n",
                 ( cache_miss / float( cache_hits + cache_miss ) * 100 ) );
+    for ( auto& range : memory_manager.getWatchRanges().getRanges() ) {
+      const memory::RangeCounters& counters = range.counters;
+      fmt::print( "\t {} [{:#x}, {:#x}) : {} reads, {} writes, {} hits, {} "
+                  "misses, {} writebacks\n",
+                  range.name, range.begin, range.end, counters.reads,
+                  counters.writes, counters.hits, counters.misses,
+                  counters.writebacks );
+    }
 
     fmt::print( "\nRegister File Info : \n------------\n" );
 
@@ -1,30 +1,45 @@
 #pragma once
 
+#include <cpu/cycle_cause.hpp>
+#include <cpu/instruction_stats.hpp>
+#include <cpu/timing_config.hpp>
 #include <cstdint>
 #include <string>
-#include <vector>
 
 namespace cpu {
 struct StateData {
-  static const inline std::int32_t memory_access_latency = 10;
-  static const inline std::int32_t decode_time = 1;
-  static const inline std::int32_t execute_time = 1;
-  static const inline std::int32_t cache_hit_time = 10;
-  static const inline std::int32_t cache_miss_penalty = 20;
+  TimingConfig timing;
 
-  std::int32_t cache_hits = 0;
-  std::int32_t cache_miss = 0;
+  std::int64_t cache_hits = 0;
+  std::int64_t cache_miss = 0;
 
-  std::int32_t register_file[31] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  std::int32_t register_file[32] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
                                      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-                                     0, 0, 0, 0, 0, 0, 0, 0, 0 };
+                                     0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
   std::int32_t PC = 0;
   std::string IR = "";
-  std::int32_t halt_adr;
+  std::int32_t halt_adr = 0;
+  // Changed by every write to the program, which ends at halt_adr
+  std::int64_t code_version = 0;
   std::int32_t total_instructions = 0;
 
-  std::int32_t cycles_consumed = 0;
+  std::int64_t cycles_consumed = 0;  // By the current instruction
+  CycleBreakdown cycle_causes{};     // Same, split by cause
 
-  std::vector<std::int32_t> instr_cycles_consumed;
+  InstructionStats instr_stats;
+
+  explicit StateData( const TimingConfig& timing_config = TimingConfig() )
+      : timing( timing_config ) {}
+
+  void startInstruction() {
+    cycles_consumed = 0;
+    cycle_causes = {};
+  }
+
+  // Adds cycles to the current instruction
+  void charge( CycleCause cause, std::int64_t cycles ) {
+    cycles_consumed += cycles;
+    cycle_causes[cause] += cycles;
+  }
 };
 }  // namespace cpu
\ No newline at end of file
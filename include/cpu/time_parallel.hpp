@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <common/thread_pool.hpp>
+#include <cpu/simulator.hpp>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace cpu {
+struct TimeParallelConfig {
+  std::int32_t num_intervals = 0;  // 0 for one per thread
+  std::int32_t num_threads = 0;    // 0 for one per hardware thread
+  // Instructions fast forwarded with functional warming before each
+  // interval to warm up its caches
+  std::int64_t warmup = 1000;
+};
+
+struct IntervalStats {
+  std::int64_t start = 0;
+  std::int64_t instructions = 0;
+  std::int64_t cycles = 0;
+  std::int64_t cache_hits = 0;
+  std::int64_t cache_misses = 0;
+};
+
+// Per interval statistics and their sums
+struct TimeParallelResult {
+  std::vector<IntervalStats> intervals;
+  std::int64_t instructions = 0;
+  std::int64_t cycles = 0;
+  std::int64_t cache_hits = 0;
+  std::int64_t cache_misses = 0;
+
+  double getCPI() const {
+    return instructions == 0 ? 0 : cycles / double( instructions );
+  }
+};
+
+// Simulates one run as intervals in parallel. A functional pass ( no
+// timing, caches untouched ) finds the state at the start of each interval,
+// then every interval is simulated in detail on its own thread after
+// warming its caches functionally over the warmup instructions before it.
+// The first interval starts from the real initial state, so only the caches
+// of later intervals are approximate.
+struct TimeParallelRunner {
+  static TimeParallelResult run( const CPU& cpu,
+                                 const TimeParallelConfig& config ) {
+    if ( config.warmup < 0 ) {
+      throw std::invalid_argument( "Warmup must not be negative" );
+    }
+    common::ThreadPool pool( config.num_threads );
+    std::int32_t num_intervals =
+        config.num_intervals > 0 ? config.num_intervals : pool.size();
+
+    auto [total_instructions, snapshots] =
+        functionalPass( cpu, 4 * num_intervals );
+
+    std::vector<std::int64_t> boundaries;
+    for ( auto i = 0; i <= num_intervals; i++ ) {
+      boundaries.push_back( total_instructions * i / num_intervals );
+    }
+    // Short runs can give empty intervals
+    boundaries.erase( std::unique( boundaries.begin(), boundaries.end() ),
+                      boundaries.end() );
+
+    TimeParallelResult result;
+    result.intervals.resize( boundaries.size() - 1 );
+    pool.parallelFor( result.intervals.size(), [&]( std::size_t i ) {
+      result.intervals[i] = simulateInterval( cpu, snapshots, boundaries[i],
+                                              boundaries[i + 1], config );
+    } );
+
+    for ( auto& interval : result.intervals ) {
+      result.instructions += interval.instructions;
+      result.cycles += interval.cycles;
+      result.cache_hits += interval.cache_hits;
+      result.cache_misses += interval.cache_misses;
+    }
+    return result;
+  }
+
+ private:
+  // Position and the functional state there
+  using Snapshot = std::pair<std::int64_t, std::unique_ptr<CPU>>;
+
+  // Runs cpu to the end functionally, returning the number of instructions
+  // and up to max_snapshots evenly spaced states. The spacing doubles
+  // whenever there would be more.
+  static std::pair<std::int64_t, std::vector<Snapshot>> functionalPass(
+      const CPU& cpu, std::size_t max_snapshots ) {
+    CPU functional = cpu.fork();
+
+    std::vector<Snapshot> snapshots;
+    snapshots.emplace_back( 0, std::make_unique<CPU>( functional ) );
+    std::int64_t spacing = 1;
+    std::int64_t position = 0;
+    while ( !functional.isHalted() ) {
+      position +=
+          functional.fastForward( spacing - position % spacing, false );
+      if ( functional.isHalted() ) {
+        break;
+      }
+      snapshots.emplace_back( position, std::make_unique<CPU>( functional ) );
+      if ( snapshots.size() > max_snapshots ) {
+        spacing *= 2;
+        std::erase_if( snapshots, [spacing]( const Snapshot& snapshot ) {
+          return snapshot.first % spacing != 0;
+        } );
+      }
+    }
+    return { position, std::move( snapshots ) };
+  }
+
+  // State at start, reached from the nearest earlier snapshot with the
+  // caches warmed over the last warmup instructions ( or as many as there
+  // are )
+  static CPU warmStart( const CPU& cpu, const std::vector<Snapshot>& snapshots,
+                        std::int64_t start, std::int64_t warmup ) {
+    if ( start == 0 ) {
+      return cpu.fork();
+    }
+    std::int64_t warm_start = std::max<std::int64_t>( 0, start - warmup );
+    auto snapshot = std::prev( std::upper_bound(
+        snapshots.begin(), snapshots.end(), warm_start,
+        []( std::int64_t value, const Snapshot& snapshot ) {
+          return value < snapshot.first;
+        } ) );
+    CPU warm = snapshot->second->fork();
+    warm.fastForward( warm_start - snapshot->first, false );
+    warm.fastForward( start - warm_start );
+    return warm;
+  }
+
+  static IntervalStats simulateInterval(
+      const CPU& cpu, const std::vector<Snapshot>& snapshots,
+      std::int64_t start, std::int64_t end,
+      const TimeParallelConfig& config ) {
+    CPU detailed = warmStart( cpu, snapshots, start, config.warmup );
+    State& state = detailed.getSystemState();
+    state.instr_stats.reset();
+    std::int64_t hits = state.cache_hits;
+    std::int64_t misses = state.cache_miss;
+
+    IntervalStats stats;
+    stats.start = start;
+    stats.instructions = detailed.run( end - start );
+    stats.cycles = state.instr_stats.cycles;
+    stats.cache_hits = state.cache_hits - hits;
+    stats.cache_misses = state.cache_miss - misses;
+    return stats;
+  }
+};
+}  // namespace cpu
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <fmt/core.h>
+
+#include <array>
+#include <cpu/run_observer.hpp>
+#include <cpu/state.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cpu {
+struct TimeSeriesConfig {
+  enum Unit { INSTRUCTIONS, CYCLES };
+
+  Unit unit = Unit::INSTRUCTIONS;
+  std::int64_t length = 10000;  // Interval length in units
+
+  void validate() const {
+    if ( length <= 0 ) {
+      throw std::invalid_argument( "Interval length must be positive" );
+    }
+  }
+};
+
+// Counters of one interval. instruction / cycle are the run totals at its
+// end, everything else counts only what happened within the interval.
+struct TimeSeriesPoint {
+  std::int64_t interval = 0;
+  std::int64_t instruction = 0;
+  std::int64_t cycle = 0;
+  std::int64_t instructions = 0;
+  std::int64_t cycles = 0;
+  std::int64_t cache_hits = 0;
+  std::int64_t cache_misses = 0;
+  std::int64_t mem_reads = 0;  // Main memory traffic
+  std::int64_t mem_writes = 0;
+  std::int64_t evictions = 0;
+  std::int64_t writebacks = 0;
+
+  static constexpr std::size_t num_fields = 11;
+
+  double getIPC() const {
+    return cycles == 0 ? 0 : instructions / double( cycles );
+  }
+
+  double getHitRate() const {
+    std::int64_t accesses = cache_hits + cache_misses;
+    return accesses == 0 ? 0 : cache_hits / double( accesses );
+  }
+
+  std::array<std::int64_t, num_fields> getFields() const {
+    return { interval,   instruction,  cycle,     instructions, cycles,
+             cache_hits, cache_misses, mem_reads, mem_writes,   evictions,
+             writebacks };
+  }
+
+  static TimeSeriesPoint fromFields(
+      const std::array<std::int64_t, num_fields>& fields ) {
+    return { fields[0], fields[1], fields[2], fields[3],
+             fields[4], fields[5], fields[6], fields[7],
+             fields[8], fields[9], fields[10] };
+  }
+
+  bool operator==( const TimeSeriesPoint& ) const = default;
+};
+
+// Appends points to a stream as they are produced, either as CSV or as
+// fixed size little endian records after a short header
+//   magic "RVSIMTS\0", version, number of fields per record
+// so a run that is cut short still leaves every finished interval behind.
+struct TimeSeriesWriter {
+  enum Format { CSV, BINARY };
+
+  static constexpr std::string_view magic{ "RVSIMTS\0", 8 };
+  static constexpr std::uint32_t version = 1;
+
+ private:
+  std::ostream& m_output;
+  Format m_format;
+
+ public:
+  // Writes the CSV column names or the binary header
+  TimeSeriesWriter( std::ostream& output, Format format = Format::CSV )
+      : m_output( output ), m_format( format ) {
+    if ( m_format == Format::CSV ) {
+      m_output << "interval,instruction,cycle,instructions,cycles,ipc,"
+                  "cache_hits,cache_misses,hit_rate,mem_reads,mem_writes,"
+                  "evictions,writebacks\n";
+    } else {
+      m_output.write( magic.data(), magic.size() );
+      putU32( version );
+      putU32( TimeSeriesPoint::num_fields );
+    }
+    m_output.flush();
+  }
+
+  void write( const TimeSeriesPoint& point ) {
+    if ( m_format == Format::CSV ) {
+      m_output << fmt::format(
+          "{},{},{},{},{},{:.4f},{},{},{:.4f},{},{},{},{}\n", point.interval,
+          point.instruction, point.cycle, point.instructions, point.cycles,
+          point.getIPC(), point.cache_hits, point.cache_misses,
+          point.getHitRate(), point.mem_reads, point.mem_writes,
+          point.evictions, point.writebacks );
+    } else {
+      for ( auto field : point.getFields() ) {
+        putU64( field );
+      }
+    }
+    m_output.flush();
+  }
+
+  // Reads a binary series, a partly written last record is ignored
+  static std::vector<TimeSeriesPoint> readBinary( std::istream& input ) {
+    std::string header( magic.size() + 8, '\0' );
+    if ( !input.read( header.data(), header.size() ) ||
+         std::string_view( header ).substr( 0, magic.size() ) != magic ) {
+      throw std::runtime_error( "Not a time series" );
+    }
+    if ( getU32( header.data() + magic.size() ) != version ||
+         getU32( header.data() + magic.size() + 4 ) !=
+             TimeSeriesPoint::num_fields ) {
+      throw std::runtime_error( "Unsupported time series version" );
+    }
+
+    std::vector<TimeSeriesPoint> points;
+    std::array<char, TimeSeriesPoint::num_fields * 8> record;
+    while ( input.read( record.data(), record.size() ) ) {
+      std::array<std::int64_t, TimeSeriesPoint::num_fields> fields;
+      for ( std::size_t i = 0; i < fields.size(); i++ ) {
+        fields[i] = getU64( record.data() + 8 * i );
+      }
+      points.push_back( TimeSeriesPoint::fromFields( fields ) );
+    }
+    return points;
+  }
+
+ private:
+  void putU32( std::uint32_t value ) {
+    for ( auto i = 0; i < 4; i++ ) {
+      m_output.put( char( value >> ( 8 * i ) ) );
+    }
+  }
+
+  void putU64( std::uint64_t value ) {
+    for ( auto i = 0; i < 8; i++ ) {
+      m_output.put( char( value >> ( 8 * i ) ) );
+    }
+  }
+
+  static std::uint32_t getU32( const char* data ) {
+    std::uint32_t value = 0;
+    for ( auto i = 0; i < 4; i++ ) {
+      value |= std::uint32_t( std::uint8_t( data[i] ) ) << ( 8 * i );
+    }
+    return value;
+  }
+
+  static std::uint64_t getU64( const char* data ) {
+    std::uint64_t value = 0;
+    for ( auto i = 0; i < 8; i++ ) {
+      value |= std::uint64_t( std::uint8_t( data[i] ) ) << ( 8 * i );
+    }
+    return value;
+  }
+};
+
+// Cuts a run into intervals of config.length instructions or cycles and
+// writes a point at the end of each as an observer of CPU::run. retire()
+// only compares one counter against the next boundary, so it is cheap
+// enough to call after every instruction.
+struct TimeSeriesRecorder : RunObserver {
+ private:
+  TimeSeriesWriter& m_writer;
+  TimeSeriesConfig m_config;
+  TimeSeriesPoint m_last;  // Run totals at the end of the last interval
+  std::int64_t m_start = 0;
+  std::int64_t m_next = 0;  // Position of the next boundary
+  std::int64_t m_num_points = 0;
+
+ public:
+  TimeSeriesRecorder( TimeSeriesWriter& writer,
+                      const TimeSeriesConfig& config )
+      : m_writer( writer ), m_config( config ) {
+    m_config.validate();
+  }
+
+  // Starts the first interval at the current state
+  void start( const State& state ) override {
+    m_last = getTotals( state );
+    m_start = getPosition( state );
+    m_next = m_start + m_config.length;
+  }
+
+  void retire( const State& state, const InstructionEvent& ) override {
+    std::int64_t position = getPosition( state );
+    if ( position >= m_next ) {
+      emit( state );
+      // An instruction can span several cycle boundaries
+      m_next = position - ( position - m_start ) % m_config.length +
+               m_config.length;
+    }
+  }
+
+  // Writes the last, partial, interval if it is not empty
+  void finish( const State& state, bool ) override {
+    if ( state.instr_stats.instructions != m_last.instruction ) {
+      emit( state );
+    }
+  }
+
+  std::int64_t getNumPoints() const { return m_num_points; }
+
+ private:
+  std::int64_t getPosition( const State& state ) const {
+    return m_config.unit == TimeSeriesConfig::CYCLES
+               ? state.instr_stats.cycles
+               : state.instr_stats.instructions;
+  }
+
+  static TimeSeriesPoint getTotals( const State& state ) {
+    const memory::MainMemory& main_memory =
+        state.memory_manager.getMainMemoryRef();
+    const memory::CacheMemory& cache = state.memory_manager.getCacheMemoryRef();
+    TimeSeriesPoint totals;
+    totals.instruction = state.instr_stats.instructions;
+    totals.cycle = state.instr_stats.cycles;
+    totals.cache_hits = state.cache_hits;
+    totals.cache_misses = state.cache_miss;
+    totals.mem_reads = main_memory.getNumReads();
+    totals.mem_writes = main_memory.getNumWrites();
+    totals.evictions = cache.getNumEvictions();
+    totals.writebacks = cache.getNumWritebacks();
+    return totals;
+  }
+
+  void emit( const State& state ) {
+    TimeSeriesPoint totals = getTotals( state );
+    TimeSeriesPoint point = totals;
+    point.interval = m_num_points++;
+    point.instructions = totals.instruction - m_last.instruction;
+    point.cycles = totals.cycle - m_last.cycle;
+    point.cache_hits -= m_last.cache_hits;
+    point.cache_misses -= m_last.cache_misses;
+    point.mem_reads -= m_last.mem_reads;
+    point.mem_writes -= m_last.mem_writes;
+    point.evictions -= m_last.evictions;
+    point.writebacks -= m_last.writebacks;
+    m_writer.write( point );
+    m_last = totals;
+  }
+};
+}  // namespace cpu
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <common/string_utils.hpp>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace cpu {
+// Latencies in cycles used by the executor and the memory manager. The
+// defaults reproduce the original fixed timing.
+struct TimingConfig {
+  // Pipeline
+  std::int32_t decode_time = 1;
+
+  // Per instruction class, memory time of loads / stores is added on top
+  std::int32_t alu_latency = 1;  // R type, addi, lui
+  std::int32_t branch_taken_latency = 1;
+  std::int32_t branch_not_taken_latency = 1;
+  std::int32_t load_latency = 0;
+  std::int32_t store_latency = 0;
+  std::int32_t jump_latency = 1;  // jal, jalr
+
+  // Memory hierarchy
+  std::int32_t cache_hit_time = 10;
+  std::int32_t cache_miss_penalty = 20;
+  std::int32_t memory_access_latency = 10;
+
+  // Reads "key = value" lines, keys are the member names above. Blank lines
+  // and text after '#' are ignored, keys that are not given keep their
+  // default value.
+  static TimingConfig fromFile( const std::string& filename ) {
+    std::ifstream file( filename );
+    if ( !file ) {
+      throw std::runtime_error( "Unable to open timing config : " + filename );
+    }
+    TimingConfig config;
+    std::string line;
+    std::int32_t line_number = 0;
+    while ( std::getline( file, line ) ) {
+      line_number++;
+      try {
+        config.parseLine( line );
+      } catch ( const std::invalid_argument& e ) {
+        throw std::invalid_argument( filename + ":" +
+                                     std::to_string( line_number ) + " : " +
+                                     e.what() );
+      }
+    }
+    return config;
+  }
+
+  // Sets a single latency by name
+  void set( std::string_view key, std::int32_t value ) {
+    if ( value < 0 ) {
+      throw std::invalid_argument( "Latency must not be negative : " +
+                                   std::string( key ) );
+    }
+    this->*getMember( key ) = value;
+  }
+
+  std::int32_t get( std::string_view key ) const {
+    return this->*getMember( key );
+  }
+
+  // Keys accepted by set / get / fromFile, in declaration order
+  static std::vector<std::string_view> getParameterNames() {
+    std::vector<std::string_view> names;
+    for ( auto& [name, member] : getMembers() ) {
+      names.push_back( name );
+    }
+    return names;
+  }
+
+ private:
+  using Member = std::int32_t TimingConfig::*;
+
+  using MemberTable = std::array<std::pair<std::string_view, Member>, 10>;
+
+  static const MemberTable& getMembers() {
+    static constexpr MemberTable members{ {
+        { "decode_time", &TimingConfig::decode_time },
+        { "alu_latency", &TimingConfig::alu_latency },
+        { "branch_taken_latency", &TimingConfig::branch_taken_latency },
+        { "branch_not_taken_latency", &TimingConfig::branch_not_taken_latency },
+        { "load_latency", &TimingConfig::load_latency },
+        { "store_latency", &TimingConfig::store_latency },
+        { "jump_latency", &TimingConfig::jump_latency },
+        { "cache_hit_time", &TimingConfig::cache_hit_time },
+        { "cache_miss_penalty", &TimingConfig::cache_miss_penalty },
+        { "memory_access_latency", &TimingConfig::memory_access_latency } } };
+    return members;
+  }
+
+  static Member getMember( std::string_view key ) {
+    for ( auto& [name, member] : getMembers() ) {
+      if ( name == key ) {
+        return member;
+      }
+    }
+    throw std::invalid_argument( "Unknown timing parameter : " +
+                                 std::string( key ) );
+  }
+
+  void parseLine( std::string_view line ) {
+    line = common::trim( line.substr( 0, line.find( '#' ) ) );
+    if ( line.empty() ) {
+      return;
+    }
+    auto equal_pos = line.find( '=' );
+    if ( equal_pos == std::string_view::npos ) {
+      throw std::invalid_argument( "Expected key = value" );
+    }
+    std::string_view key = common::trim( line.substr( 0, equal_pos ) );
+    std::string_view value_str = common::trim( line.substr( equal_pos + 1 ) );
+
+    std::int32_t value = 0;
+    auto [end, error] = std::from_chars(
+        value_str.data(), value_str.data() + value_str.size(), value );
+    if ( error != std::errc() || end != value_str.data() + value_str.size() ) {
+      throw std::invalid_argument( "Invalid value for " + std::string( key ) );
+    }
+    set( key, value );
+  }
+};
+}  // namespace cpu
@@ -0,0 +1,403 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <common/mapped_file.hpp>
+#include <common/spsc_ring.hpp>
+#include <cpu/run_observer.hpp>
+#include <cpu/trace_record.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace cpu {
+// Compact encoding of a chunk of records. Every record is a flag byte
+// followed by only what could not be predicted:
+//   pc      : zigzag varint of pc - ( previous pc + 4 ), unless sequential
+//   word    : varint, unless equal to the last word seen at this pc
+//   address : zigzag varint of address - ( last address at this pc + last
+//             stride at this pc ), unless predicted
+// so a loop over already seen code costs one byte per instruction plus the
+// addresses that do not follow a constant stride. Predictions start from
+// scratch in every chunk, so chunks decode independently.
+struct TraceCodec {
+  enum Flag : std::uint8_t {
+    SEQUENTIAL_PC = 1 << 0,
+    SAME_WORD = 1 << 1,
+    HAS_ADDRESS = 1 << 2,
+    PREDICTED_ADDRESS = 1 << 3,
+    STORE = 1 << 4,
+    FETCH_HIT = 1 << 5,
+    DATA_HIT = 1 << 6,
+  };
+
+ private:
+  struct PcEntry {
+    std::int32_t pc = -1;
+    std::uint32_t word = 0;
+    std::int32_t address = 0;
+    std::int32_t stride = 0;
+  };
+
+  // Direct mapped on the pc, collisions only cost compression
+  static constexpr std::size_t table_size = 4096;
+  std::vector<PcEntry> m_table = std::vector<PcEntry>( table_size );
+  std::int32_t m_last_pc = -4;
+
+ public:
+  void reset() {
+    m_table.assign( table_size, PcEntry() );
+    m_last_pc = -4;
+  }
+
+  void encode( const TraceRecord& record, std::string& output ) {
+    PcEntry& entry = lookup( record.pc );
+    std::uint8_t flags = 0;
+    flags |= record.pc == m_last_pc + 4 ? SEQUENTIAL_PC : 0;
+    bool same_word = entry.pc == record.pc && entry.word == record.word;
+    flags |= same_word ? SAME_WORD : 0;
+    flags |= record.has_address ? HAS_ADDRESS : 0;
+    flags |= record.is_store ? STORE : 0;
+    flags |= record.fetch_hit ? FETCH_HIT : 0;
+    flags |= record.data_hit ? DATA_HIT : 0;
+    std::int32_t predicted = predictAddress( entry, record.pc );
+    if ( record.has_address && record.address == predicted ) {
+      flags |= PREDICTED_ADDRESS;
+    }
+
+    output += char( flags );
+    if ( !( flags & SEQUENTIAL_PC ) ) {
+      std::int64_t pc_delta = std::int64_t( record.pc ) - m_last_pc - 4;
+      putVarint( output, zigzag( pc_delta ) );
+    }
+    if ( !( flags & SAME_WORD ) ) {
+      putVarint( output, record.word );
+    }
+    if ( record.has_address && !( flags & PREDICTED_ADDRESS ) ) {
+      putVarint( output,
+                 zigzag( std::int64_t( record.address ) - predicted ) );
+    }
+    update( entry, record );
+  }
+
+  // Decodes the record at data[position], advancing position
+  TraceRecord decode( std::string_view data, std::size_t& position ) {
+    std::uint8_t flags = getByte( data, position );
+    TraceRecord record;
+    record.pc = flags & SEQUENTIAL_PC
+                    ? m_last_pc + 4
+                    : std::int32_t( m_last_pc + 4 +
+                                    unzigzag( getVarint( data, position ) ) );
+    PcEntry& entry = lookup( record.pc );
+    record.word = flags & SAME_WORD
+                      ? entry.word
+                      : std::uint32_t( getVarint( data, position ) );
+    record.has_address = flags & HAS_ADDRESS;
+    record.is_store = flags & STORE;
+    record.fetch_hit = flags & FETCH_HIT;
+    record.data_hit = flags & DATA_HIT;
+    if ( record.has_address ) {
+      std::int32_t predicted = predictAddress( entry, record.pc );
+      record.address =
+          flags & PREDICTED_ADDRESS
+              ? predicted
+              : std::int32_t( predicted +
+                              unzigzag( getVarint( data, position ) ) );
+    }
+    update( entry, record );
+    return record;
+  }
+
+ private:
+  PcEntry& lookup( std::int32_t pc ) {
+    return m_table[( std::uint32_t( pc ) >> 2 ) % table_size];
+  }
+
+  static std::int32_t predictAddress( const PcEntry& entry, std::int32_t pc ) {
+    return entry.pc == pc ? entry.address + entry.stride : 0;
+  }
+
+  void update( PcEntry& entry, const TraceRecord& record ) {
+    if ( entry.pc != record.pc ) {
+      entry = PcEntry{ record.pc, record.word, record.address, 0 };
+    } else if ( record.has_address ) {
+      entry.stride = record.address - entry.address;
+      entry.address = record.address;
+    }
+    entry.word = record.word;
+    m_last_pc = record.pc;
+  }
+
+  static std::uint64_t zigzag( std::int64_t value ) {
+    return ( std::uint64_t( value ) << 1 ) ^ std::uint64_t( value >> 63 );
+  }
+
+  static std::int64_t unzigzag( std::uint64_t value ) {
+    return std::int64_t( value >> 1 ) ^ -std::int64_t( value & 1 );
+  }
+
+  static void putVarint( std::string& output, std::uint64_t value ) {
+    while ( value >= 0x80 ) {
+      output += char( value | 0x80 );
+      value >>= 7;
+    }
+    output += char( value );
+  }
+
+  static std::uint8_t getByte( std::string_view data, std::size_t& position ) {
+    if ( position >= data.size() ) {
+      throw std::runtime_error( "Truncated trace" );
+    }
+    return data[position++];
+  }
+
+  static std::uint64_t getVarint( std::string_view data,
+                                  std::size_t& position ) {
+    std::uint64_t value = 0;
+    for ( auto shift = 0; shift < 64; shift += 7 ) {
+      std::uint8_t byte = getByte( data, position );
+      value |= std::uint64_t( byte & 0x7f ) << shift;
+      if ( !( byte & 0x80 ) ) {
+        return value;
+      }
+    }
+    throw std::runtime_error( "Invalid varint in trace" );
+  }
+};
+
+// Trace file layout, little endian
+//   header : magic "RVSIMTRC", version
+//   chunks : number of records, size in bytes, encoded records
+struct TraceFormat {
+  static constexpr std::string_view magic{ "RVSIMTRC" };
+  static constexpr std::uint32_t version = 1;
+};
+
+// Writes a trace on a background thread. record() only appends to a local
+// batch and, every batch_size records, moves the batch through a lock-free
+// ring to the writer thread, which encodes and writes chunks of
+// chunk_size records. The simulation only waits when the writer falls a
+// whole ring behind. As an observer of CPU::run it records every
+// instruction.
+struct TraceRecorder : RunObserver {
+  static constexpr std::size_t batch_size = 1024;
+  static constexpr std::size_t chunk_size = 1 << 16;
+
+ private:
+  using Batch = std::vector<TraceRecord>;
+
+  std::ofstream m_file;
+  common::SpscRing<Batch> m_ring;
+  Batch m_batch;
+  std::int64_t m_num_records = 0;
+  std::atomic<bool> m_closing{ false };
+  std::atomic<bool> m_writer_stopped{ false };
+  std::exception_ptr m_writer_error;
+  std::thread m_writer;
+
+ public:
+  // ring_capacity is in batches
+  TraceRecorder( const std::string& filename, std::size_t ring_capacity = 64 )
+      : m_file( filename, std::ios::binary | std::ios::trunc ),
+        m_ring( ring_capacity ) {
+    if ( !m_file ) {
+      throw std::runtime_error( "Unable to create trace : " + filename );
+    }
+    m_file.write( TraceFormat::magic.data(), TraceFormat::magic.size() );
+    putU32( m_file, TraceFormat::version );
+    m_batch.reserve( batch_size );
+    m_writer = std::thread( [this]() {
+      try {
+        writeChunks();
+      } catch ( ... ) {
+        m_writer_error = std::current_exception();
+      }
+      m_writer_stopped.store( true, std::memory_order_release );
+    } );
+  }
+
+  TraceRecorder( const TraceRecorder& ) = delete;
+  TraceRecorder& operator=( const TraceRecorder& ) = delete;
+
+  // Errors can only be reported by calling close() first
+  ~TraceRecorder() {
+    try {
+      close();
+    } catch ( ... ) {
+    }
+  }
+
+  void record( const TraceRecord& record ) {
+    m_batch.push_back( record );
+    m_num_records++;
+    if ( m_batch.size() == batch_size ) {
+      pushBatch();
+    }
+  }
+
+  void retire( const State&, const InstructionEvent& instruction ) override {
+    record( instruction.trace );
+  }
+
+  // Writes everything recorded so far and stops the writer thread,
+  // rethrowing its error if it failed
+  void close() {
+    if ( !m_writer.joinable() ) {
+      return;
+    }
+    if ( !m_batch.empty() ) {
+      pushBatch();
+    }
+    m_closing.store( true, std::memory_order_release );
+    m_writer.join();
+    if ( m_writer_error ) {
+      std::rethrow_exception( std::exchange( m_writer_error, nullptr ) );
+    }
+  }
+
+  std::int64_t getNumRecords() const { return m_num_records; }
+
+ private:
+  void pushBatch() {
+    while ( !m_ring.tryPush( std::move( m_batch ) ) ) {
+      if ( m_writer_stopped.load( std::memory_order_acquire ) ) {
+        break;  // The error is reported by close()
+      }
+      std::this_thread::yield();
+    }
+    m_batch = Batch();
+    m_batch.reserve( batch_size );
+  }
+
+  void writeChunks() {
+    TraceCodec codec;
+    std::string chunk;
+    std::uint32_t chunk_records = 0;
+    auto flush = [&]() {
+      putU32( m_file, chunk_records );
+      putU32( m_file, chunk.size() );
+      m_file.write( chunk.data(), chunk.size() );
+      if ( !m_file ) {
+        throw std::runtime_error( "Unable to write trace" );
+      }
+      chunk.clear();
+      chunk_records = 0;
+      codec.reset();
+    };
+
+    Batch batch;
+    while ( true ) {
+      if ( !m_ring.tryPop( batch ) ) {
+        if ( !m_closing.load( std::memory_order_acquire ) ) {
+          std::this_thread::sleep_for( std::chrono::microseconds( 100 ) );
+          continue;
+        }
+        if ( !m_ring.tryPop( batch ) ) {
+          break;  // Everything pushed before closing has been written
+        }
+      }
+      for ( auto& record : batch ) {
+        codec.encode( record, chunk );
+        if ( ++chunk_records == chunk_size ) {
+          flush();
+        }
+      }
+    }
+    if ( chunk_records != 0 ) {
+      flush();
+    }
+    m_file.flush();
+    if ( !m_file ) {
+      throw std::runtime_error( "Unable to write trace" );
+    }
+  }
+
+  static void putU32( std::ostream& output, std::uint32_t value ) {
+    for ( auto i = 0; i < 4; i++ ) {
+      output.put( char( value >> ( 8 * i ) ) );
+    }
+  }
+};
+
+// Reads a trace record by record straight from a mapping of the file
+struct TraceReader {
+ private:
+  common::MappedFile m_file;
+  std::string_view m_data;
+  std::size_t m_position = 0;  // Next chunk header
+  std::string_view m_chunk;
+  std::size_t m_chunk_position = 0;
+  std::uint32_t m_chunk_records = 0;  // Left in the current chunk
+  TraceCodec m_codec;
+
+ public:
+  TraceReader( const std::string& filename ) : m_file( filename ) {
+    m_file.adviseSequential();
+    try {
+      open( m_file.view() );
+    } catch ( const std::runtime_error& e ) {
+      throw std::runtime_error( e.what() + std::string( " : " ) + filename );
+    }
+  }
+
+  // Reads a trace already in memory, e.g. a mapping shared by several
+  // readers. data must outlive the reader.
+  TraceReader( std::string_view data ) { open( data ); }
+
+  static bool isTrace( std::string_view data ) {
+    return data.substr( 0, TraceFormat::magic.size() ) == TraceFormat::magic;
+  }
+
+  // False at the end of the trace
+  bool next( TraceRecord& record ) {
+    while ( m_chunk_records == 0 ) {
+      if ( m_position == m_data.size() ) {
+        return false;
+      }
+      m_chunk_records = getU32();
+      std::uint32_t size = getU32();
+      if ( size > m_data.size() - m_position ) {
+        throw std::runtime_error( "Truncated trace" );
+      }
+      m_chunk = m_data.substr( m_position, size );
+      m_position += size;
+      m_chunk_position = 0;
+      m_codec.reset();
+    }
+    record = m_codec.decode( m_chunk, m_chunk_position );
+    m_chunk_records--;
+    return true;
+  }
+
+ private:
+  void open( std::string_view data ) {
+    m_data = data;
+    if ( m_data.size() < TraceFormat::magic.size() + 4 || !isTrace( m_data ) ) {
+      throw std::runtime_error( "Not a trace" );
+    }
+    m_position = TraceFormat::magic.size();
+    if ( getU32() != TraceFormat::version ) {
+      throw std::runtime_error( "Unsupported trace version" );
+    }
+  }
+
+  std::uint32_t getU32() {
+    if ( m_data.size() - m_position < 4 ) {
+      throw std::runtime_error( "Truncated trace" );
+    }
+    std::uint32_t value = 0;
+    for ( auto i = 0; i < 4; i++ ) {
+      value |= std::uint32_t( std::uint8_t( m_data[m_position++] ) )
+               << ( 8 * i );
+    }
+    return value;
+  }
+};
+}  // namespace cpu
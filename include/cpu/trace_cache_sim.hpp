@@ -0,0 +1,267 @@
+#pragma once
+
+#include <algorithm>
+#include <common/mapped_file.hpp>
+#include <common/thread_pool.hpp>
+#include <cpu/state_data.hpp>
+#include <cpu/trace.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory/common_enums.hpp>
+#include <memory/memory_manager.hpp>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cpu {
+// Cache of one trace driven run, as MemoryManager builds it for the CPU
+struct TraceCacheConfig {
+  std::int32_t cache_size = 64;  // Bytes
+  std::int32_t block_size = 8;
+  memory::CacheWritePolicy write_policy = memory::CacheWritePolicy::WRITEBACK;
+  memory::CacheReplacementPolicy replacement_policy =
+      memory::CacheReplacementPolicy::FIFO;
+
+  void validate() const {
+    if ( block_size <= 0 || block_size % 4 != 0 || cache_size < block_size ||
+         cache_size % block_size != 0 ) {
+      throw std::invalid_argument(
+          "Cache size must be a multiple of a block size of whole words" );
+    }
+  }
+};
+
+struct TraceCacheStats {
+  std::int64_t accesses[3] = {};  // Indexed by memory::AccessType
+  std::int64_t misses[3] = {};
+  std::int64_t evictions = 0;
+  std::int64_t writebacks = 0;  // Dirty blocks written back
+  // Main memory traffic: block fills, write misses and write through
+  std::int64_t memory_reads = 0;
+  std::int64_t memory_writes = 0;
+
+  std::int64_t getAccesses() const {
+    return accesses[memory::READ] + accesses[memory::WRITE] +
+           accesses[memory::FETCH];
+  }
+
+  std::int64_t getMisses() const {
+    return misses[memory::READ] + misses[memory::WRITE] +
+           misses[memory::FETCH];
+  }
+
+  double getMissRate() const {
+    return getAccesses() == 0 ? 0 : getMisses() / double( getAccesses() );
+  }
+};
+
+struct MemoryReference {
+  std::uint32_t address = 0;
+  memory::AccessType type = memory::READ;
+  bool flush = false;  // Flush the cache instead of accessing it
+};
+
+// Dinero "din" text trace: one "label address" line per reference, the
+// address in hex and anything after it ignored. Labels 0 / 1 / 2 are
+// read / write / fetch, 3 is skipped and 4 flushes the cache.
+struct DinReader {
+ private:
+  std::string_view m_data;
+  std::size_t m_position = 0;
+  std::int64_t m_line = 0;
+
+ public:
+  DinReader( std::string_view data ) : m_data( data ) {}
+
+  // False at the end of the trace
+  bool next( MemoryReference& reference ) {
+    while ( m_position < m_data.size() ) {
+      m_line++;
+      std::size_t end = m_data.find( '\n', m_position );
+      if ( end == std::string_view::npos ) {
+        end = m_data.size();
+      }
+      std::string_view line = m_data.substr( m_position, end - m_position );
+      m_position = end + 1;
+      if ( parseLine( line, reference ) ) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  // False for lines without a reference
+  bool parseLine( std::string_view line, MemoryReference& reference ) {
+    std::size_t i = skipSpaces( line, 0 );
+    if ( i == line.size() ) {
+      return false;
+    }
+    char label = line[i];
+    if ( label < '0' || label > '4' ||
+         ( i + 1 < line.size() && !isSpace( line[i + 1] ) ) ) {
+      throw invalid( "label" );
+    }
+    if ( label == '3' ) {
+      return false;
+    }
+    reference.flush = label == '4';
+    reference.type = memory::AccessType( label == '4' ? 0 : label - '0' );
+
+    i = skipSpaces( line, i + 1 );
+    if ( i + 1 < line.size() && line[i] == '0' &&
+         ( line[i + 1] == 'x' || line[i + 1] == 'X' ) ) {
+      i += 2;
+    }
+    std::uint64_t address = 0;
+    std::size_t digits = 0;
+    for ( ; i < line.size() && !isSpace( line[i] ); i++, digits++ ) {
+      std::int32_t digit = hexDigit( line[i] );
+      if ( digit < 0 ) {
+        throw invalid( "address" );
+      }
+      address = address << 4 | digit;
+    }
+    if ( digits == 0 && !reference.flush ) {
+      throw invalid( "address" );
+    }
+    reference.address = std::uint32_t( address );
+    return true;
+  }
+
+  std::runtime_error invalid( const std::string& what ) const {
+    return std::runtime_error( "Invalid din " + what + " on line " +
+                               std::to_string( m_line ) );
+  }
+
+  static bool isSpace( char c ) { return c == ' ' || c == '\t' || c == '\r'; }
+
+  static std::size_t skipSpaces( std::string_view line, std::size_t i ) {
+    while ( i < line.size() && isSpace( line[i] ) ) {
+      i++;
+    }
+    return i;
+  }
+
+  static std::int32_t hexDigit( char c ) {
+    if ( c >= '0' && c <= '9' ) {
+      return c - '0';
+    }
+    if ( c >= 'a' && c <= 'f' ) {
+      return c - 'a' + 10;
+    }
+    if ( c >= 'A' && c <= 'F' ) {
+      return c - 'A' + 10;
+    }
+    return -1;
+  }
+};
+
+// Feeds a memory reference trace into caches without executing anything.
+// The trace is either Dinero din text or a binary execution trace written
+// by TraceRecorder ( a fetch per instruction plus its load or store ), told
+// apart by the magic of the latter. The file is mapped once and every
+// configuration walks the shared mapping on its own thread.
+//
+// Each configuration gets its own MemoryManager, so the references go
+// through the same CacheMemory, and are counted the same way, as the
+// accesses of a CPU run. Main memory covers the highest address in the
+// trace.
+struct TraceCacheSimulator {
+  // num_threads = 0 uses one thread per hardware thread
+  static std::vector<TraceCacheStats> run(
+      const std::string& filename, const std::vector<TraceCacheConfig>& configs,
+      std::int32_t num_threads = 0 ) {
+    common::MappedFile file( filename );
+    file.adviseSequential();
+    return simulate( file.view(), configs, num_threads );
+  }
+
+  // Same for a trace already in memory
+  static std::vector<TraceCacheStats> simulate(
+      std::string_view trace, const std::vector<TraceCacheConfig>& configs,
+      std::int32_t num_threads = 0 ) {
+    for ( auto& config : configs ) {
+      config.validate();
+    }
+    std::uint32_t max_address = 0;
+    forEachReference( trace, [&]( const MemoryReference& reference ) {
+      if ( !reference.flush ) {
+        max_address = std::max( max_address, reference.address );
+      }
+    } );
+    std::vector<TraceCacheStats> results( configs.size() );
+    common::ThreadPool pool( num_threads );
+    pool.parallelFor( configs.size(), [&]( std::size_t i ) {
+      results[i] = simulateConfig( trace, configs[i], max_address );
+    } );
+    return results;
+  }
+
+  template <typename Func>
+  static void forEachReference( std::string_view trace, Func&& func ) {
+    if ( TraceReader::isTrace( trace ) ) {
+      TraceReader reader( trace );
+      TraceRecord record;
+      while ( reader.next( record ) ) {
+        func( MemoryReference{ std::uint32_t( record.pc ), memory::FETCH } );
+        if ( record.has_address ) {
+          func( MemoryReference{ std::uint32_t( record.address ),
+                                 record.is_store ? memory::WRITE
+                                                 : memory::READ } );
+        }
+      }
+    } else {
+      DinReader reader( trace );
+      MemoryReference reference;
+      while ( reader.next( reference ) ) {
+        func( reference );
+      }
+    }
+  }
+
+ private:
+  static TraceCacheStats simulateConfig( std::string_view trace,
+                                         const TraceCacheConfig& config,
+                                         std::uint32_t max_address ) {
+    // A block is read from main memory at the address that missed
+    std::int64_t memory_size = std::int64_t( max_address ) + config.block_size;
+    if ( memory_size > std::numeric_limits<std::int32_t>::max() ) {
+      throw std::out_of_range( "Trace address out of range : " +
+                               std::to_string( max_address ) );
+    }
+    StateData state;  // Counts the hits and misses, as in a CPU run
+    memory::MemoryManager memory_manager(
+        std::int32_t( memory_size ), config.cache_size, config.block_size,
+        config.write_policy, config.replacement_policy, &state );
+    const std::string word( 32, '0' );  // Stored by every write
+
+    TraceCacheStats stats;
+    forEachReference( trace, [&]( const MemoryReference& reference ) {
+      if ( reference.flush ) {
+        memory_manager.getCacheMemoryRef().flush();
+        return;
+      }
+      std::int64_t misses = state.cache_miss;
+      auto address = std::int32_t( reference.address );
+      if ( reference.type == memory::WRITE ) {
+        memory_manager.write( address, word );
+      } else {
+        memory_manager.read( address, 4 );
+      }
+      stats.accesses[reference.type]++;
+      stats.misses[reference.type] += state.cache_miss - misses;
+    } );
+
+    const memory::CacheMemory& cache = memory_manager.getCacheMemoryRef();
+    const memory::MainMemory& main_memory = memory_manager.getMainMemoryRef();
+    stats.evictions = cache.getNumEvictions();
+    stats.writebacks = cache.getNumWritebacks();
+    stats.memory_reads = main_memory.getNumReads();
+    stats.memory_writes = main_memory.getNumWrites();
+    return stats;
+  }
+};
+}  // namespace cpu
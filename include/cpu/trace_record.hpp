@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+namespace cpu {
+// One retired instruction
+struct TraceRecord {
+  std::int32_t pc = 0;
+  std::uint32_t word = 0;    // Raw instruction
+  std::int32_t address = 0;  // Effective address of loads and stores
+  bool has_address = false;
+  bool is_store = false;
+  bool fetch_hit = false;
+  bool data_hit = false;  // Only meaningful with has_address
+
+  bool operator==( const TraceRecord& ) const = default;
+};
+}  // namespace cpu
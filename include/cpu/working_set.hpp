@@ -0,0 +1,328 @@
+#pragma once
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cpu/run_observer.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <ostream>
+#include <queue>
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cpu {
+struct WorkingSetConfig {
+  std::int64_t interval_length = 10000;  // Instructions
+  std::int32_t line_size = 8;            // Bytes, a power of two
+  // Share of the lines whose reuse is tracked at first, lowered as needed
+  // to stay within max_sampled_lines
+  double sampling_rate = 1.0;
+  std::int32_t max_sampled_lines = 4096;
+  // Smallest line hashes kept per interval to estimate its unique lines
+  std::int32_t max_set_size = 1024;
+
+  void validate() const {
+    if ( interval_length <= 0 ) {
+      throw std::invalid_argument( "Interval length must be positive" );
+    }
+    if ( line_size <= 0 || ( line_size & ( line_size - 1 ) ) != 0 ) {
+      throw std::invalid_argument( "Line size must be a power of two" );
+    }
+    if ( !( sampling_rate > 0 && sampling_rate <= 1 ) ) {
+      throw std::invalid_argument( "Sampling rate must be in (0, 1]" );
+    }
+    if ( max_sampled_lines <= 0 || max_set_size <= 1 ) {
+      throw std::invalid_argument( "Sample sizes must be positive" );
+    }
+  }
+};
+
+// Estimated references by reuse distance, the number of distinct lines
+// touched since the previous reference to the same line. Bucket 0 holds
+// distance 0, bucket b distances in [2^(b-1), 2^b). First references are
+// cold.
+struct ReuseHistogram {
+  static constexpr std::size_t num_buckets = 64;
+
+  std::array<double, num_buckets> buckets{};
+  double cold = 0;
+
+  static std::size_t getBucket( std::uint64_t distance ) {
+    return std::bit_width( distance );
+  }
+
+  double getReferences() const {
+    double references = cold;
+    for ( auto count : buckets ) {
+      references += count;
+    }
+    return references;
+  }
+
+  // Miss ratio of a fully associative LRU cache of cache_lines lines, which
+  // hits exactly the references with a smaller reuse distance. Buckets
+  // straddling the size are split evenly over their distances.
+  double getMissRatio( std::uint64_t cache_lines ) const {
+    double references = getReferences();
+    if ( references == 0 ) {
+      return 0;
+    }
+    double misses = cold;
+    for ( std::size_t b = 0; b < num_buckets; b++ ) {
+      double low = b == 0 ? 0 : std::ldexp( 1.0, b - 1 );
+      double high = b == 0 ? 1 : std::ldexp( 1.0, b );
+      double missing = std::clamp( ( high - cache_lines ) / ( high - low ),
+                                   0.0, 1.0 );
+      misses += buckets[b] * missing;
+    }
+    return misses / references;
+  }
+
+  void add( const ReuseHistogram& other ) {
+    for ( std::size_t b = 0; b < num_buckets; b++ ) {
+      buckets[b] += other.buckets[b];
+    }
+    cold += other.cold;
+  }
+};
+
+struct WorkingSetInterval {
+  std::int64_t instructions = 0;
+  std::int64_t references = 0;  // Loads and stores
+  double unique_lines = 0;      // Estimated
+  ReuseHistogram reuse;
+};
+
+// Working set and reuse distances of the data reference stream, per
+// interval of instructions, in bounded memory.
+//
+// Reuse distances are tracked for a spatially hashed sample of the lines
+// only: a line is sampled if its hash is below a threshold, so every
+// reference to it is, and distances among sampled lines are scaled up by
+// the sampling rate. Once more than max_sampled_lines are sampled the
+// line with the largest hash is dropped and the threshold lowered below
+// it.
+// Distances come from a Fenwick tree over the time of last access of each
+// line, renumbered when it fills up.
+//
+// Unique lines per interval are a k minimum values estimate from the
+// max_set_size smallest line hashes seen in it, exact below that.
+struct WorkingSetProfiler : RunObserver {
+ private:
+  struct SampledLine {
+    std::uint64_t hash;
+    std::int64_t time;
+  };
+
+  WorkingSetConfig m_config;
+  std::int32_t m_line_bits = 0;
+
+  std::uint64_t m_threshold;  // Lines with a hash up to it are sampled
+  std::unordered_map<std::uint64_t, SampledLine> m_lines;
+  std::priority_queue<std::pair<std::uint64_t, std::uint64_t>> m_by_hash;
+  std::vector<std::int32_t> m_tree;  // Fenwick tree, 1 at last access times
+  std::int64_t m_time = 0;
+
+  std::set<std::uint64_t> m_interval_hashes;
+  WorkingSetInterval m_current;
+  std::vector<WorkingSetInterval> m_intervals;
+
+ public:
+  WorkingSetProfiler( const WorkingSetConfig& config = WorkingSetConfig() )
+      : m_config( config ) {
+    m_config.validate();
+    m_line_bits = std::countr_zero( std::uint32_t( m_config.line_size ) );
+    m_threshold =
+        m_config.sampling_rate >= 1
+            ? std::numeric_limits<std::uint64_t>::max()
+            : std::uint64_t( std::ldexp( m_config.sampling_rate, 64 ) );
+    m_tree.assign( 2 * std::size_t( m_config.max_sampled_lines ) + 1, 0 );
+  }
+
+  // A load or store of address by the current instruction
+  void access( std::uint32_t address ) {
+    std::uint64_t line = address >> m_line_bits;
+    std::uint64_t hash = getHash( line );
+    m_current.references++;
+    addToSet( hash );
+    if ( hash <= m_threshold ) {
+      addSampled( line, hash );
+    }
+  }
+
+  // Ends the current instruction
+  void retire() {
+    if ( ++m_current.instructions == m_config.interval_length ) {
+      closeInterval();
+    }
+  }
+
+  // Ends a shorter last interval, if there is one
+  void finish() {
+    if ( m_current.instructions != 0 || m_current.references != 0 ) {
+      closeInterval();
+    }
+  }
+
+  void retire( const State&, const InstructionEvent& instruction ) override {
+    if ( instruction.trace.has_address ) {
+      access( instruction.trace.address );
+    }
+    retire();
+  }
+
+  void finish( const State&, bool ) override { finish(); }
+
+  const std::vector<WorkingSetInterval>& getIntervals() const {
+    return m_intervals;
+  }
+
+  ReuseHistogram getTotal() const {
+    ReuseHistogram total;
+    for ( auto& interval : m_intervals ) {
+      total.add( interval.reuse );
+    }
+    return total;
+  }
+
+  // Share of the lines whose reuse is tracked at the moment
+  double getSamplingRate() const {
+    return m_threshold == ~std::uint64_t( 0 ) ? 1
+                                              : std::ldexp( m_threshold, -64 );
+  }
+
+  std::size_t getNumSampledLines() const { return m_lines.size(); }
+
+  const WorkingSetConfig& getConfig() const { return m_config; }
+
+  // One row per interval with the unique lines, the working set in bytes
+  // and the miss ratio of LRU caches of 2^k lines up to max_lines
+  void writeCSV( std::ostream& out, std::uint64_t max_lines = 4096 ) const {
+    out << "interval,instructions,references,unique_lines,working_set_bytes";
+    for ( std::uint64_t lines = 1; lines <= max_lines; lines <<= 1 ) {
+      out << ",miss_ratio_" << lines;
+    }
+    out << '\n';
+    for ( std::size_t i = 0; i < m_intervals.size(); i++ ) {
+      const WorkingSetInterval& interval = m_intervals[i];
+      out << fmt::format( "{},{},{},{:.1f},{:.0f}", i, interval.instructions,
+                          interval.references, interval.unique_lines,
+                          interval.unique_lines * m_config.line_size );
+      for ( std::uint64_t lines = 1; lines <= max_lines; lines <<= 1 ) {
+        out << fmt::format( ",{:.4f}", interval.reuse.getMissRatio( lines ) );
+      }
+      out << '\n';
+    }
+  }
+
+ private:
+  // splitmix64 finalizer, so nearby lines get unrelated hashes
+  static std::uint64_t getHash( std::uint64_t line ) {
+    line += 0x9e3779b97f4a7c15ull;
+    line = ( line ^ ( line >> 30 ) ) * 0xbf58476d1ce4e5b9ull;
+    line = ( line ^ ( line >> 27 ) ) * 0x94d049bb133111ebull;
+    return line ^ ( line >> 31 );
+  }
+
+  void addSampled( std::uint64_t line, std::uint64_t hash ) {
+    if ( m_time + 1 == std::int64_t( m_tree.size() ) ) {
+      renumber();
+    }
+    double weight = 1 / getSamplingRate();
+    auto [entry, inserted] =
+        m_lines.try_emplace( line, SampledLine{ hash, 0 } );
+    if ( inserted ) {
+      m_current.reuse.cold += weight;
+      m_by_hash.emplace( hash, line );
+    } else {
+      std::int64_t time = entry->second.time;
+      std::int64_t distance = sum( m_time ) - sum( time + 1 );
+      update( time, -1 );
+      std::uint64_t scaled = std::llround( distance / getSamplingRate() );
+      m_current.reuse.buckets[ReuseHistogram::getBucket( scaled )] += weight;
+    }
+    entry->second.time = m_time;
+    update( m_time++, 1 );
+
+    if ( m_lines.size() > std::size_t( m_config.max_sampled_lines ) ) {
+      auto [largest_hash, largest_line] = m_by_hash.top();
+      m_by_hash.pop();
+      update( m_lines.at( largest_line ).time, -1 );
+      m_lines.erase( largest_line );
+      m_threshold = largest_hash - 1;
+    }
+  }
+
+  // Keeps the max_set_size smallest hashes of the interval
+  void addToSet( std::uint64_t hash ) {
+    if ( m_interval_hashes.size() ==
+         std::size_t( m_config.max_set_size ) ) {
+      if ( hash >= *m_interval_hashes.rbegin() ) {
+        return;
+      }
+      if ( m_interval_hashes.insert( hash ).second ) {
+        m_interval_hashes.erase( std::prev( m_interval_hashes.end() ) );
+      }
+      return;
+    }
+    m_interval_hashes.insert( hash );
+  }
+
+  double getUniqueLines() const {
+    std::size_t k = m_interval_hashes.size();
+    if ( k < std::size_t( m_config.max_set_size ) ) {
+      return k;
+    }
+    return ( k - 1 ) / std::ldexp( *m_interval_hashes.rbegin(), -64 );
+  }
+
+  void closeInterval() {
+    m_current.unique_lines = getUniqueLines();
+    m_intervals.push_back( m_current );
+    m_current = WorkingSetInterval();
+    m_interval_hashes.clear();
+  }
+
+  // Accesses at times before end
+  std::int64_t sum( std::int64_t end ) const {
+    std::int64_t total = 0;
+    for ( ; end > 0; end -= end & -end ) {
+      total += m_tree[end];
+    }
+    return total;
+  }
+
+  void update( std::int64_t time, std::int32_t delta ) {
+    for ( std::size_t i = time + 1; i < m_tree.size(); i += i & -i ) {
+      m_tree[i] += delta;
+    }
+  }
+
+  // Gives the sampled lines the times 0 .. n-1 in the order of their last
+  // access
+  void renumber() {
+    std::vector<SampledLine*> lines;
+    lines.reserve( m_lines.size() );
+    for ( auto& [line, sampled] : m_lines ) {
+      lines.push_back( &sampled );
+    }
+    std::sort( lines.begin(), lines.end(),
+               []( auto* a, auto* b ) { return a->time < b->time; } );
+    m_tree.assign( m_tree.size(), 0 );
+    m_time = 0;
+    for ( auto* sampled : lines ) {
+      sampled->time = m_time;
+      update( m_time++, 1 );
+    }
+  }
+};
+}  // namespace cpu
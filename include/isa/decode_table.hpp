@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <isa/encoding.hpp>
+#include <isa/isa_table.hpp>
+#include <stdexcept>
+
+namespace isa {
+
+// Decode lookup generated from IsaTable at compile time. ( funct3, opcode )
+// selects the first candidate, instructions sharing that slot ( add / sub )
+// are chained and told apart by funct7. An instruction that ignores funct3
+// is in all eight slots of its opcode, with a chain link for each.
+struct DecodeTable {
+  static constexpr std::int32_t invalid = -1;
+
+ private:
+  static constexpr std::size_t num_slots = 1 << 10;
+
+  // Chain links are per ( instruction, funct3 ) node, node / 8 being the
+  // instruction
+  struct Tables {
+    std::array<std::int16_t, num_slots> first{};
+    std::array<std::int16_t, IsaTable::size() * 8> next{};
+  };
+
+  static constexpr std::size_t slot( std::uint32_t funct3,
+                                     std::uint32_t opcode ) {
+    return ( funct3 << 7 ) | opcode;
+  }
+
+  // Throws, and so fails to compile, on entries that cannot be told apart
+  static constexpr Tables build() {
+    Tables tables;
+    tables.first.fill( invalid );
+    tables.next.fill( invalid );
+    for ( std::int32_t i = IsaTable::size() - 1; i >= 0; i-- ) {
+      const InstrDesc& desc = IsaTable::instructions[i];
+      for ( std::uint32_t funct3 = 0; funct3 < 8; funct3++ ) {
+        if ( desc.match_funct3 && funct3 != desc.funct3 ) {
+          continue;
+        }
+        std::int16_t& head = tables.first[slot( funct3, desc.opcode )];
+        for ( std::int32_t node = head; node != invalid;
+              node = tables.next[node] ) {
+          const InstrDesc& other = IsaTable::instructions[node / 8];
+          if ( !desc.match_funct7 || !other.match_funct7 ||
+               desc.funct7 == other.funct7 ) {
+            throw std::logic_error( "Ambiguous instruction encoding" );
+          }
+        }
+        std::int16_t node = i * 8 + funct3;
+        tables.next[node] = head;
+        head = node;
+      }
+    }
+    return tables;
+  }
+
+  static const Tables m_tables;
+
+ public:
+  // Index into IsaTable::instructions, invalid if nothing matches
+  static constexpr std::int32_t decode( std::uint32_t word ) {
+    std::int32_t node = m_tables.first[slot( Encoding::funct3( word ),
+                                             Encoding::opcode( word ) )];
+    while ( node != invalid ) {
+      const InstrDesc& desc = IsaTable::instructions[node / 8];
+      if ( !desc.match_funct7 || desc.funct7 == Encoding::funct7( word ) ) {
+        return node / 8;
+      }
+      node = m_tables.next[node];
+    }
+    return invalid;
+  }
+};
+
+inline constexpr DecodeTable::Tables DecodeTable::m_tables =
+    DecodeTable::build();
+}  // namespace isa
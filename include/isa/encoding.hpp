@@ -0,0 +1,177 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <isa/isa_table.hpp>
+
+namespace isa {
+
+// Operands in the order the simulator passes them around ( ConnectionInfo )
+struct Operands {
+  std::int32_t operand1 = std::numeric_limits<std::int32_t>::max();
+  std::int32_t operand2 = std::numeric_limits<std::int32_t>::max();
+  std::int32_t operand3 = std::numeric_limits<std::int32_t>::max();
+};
+
+// Field level encoding and decoding of 32 bit instruction words. Register and
+// immediate placement only depends on the ImmediateLayout of an instruction.
+struct Encoding {
+  static constexpr std::uint32_t bits( std::uint32_t word, std::int32_t hi,
+                                       std::int32_t lo ) {
+    return ( word >> lo ) & ( ( 1u << ( hi - lo + 1 ) ) - 1 );
+  }
+
+  static constexpr std::uint32_t opcode( std::uint32_t word ) {
+    return bits( word, 6, 0 );
+  }
+  static constexpr std::uint32_t rd( std::uint32_t word ) {
+    return bits( word, 11, 7 );
+  }
+  static constexpr std::uint32_t funct3( std::uint32_t word ) {
+    return bits( word, 14, 12 );
+  }
+  static constexpr std::uint32_t rs1( std::uint32_t word ) {
+    return bits( word, 19, 15 );
+  }
+  static constexpr std::uint32_t rs2( std::uint32_t word ) {
+    return bits( word, 24, 20 );
+  }
+  static constexpr std::uint32_t funct7( std::uint32_t word ) {
+    return bits( word, 31, 25 );
+  }
+
+  // Width of the immediate value, the executor sign extends from this bit
+  static constexpr std::int32_t immediateWidth( ImmediateLayout layout ) {
+    switch ( layout ) {
+      case ImmI:
+      case ImmS:
+        return 12;
+      case ImmB:
+        return 13;
+      case ImmU:
+        return 20;
+      case ImmJ:
+        return 21;
+      default:
+        return 0;
+    }
+  }
+
+  // Immediate as an unsigned immediateWidth() bit value ( not sign extended )
+  static constexpr std::uint32_t getImmediate( ImmediateLayout layout,
+                                               std::uint32_t word ) {
+    switch ( layout ) {
+      case ImmI:
+        return bits( word, 31, 20 );
+      case ImmS:
+        return ( bits( word, 31, 25 ) << 5 ) | bits( word, 11, 7 );
+      case ImmB:
+        return ( bits( word, 31, 31 ) << 12 ) | ( bits( word, 7, 7 ) << 11 ) |
+               ( bits( word, 30, 25 ) << 5 ) | ( bits( word, 11, 8 ) << 1 );
+      case ImmU:
+        return bits( word, 31, 12 );
+      case ImmJ:
+        return ( bits( word, 31, 31 ) << 20 ) |
+               ( bits( word, 19, 12 ) << 12 ) | ( bits( word, 20, 20 ) << 11 ) |
+               ( bits( word, 30, 21 ) << 1 );
+      default:
+        return 0;
+    }
+  }
+
+  static constexpr std::uint32_t placeImmediate( ImmediateLayout layout,
+                                                 std::uint32_t imm ) {
+    switch ( layout ) {
+      case ImmI:
+        return bits( imm, 11, 0 ) << 20;
+      case ImmS:
+        return ( bits( imm, 11, 5 ) << 25 ) | ( bits( imm, 4, 0 ) << 7 );
+      case ImmB:
+        return ( bits( imm, 12, 12 ) << 31 ) | ( bits( imm, 10, 5 ) << 25 ) |
+               ( bits( imm, 4, 1 ) << 8 ) | ( bits( imm, 11, 11 ) << 7 );
+      case ImmU:
+        return bits( imm, 19, 0 ) << 12;
+      case ImmJ:
+        return ( bits( imm, 20, 20 ) << 31 ) | ( bits( imm, 10, 1 ) << 21 ) |
+               ( bits( imm, 11, 11 ) << 20 ) | ( bits( imm, 19, 12 ) << 12 );
+      default:
+        return 0;
+    }
+  }
+
+  // Operand order per layout:
+  //   NoImm : rd, rs1, rs2      ImmI : rd, rs1, imm     ImmS : rs2, rs1, imm
+  //   ImmB  : rs1, rs2, imm     ImmU : rd, imm          ImmJ : rd, imm
+  static constexpr Operands getOperands( ImmediateLayout layout,
+                                         std::uint32_t word ) {
+    std::int32_t imm = getImmediate( layout, word );
+    switch ( layout ) {
+      case NoImm:
+        return { std::int32_t( rd( word ) ), std::int32_t( rs1( word ) ),
+                 std::int32_t( rs2( word ) ) };
+      case ImmI:
+        return { std::int32_t( rd( word ) ), std::int32_t( rs1( word ) ), imm };
+      case ImmS:
+        return { std::int32_t( rs2( word ) ), std::int32_t( rs1( word ) ),
+                 imm };
+      case ImmB:
+        return { std::int32_t( rs1( word ) ), std::int32_t( rs2( word ) ),
+                 imm };
+      case ImmU:
+      case ImmJ:
+        return { std::int32_t( rd( word ) ), imm };
+    }
+    return {};
+  }
+
+  // Inverse of getOperands
+  static constexpr std::uint32_t encode( const InstrDesc& desc,
+                                         const Operands& operands ) {
+    std::uint32_t word = desc.opcode | ( desc.funct3 << 12 ) |
+                         ( desc.funct7 << 25 );
+    auto reg = []( std::int32_t value ) { return std::uint32_t( value ) & 31; };
+    std::uint32_t imm = operands.operand3;
+    switch ( desc.immediate_layout ) {
+      case NoImm:
+        return word | ( reg( operands.operand1 ) << 7 ) |
+               ( reg( operands.operand2 ) << 15 ) |
+               ( reg( operands.operand3 ) << 20 );
+      case ImmI:
+        return word | ( reg( operands.operand1 ) << 7 ) |
+               ( reg( operands.operand2 ) << 15 ) | placeImmediate( ImmI, imm );
+      case ImmS:
+        return word | ( reg( operands.operand1 ) << 20 ) |
+               ( reg( operands.operand2 ) << 15 ) | placeImmediate( ImmS, imm );
+      case ImmB:
+        return word | ( reg( operands.operand1 ) << 15 ) |
+               ( reg( operands.operand2 ) << 20 ) | placeImmediate( ImmB, imm );
+      case ImmU:
+      case ImmJ:
+        return word | ( reg( operands.operand1 ) << 7 ) |
+               placeImmediate( desc.immediate_layout, operands.operand2 );
+    }
+    return word;
+  }
+
+  // The simulator keeps instructions as strings of '0' / '1', MSB first
+  static std::uint32_t toWord( std::string_view binary ) {
+    if ( binary.size() != 32 ) {
+      throw std::invalid_argument( "Instruction must be 32 bits wide" );
+    }
+    std::uint32_t word = 0;
+    for ( char bit : binary ) {
+      word = ( word << 1 ) | std::uint32_t( bit == '1' );
+    }
+    return word;
+  }
+
+  static std::string toBinaryString( std::uint32_t word ) {
+    return std::bitset<32>( word ).to_string();
+  }
+};
+}  // namespace isa
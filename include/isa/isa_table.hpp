@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace isa {
+
+// Instruction formats as seen by the decoder ( jalr is grouped with jal )
+enum Format { R, I, S, SB, U, UJ };
+
+// Bit layout of the immediate inside the instruction word, this also fixes
+// which register fields are used ( see Encoding::getOperands )
+enum ImmediateLayout { NoImm, ImmI, ImmS, ImmB, ImmU, ImmJ };
+
+// What the executor does with the decoded operands
+enum Semantics { AluReg, AluImm, Load, Store, Branch, Jal, Jalr, Lui };
+
+// ALU operation for AluReg / AluImm, comparison ( 0 or 1 ) for Branch
+using AluFunc = std::int32_t ( * )( std::int32_t, std::int32_t );
+
+struct InstrDesc {
+  std::string_view name;
+  Format format;
+  ImmediateLayout immediate_layout;
+  std::uint32_t opcode;  // bits [6:0]
+  std::uint32_t funct3;  // bits [14:12]
+  std::uint32_t funct7;  // bits [31:25]
+  bool match_funct3;
+  bool match_funct7;
+  std::int32_t immediate_length;  // Assembler operand width, 0 when none
+  Semantics semantics;
+  AluFunc alu;
+};
+
+// The single description of the supported instructions. The assembler's
+// encoder, the decode tree and the executor dispatch table are all generated
+// from it, so adding an instruction only needs a new row here ( and a new
+// Semantics case if it does something new ).
+struct IsaTable {
+  static constexpr std::uint32_t op_reg = 0b0110011;
+  static constexpr std::uint32_t op_imm = 0b0010011;
+  static constexpr std::uint32_t op_load = 0b0000011;
+  static constexpr std::uint32_t op_store = 0b0100011;
+  static constexpr std::uint32_t op_branch = 0b1100011;
+  static constexpr std::uint32_t op_jal = 0b1101111;
+  static constexpr std::uint32_t op_jalr = 0b1100111;
+  static constexpr std::uint32_t op_lui = 0b0110111;
+
+  static constexpr std::array<InstrDesc, 17> instructions{ {
+      /*R Type*/
+      { "add", R, NoImm, op_reg, 0b000, 0b0000000, true, true, 0, AluReg,
+        []( std::int32_t a, std::int32_t b ) { return a + b; } },
+      { "sub", R, NoImm, op_reg, 0b000, 0b0100000, true, true, 0, AluReg,
+        []( std::int32_t a, std::int32_t b ) { return a - b; } },
+      { "xor", R, NoImm, op_reg, 0b100, 0b0000000, true, true, 0, AluReg,
+        []( std::int32_t a, std::int32_t b ) { return a ^ b; } },
+      { "and", R, NoImm, op_reg, 0b111, 0b0000000, true, true, 0, AluReg,
+        []( std::int32_t a, std::int32_t b ) { return a & b; } },
+      { "or", R, NoImm, op_reg, 0b110, 0b0000000, true, true, 0, AluReg,
+        []( std::int32_t a, std::int32_t b ) { return a | b; } },
+      { "sll", R, NoImm, op_reg, 0b001, 0b0000000, true, true, 0, AluReg,
+        []( std::int32_t a, std::int32_t b ) { return a << b; } },
+      { "sra", R, NoImm, op_reg, 0b101, 0b0100000, true, true, 0, AluReg,
+        []( std::int32_t a, std::int32_t b ) { return a >> b; } },
+
+      /*I Type*/
+      { "addi", I, ImmI, op_imm, 0b000, 0, true, false, 12, AluImm,
+        []( std::int32_t a, std::int32_t b ) { return a + b; } },
+      { "lw", I, ImmI, op_load, 0b010, 0, true, false, 12, Load, nullptr },
+
+      /*S*/
+      { "sw", S, ImmS, op_store, 0b010, 0, true, false, 7, Store, nullptr },
+
+      /*UJ*/
+      { "jal", UJ, ImmJ, op_jal, 0, 0, false, false, 20, Jal, nullptr },
+      { "jalr", UJ, ImmI, op_jalr, 0b000, 0, true, false, 12, Jalr, nullptr },
+
+      /*SB*/
+      { "blt", SB, ImmB, op_branch, 0b100, 0, true, false, 13, Branch,
+        []( std::int32_t a, std::int32_t b ) {
+          return std::int32_t( a < b );
+        } },
+      { "bge", SB, ImmB, op_branch, 0b101, 0, true, false, 13, Branch,
+        []( std::int32_t a, std::int32_t b ) {
+          return std::int32_t( a >= b );
+        } },
+      { "beq", SB, ImmB, op_branch, 0b000, 0, true, false, 13, Branch,
+        []( std::int32_t a, std::int32_t b ) {
+          return std::int32_t( a == b );
+        } },
+      { "bne", SB, ImmB, op_branch, 0b001, 0, true, false, 13, Branch,
+        []( std::int32_t a, std::int32_t b ) {
+          return std::int32_t( a != b );
+        } },
+
+      /*U*/
+      { "lui", U, ImmU, op_lui, 0, 0, false, false, 20, Lui, nullptr } } };
+
+  static constexpr std::size_t size() { return instructions.size(); }
+
+  // Returns -1 for mnemonics that are not part of the ISA
+  static constexpr std::int32_t indexOf( std::string_view name ) {
+    for ( std::size_t i = 0; i < instructions.size(); i++ ) {
+      if ( instructions[i].name == name ) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  // Returns nullptr for mnemonics that are not part of the ISA
+  static constexpr const InstrDesc* find( std::string_view name ) {
+    std::int32_t index = indexOf( name );
+    return index < 0 ? nullptr : &instructions[index];
+  }
+};
+}  // namespace isa
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace memory {
+struct RangeCounters {
+  std::int64_t reads = 0;
+  std::int64_t writes = 0;
+  std::int64_t hits = 0;
+  std::int64_t misses = 0;
+  std::int64_t writebacks = 0;
+
+  bool operator==( const RangeCounters& ) const = default;
+};
+
+struct AddressRange {
+  std::string name;
+  std::uint32_t begin = 0;  // First address
+  std::uint32_t end = 0;    // Past the last address
+  RangeCounters counters;
+};
+
+// Named, non overlapping guest address ranges with access counters. The
+// ranges are kept sorted by start address in an array padded to a power of
+// two, so finding the range of an address is a fixed number of halving
+// steps that compile to conditional moves rather than branches.
+struct AddressRangeTable {
+  static constexpr std::int32_t none = -1;
+
+ private:
+  std::vector<AddressRange> m_ranges;  // Sorted by begin
+  std::vector<std::uint32_t> m_begins;  // Padded with the largest address
+  std::vector<std::uint32_t> m_ends;
+
+ public:
+  // Throws if the range is empty or overlaps one already added
+  void add( const std::string& name, std::uint32_t begin, std::uint32_t end ) {
+    if ( name.empty() ) {
+      throw std::invalid_argument( "Address range needs a name" );
+    }
+    if ( begin >= end ) {
+      throw std::invalid_argument( "Address range " + name + " is empty" );
+    }
+    for ( auto& range : m_ranges ) {
+      if ( begin < range.end && range.begin < end ) {
+        throw std::invalid_argument( "Address range " + name +
+                                     " overlaps " + range.name );
+      }
+    }
+    auto position =
+        std::upper_bound( m_ranges.begin(), m_ranges.end(), begin,
+                          []( std::uint32_t begin, auto& range ) {
+                            return begin < range.begin;
+                          } );
+    m_ranges.insert( position,
+                     AddressRange{ name, begin, end, RangeCounters() } );
+    rebuildIndex();
+  }
+
+  // Index into getRanges() of the range holding address, none if there is
+  // no such range
+  std::int32_t find( std::uint32_t address ) const {
+    std::size_t size = m_begins.size();
+    if ( size == 0 ) {
+      return none;
+    }
+    const std::uint32_t* base = m_begins.data();
+    while ( size > 1 ) {
+      std::size_t half = size / 2;
+      base = base[half] <= address ? base + half : base;
+      size -= half;
+    }
+    std::size_t index = base - m_begins.data();
+    return *base <= address && address < m_ends[index] ? index : none;
+  }
+
+  // Counters of the range holding address, nullptr if there is none
+  RangeCounters* findCounters( std::uint32_t address ) {
+    std::int32_t index = find( address );
+    return index == none ? nullptr : &m_ranges[index].counters;
+  }
+
+  const std::vector<AddressRange>& getRanges() const { return m_ranges; }
+  std::size_t size() const { return m_ranges.size(); }
+  bool empty() const { return m_ranges.empty(); }
+
+  void resetCounters() {
+    for ( auto& range : m_ranges ) {
+      range.counters = RangeCounters();
+    }
+  }
+
+ private:
+  // Padding entries start past every address and are empty
+  void rebuildIndex() {
+    std::size_t size = std::bit_ceil( m_ranges.size() );
+    m_begins.assign( size, std::numeric_limits<std::uint32_t>::max() );
+    m_ends.assign( size, 0 );
+    for ( std::size_t i = 0; i < m_ranges.size(); i++ ) {
+      m_begins[i] = m_ranges[i].begin;
+      m_ends[i] = m_ranges[i].end;
+    }
+  }
+};
+}  // namespace memory
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <common/stats_registry.hpp>
+#include <deque>
 #include <iterator>
 #include <limits>
 #include <list>
@@ -9,6 +11,8 @@
 #include <memory/lru_evictor.hpp>
 #include <memory/main_memory.hpp>
 #include <memory/random_evictor.hpp>
+#include <stdexcept>
+#include <utility>
 
 namespace memory {
 
@@ -24,6 +28,9 @@ struct CacheMemory {
   FifoEvictor fifo_evictor;
   RandomEvictor random_evictor;
   Lru_Evictor lru_evictor;
+  std::int64_t m_num_evictions = 0;
+  std::int64_t m_num_writebacks = 0;
+  std::int32_t m_last_writeback_address = 0;
 
  public:
   CacheMemory(
@@ -41,38 +48,140 @@ struct CacheMemory {
         random_evictor( cache_blocks, m_num_blocks ),
         lru_evictor( cache_blocks ) {}
 
+  // Deep copy of other's blocks and replacement state, backed by main_memory
+  CacheMemory( const CacheMemory& other, MainMemory& main_memory )
+      : m_main_memory( main_memory ),
+        m_cache_size( other.m_cache_size ),
+        m_block_size( other.m_block_size ),
+        m_num_blocks( other.m_num_blocks ),
+        cache_blocks( other.cache_blocks ),
+        m_write_policy( other.m_write_policy ),
+        m_replacement_policy( other.m_replacement_policy ),
+        fifo_evictor( other.fifo_evictor, cache_blocks ),
+        random_evictor( other.random_evictor, cache_blocks ),
+        lru_evictor( other.lru_evictor, cache_blocks ),
+        m_num_evictions( other.m_num_evictions ),
+        m_num_writebacks( other.m_num_writebacks ),
+        m_last_writeback_address( other.m_last_writeback_address ) {}
+
   std::pair<bool, std::string> read( const std::int32_t address ) {
     auto block_loc = find_block( address );
 
     if ( block_loc != cache_blocks.end() ) {
+      accessed( address );
       return { true, block_loc->read( address ) };
     }
 
     // Reaching here means add the data to the cache
     update( address );
+    accessed( address );
 
-    if ( m_replacement_policy == CacheReplacementPolicy::LRU ) {
-      lru_evictor.access( address );
+    return { false, {} };
+  }
+
+  // Like read, without copying out the data. Returns whether it hit.
+  bool touch( const std::int32_t address ) {
+    bool hit = find_block( address ) != cache_blocks.end();
+    if ( !hit ) {
+      update( address );
     }
+    accessed( address );
+    return hit;
+  }
 
-    return { false, {} };
+  // Blocks start at multiples of the block size
+  std::int32_t getBlockAddress( const std::int32_t address ) const {
+    return address - address % m_block_size;
   }
 
-  auto getCacheSize() { return m_cache_size; }
+  auto getCacheSize() const { return m_cache_size; }
+
+  auto getBlockSize() const { return m_block_size; }
+
+  auto getNumofBlocks() const { return m_num_blocks; }
 
-  auto getBlockSize() { return m_block_size; }
+  auto getReplacementPolicy() const { return m_replacement_policy; }
 
-  auto getNumofBlocks() { return m_num_blocks; }
+  auto getWritePolicy() const { return m_write_policy; }
 
-  auto getReplacementPolicy() { return m_replacement_policy; }
+  std::int64_t getNumEvictions() const { return m_num_evictions; }
+  std::int64_t getNumWritebacks() const { return m_num_writebacks; }
 
-  auto getWritePolicy() { return m_write_policy; }
+  // Start of the block written back most recently
+  std::int32_t getLastWritebackAddress() const {
+    return m_last_writeback_address;
+  }
+
+  void setEvictionCounts( std::int64_t num_evictions,
+                          std::int64_t num_writebacks ) {
+    m_num_evictions = num_evictions;
+    m_num_writebacks = num_writebacks;
+  }
+
+  // State of the RANDOM replacement's generator
+  std::uint64_t getRandomState() const {
+    return random_evictor.getRandomState();
+  }
+  void setRandomState( std::uint64_t state ) {
+    random_evictor.setRandomState( state );
+  }
+
+  void registerStats( common::StatsRegistry& stats,
+                      const std::string& prefix ) const {
+    stats.addCounter( prefix + ".size", m_cache_size, "Bytes" );
+    stats.addCounter( prefix + ".block_size", m_block_size, "Bytes" );
+    stats.addCounter( prefix + ".num_blocks", m_num_blocks );
+    stats.addCounter( prefix + ".evictions", m_num_evictions );
+    stats.addCounter( prefix + ".writebacks", m_num_writebacks,
+                      "Dirty blocks written to memory on eviction" );
+  }
+
+  // Blocks in insertion order, which is the FIFO eviction order
+  const std::list<CacheBlock>& getBlocks() const { return cache_blocks; }
+
+  // Addresses in LRU order, only maintained for the LRU policy
+  const std::deque<std::int32_t>& getLruOrder() const {
+    return lru_evictor.getAccessOrder();
+  }
+
+  // Replaces the cache contents, e.g. when restoring a checkpoint
+  void restoreBlocks( std::list<CacheBlock> blocks,
+                      std::deque<std::int32_t> lru_order ) {
+    if ( blocks.size() > std::size_t( m_num_blocks ) ) {
+      throw std::invalid_argument( "More blocks than the cache holds" );
+    }
+    cache_blocks = std::move( blocks );  // Evictors keep referring to it
+    lru_evictor.setAccessOrder( std::move( lru_order ) );
+  }
+
+  // Like read, but a miss leaves the cache and replacement state unchanged
+  std::pair<bool, std::string> peek( const std::int32_t address ) {
+    auto block_loc = find_block( address );
+    if ( block_loc != cache_blocks.end() ) {
+      return { true, block_loc->read( address ) };
+    }
+    return { false, {} };
+  }
+
+  // Writes back the dirty blocks and empties the cache
+  void flush() {
+    for ( CacheBlock& block : cache_blocks ) {
+      if ( block.isDirty() && m_write_policy == CacheWritePolicy::WRITEBACK ) {
+        m_num_writebacks++;
+        m_main_memory.write( block.getStartingAddress(),
+                             block.get_raw_block_data() );
+      }
+    }
+    cache_blocks.clear();
+    lru_evictor.setAccessOrder( {} );
+  }
 
   bool write( const std::int32_t address, const std::string& data ) {
     auto block_loc = find_block( address );
 
     if ( block_loc != cache_blocks.end() ) {
       block_loc->write( address, data );
+      accessed( address );
 
       if ( m_write_policy == CacheWritePolicy::WRITETHROUGH ) {
         m_main_memory.write( address, data );
@@ -94,9 +203,17 @@ struct CacheMemory {
     return loc;
   }
 
+  // Moves the block of address to the back of the LRU order
+  void accessed( const std::int32_t address ) {
+    if ( m_replacement_policy == CacheReplacementPolicy::LRU ) {
+      lru_evictor.access( getBlockAddress( address ) );
+    }
+  }
+
   CacheBlock update( const std::int32_t address ) {
-    std::string block_data = m_main_memory.read( address, m_block_size );
-    CacheBlock cache_block = createCacheBlock( address, block_data );
+    std::int32_t block_address = getBlockAddress( address );
+    std::string block_data = m_main_memory.read( block_address, m_block_size );
+    CacheBlock cache_block = createCacheBlock( block_address, block_data );
 
     if ( cache_blocks.size() < m_num_blocks ) {
       cache_blocks.push_back( cache_block );
@@ -112,7 +229,7 @@ struct CacheMemory {
                                const std::string& block_data ) {
     CacheBlock cache_block( m_block_size );
 
-    for ( auto i = 0; i < m_block_size / 4; i += 4 ) {
+    for ( auto i = 0; i < m_block_size; i += 4 ) {
       cache_block.add_entry( address + i, block_data.substr( i * 8, 32 ) );
     }
 
@@ -121,11 +238,14 @@ struct CacheMemory {
 
   void evict_block() {
     CacheBlock evicted_block = removeBlock();
+    m_num_evictions++;
 
     if ( evicted_block.isDirty() &&
          m_write_policy == CacheWritePolicy::WRITEBACK ) {
+      m_num_writebacks++;
       auto starting_address = evicted_block.getStartingAddress();
       auto block_data = evicted_block.get_raw_block_data();
+      m_last_writeback_address = starting_address;
 
       m_main_memory.write( starting_address, block_data );
     }
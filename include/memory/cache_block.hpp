@@ -34,7 +34,12 @@ struct CacheBlock {
     return m_entries.contains( address );
   }
 
-  bool isDirty() { return m_is_dirty; }
+  bool isDirty() const { return m_is_dirty; }
+  void setDirty( bool is_dirty ) { m_is_dirty = is_dirty; }
+
+  const std::unordered_map<std::int32_t, std::string>& getEntries() const {
+    return m_entries;
+  }
 
   std::int32_t getStartingAddress() {
     auto sorted_addresses = getAddressesPresent();
@@ -1,6 +1,49 @@
 #pragma once
 
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
 namespace memory {
 enum CacheWritePolicy { WRITEBACK, WRITETHROUGH };
 enum CacheReplacementPolicy { FIFO, RANDOM, LRU };
-}  // namespace memory
\ No newline at end of file
+
+// Which of the three streams of a Dinero trace an access belongs to
+enum AccessType { READ = 0, WRITE = 1, FETCH = 2 };
+
+inline std::string_view toString( CacheWritePolicy write_policy ) {
+  return write_policy == WRITEBACK ? "WRITEBACK" : "WRITETHROUGH";
+}
+
+inline std::string_view toString( CacheReplacementPolicy replacement_policy ) {
+  switch ( replacement_policy ) {
+    case FIFO:
+      return "FIFO";
+    case RANDOM:
+      return "RANDOM";
+    case LRU:
+      return "LRU";
+  }
+  return "";
+}
+
+inline CacheWritePolicy parseWritePolicy( std::string_view name ) {
+  if ( name == "WRITEBACK" ) {
+    return WRITEBACK;
+  }
+  if ( name == "WRITETHROUGH" ) {
+    return WRITETHROUGH;
+  }
+  throw std::invalid_argument( "Unknown write policy : " + std::string( name ) );
+}
+
+inline CacheReplacementPolicy parseReplacementPolicy( std::string_view name ) {
+  for ( auto policy : { FIFO, RANDOM, LRU } ) {
+    if ( name == toString( policy ) ) {
+      return policy;
+    }
+  }
+  throw std::invalid_argument( "Unknown replacement policy : " +
+                               std::string( name ) );
+}
+}  // namespace memory
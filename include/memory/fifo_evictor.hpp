@@ -11,6 +11,10 @@ struct FifoEvictor {
  public:
   FifoEvictor( std::list<CacheBlock>& cache_blocks )
       : m_cache_blocks( cache_blocks ) {}
+  // Copy of another evictor that evicts from cache_blocks
+  FifoEvictor( const FifoEvictor&, std::list<CacheBlock>& cache_blocks )
+      : m_cache_blocks( cache_blocks ) {}
+
   CacheBlock evict() {
     CacheBlock evicted_block = m_cache_blocks.front();
     m_cache_blocks.pop_front();
@@ -15,6 +15,9 @@ struct Lru_Evictor {
  public:
   Lru_Evictor( std::list<CacheBlock>& cache_blocks )
       : m_cache_blocks( cache_blocks ) {}
+  // Copy of other, including its access order, that evicts from cache_blocks
+  Lru_Evictor( const Lru_Evictor& other, std::list<CacheBlock>& cache_blocks )
+      : m_cache_blocks( cache_blocks ), m_addresses( other.m_addresses ) {}
 
   CacheBlock evict() {
     CacheBlock evicted_block = *( findBlock( m_addresses.front() ) );
@@ -23,6 +26,12 @@ struct Lru_Evictor {
     return evicted_block;
   }
 
+  // Least recently used first
+  const std::deque<std::int32_t>& getAccessOrder() const { return m_addresses; }
+  void setAccessOrder( std::deque<std::int32_t> addresses ) {
+    m_addresses = std::move( addresses );
+  }
+
   void access( std::int32_t address ) {
     auto adr_present =
         std::find( m_addresses.begin(), m_addresses.end(), address );
@@ -1,33 +1,142 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <common/stats_registry.hpp>
+#include <cstddef>
+#include <cstdint>
 #include <iterator>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace memory {
+// Memory is split into fixed size pages that copies share until one of them
+// writes to a page ( copy-on-write ), which makes copying a MainMemory cheap.
+// Initially every page is the same shared page of fill values.
 struct MainMemory {
-  std::string m_raw_memory;
+  static constexpr std::int32_t page_size = 256;  // Bytes
+
+ private:
+  // One char per bit, 8 per byte
+  using Page = std::string;
+
+  std::vector<std::shared_ptr<Page>> m_pages;
+  std::int32_t m_memory_size;
+  std::int64_t m_num_reads = 0;
+  std::int64_t m_num_writes = 0;
 
  public:
   MainMemory( const std::int32_t memory_size, const char fill_val )
-      : m_raw_memory( memory_size * 8, fill_val ) {}
+      : m_memory_size( memory_size ) {
+    auto fill_page =
+        std::make_shared<Page>( translate( page_size ), fill_val );
+    m_pages.assign( ( memory_size + page_size - 1 ) / page_size, fill_page );
+  }
 
   std::string read( const std::int32_t address, const std::int32_t num_bytes ) {
-    std::string data(
-        m_raw_memory.begin() + translate( address ),
-        m_raw_memory.begin() + translate( address ) + translate( num_bytes ) );
+    m_num_reads++;
+    std::string data;
+    data.reserve( translate( num_bytes ) );
+    forEachSegment( address, translate( num_bytes ),
+                    [&]( std::size_t page, std::size_t offset, std::size_t,
+                         std::size_t length ) {
+                      const Page& src = *m_pages[page];
+                      data.append( src, offset, length );
+                    } );
     return data;
   }
 
   void write( const std::int32_t address, const std::string& data ) {
-    auto start_pos = m_raw_memory.begin() + translate( address );
-    std::copy( data.begin(), data.end(), start_pos );
+    m_num_writes++;
+    forEachSegment( address, data.size(),
+                    [&]( std::size_t page, std::size_t offset,
+                         std::size_t data_pos, std::size_t length ) {
+                      Page& dst = getWritablePage( page );
+                      std::copy_n( data.begin() + data_pos, length,
+                                   dst.begin() + offset );
+                    } );
+  }
+
+  auto getSize() const { return std::size_t( translate( m_memory_size ) ); }
+
+  std::int32_t getMemorySize() const { return m_memory_size; }
+
+  std::int32_t getNumPages() const { return m_pages.size(); }
+
+  // Contents of a whole page, one char per bit
+  const std::string& getPageData( std::int32_t page_index ) const {
+    return *m_pages[page_index];
+  }
+
+  void setPageData( std::int32_t page_index, std::string data ) {
+    if ( data.size() != std::size_t( page_size ) * 8 ) {
+      throw std::invalid_argument( "Page data has the wrong size" );
+    }
+    m_pages[page_index] = std::make_shared<Page>( std::move( data ) );
   }
 
-  auto getSize() { return m_raw_memory.size(); }
+  std::int64_t getNumReads() const { return m_num_reads; }
+  std::int64_t getNumWrites() const { return m_num_writes; }
+
+  void setAccessCounts( std::int64_t num_reads, std::int64_t num_writes ) {
+    m_num_reads = num_reads;
+    m_num_writes = num_writes;
+  }
+
+  void registerStats( common::StatsRegistry& stats,
+                      const std::string& prefix ) const {
+    stats.addCounter( prefix + ".size", m_memory_size, "Bytes" );
+    stats.addCounter( prefix + ".reads", m_num_reads );
+    stats.addCounter( prefix + ".writes", m_num_writes );
+  }
+
+  // True if page_index is shared with another copy of this memory
+  bool isPageShared( std::int32_t page_index ) const {
+    return m_pages[page_index].use_count() > 1;
+  }
 
  private:
   // Helpers
-  std::int32_t translate( const std::int32_t address ) { return address * 8; }
+  std::int32_t translate( const std::int32_t address ) const {
+    return address * 8;
+  }
+
+  // Calls func( page, offset in page, offset in data, length ) for each
+  // page touched by the num_chars long range starting at address
+  template <typename Func>
+  void forEachSegment( const std::int32_t address, std::size_t num_chars,
+                       Func&& func ) {
+    if ( address < 0 ||
+         std::size_t( translate( address ) ) + num_chars > getSize() ) {
+      throw std::out_of_range( "Memory access out of range : " +
+                               std::to_string( address ) );
+    }
+    std::size_t page_chars = translate( page_size );
+    std::size_t position = translate( address );
+    std::size_t data_pos = 0;
+    while ( data_pos < num_chars ) {
+      std::size_t page = position / page_chars;
+      std::size_t offset = position % page_chars;
+      std::size_t length =
+          std::min( page_chars - offset, num_chars - data_pos );
+      func( page, offset, data_pos, length );
+      position += length;
+      data_pos += length;
+    }
+  }
+
+  Page& getWritablePage( std::size_t page_index ) {
+    std::shared_ptr<Page>& page = m_pages[page_index];
+    if ( page.use_count() > 1 ) {
+      page = std::make_shared<Page>( *page );
+    } else {
+      // Pairs with the release of the last other owner dropping the page
+      std::atomic_thread_fence( std::memory_order_acquire );
+    }
+    return *page;
+  }
 };
 }  // namespace memory
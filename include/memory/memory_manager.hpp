@@ -1,15 +1,30 @@
 #pragma once
 
+#include <fmt/core.h>
+
+#include <cctype>
+#include <common/stats_registry.hpp>
 #include <cpu/state_data.hpp>
+#include <memory/address_range_table.hpp>
 #include <memory/cache.hpp>
 #include <memory/main_memory.hpp>
+#include <string>
 
 namespace memory {
 struct MemoryManager {
+  // TIMED accesses are charged to the CPU and counted. WARMING ones update
+  // the cache exactly as TIMED ones would, but take no time and are not
+  // counted, except by the cache's own eviction counters. FUNCTIONAL ones
+  // take no time, are not counted and do not bring blocks into the cache,
+  // blocks already cached stay coherent.
+  enum Mode { TIMED, WARMING, FUNCTIONAL };
+
  private:
   memory::MainMemory main_memory;
   memory::CacheMemory cache_memory;
   cpu::StateData* sys_state;
+  Mode m_mode = TIMED;
+  AddressRangeTable m_watch_ranges;
 
  public:
   MemoryManager( const std::int32_t memory_size, const std::int32_t cache_size,
@@ -22,31 +37,158 @@ struct MemoryManager {
                       replacement_policy ),
         sys_state( system_state ) {}
 
-  std::string read( const std::int32_t address, std::int32_t num_bytes ) {
+  // Copy of other for system_state. Main memory pages are shared until
+  // written, cache contents are copied.
+  MemoryManager( const MemoryManager& other, cpu::StateData* system_state )
+      : main_memory( other.main_memory ),
+        cache_memory( other.cache_memory, main_memory ),
+        sys_state( system_state ),
+        m_mode( other.m_mode ),
+        m_watch_ranges( other.m_watch_ranges ) {}
+
+  // A plain copy would keep using the other manager's memory and state
+  MemoryManager( const MemoryManager& ) = delete;
+  MemoryManager& operator=( const MemoryManager& ) = delete;
+
+  void setMode( Mode mode ) { m_mode = mode; }
+  Mode getMode() const { return m_mode; }
+
+  // Counts the data reads, writes, hits, misses and writebacks of
+  // [begin, end) separately from now on, e.g. for one array of the guest
+  // program. Hits and misses follow cache.hits and cache.misses, and
+  // instruction fetches are not counted.
+  void addWatchRange( const std::string& name, std::uint32_t begin,
+                      std::uint32_t end ) {
+    m_watch_ranges.add( name, begin, end );
+  }
+
+  const AddressRangeTable& getWatchRanges() const { return m_watch_ranges; }
+
+  // Time is charged as a fetch if is_fetch is set, as a load otherwise
+  std::string read( const std::int32_t address, std::int32_t num_bytes,
+                    bool is_fetch = false ) {
+    if ( m_mode == FUNCTIONAL ) {
+      auto [data_present, data] = cache_memory.peek( address );
+      return data_present ? data : main_memory.read( address, num_bytes );
+    }
+    if ( m_mode == WARMING ) {
+      auto [data_present, data] = cache_memory.read( address );
+      return data_present ? data : main_memory.read( address, num_bytes );
+    }
+    RangeCounters* counters =
+        is_fetch ? nullptr : m_watch_ranges.findCounters( address );
+    std::int64_t writebacks = cache_memory.getNumWritebacks();
     auto [data_present, data] = cache_memory.read( address );
+    if ( counters ) {
+      counters->reads++;
+      ( data_present ? counters->hits : counters->misses )++;
+    }
+    if ( cache_memory.getNumWritebacks() != writebacks ) {
+      countWriteback();
+    }
     if ( !data_present ) {
       // For a miss mem_access_time + cache_miss_penalty
-      sys_state->cycles_consumed +=
-          sys_state->memory_access_latency + sys_state->cache_miss_penalty;
+      sys_state->charge( is_fetch ? cpu::FETCH_MISS : cpu::LOAD_MISS,
+                         sys_state->timing.memory_access_latency +
+                             sys_state->timing.cache_miss_penalty );
       sys_state->cache_miss += 1;
       return main_memory.read( address, num_bytes );
     }
     // For a hit cycles consumed will be
-    sys_state->cycles_consumed += sys_state->cache_hit_time;
+    sys_state->charge( is_fetch ? cpu::FETCH : cpu::LOAD,
+                       sys_state->timing.cache_hit_time );
     sys_state->cache_hits += 1;
     return data;
   }
 
+  // Updates the cache as a read of address would in WARMING mode, without
+  // copying out the data. Does nothing in FUNCTIONAL mode.
+  void touch( const std::int32_t address ) {
+    if ( m_mode != FUNCTIONAL ) {
+      cache_memory.touch( address );
+    }
+  }
+
   void write( const std::int32_t address, const std::string& data ) {
+    if ( address < sys_state->halt_adr ) {
+      sys_state->code_version++;
+    }
+    if ( m_mode != TIMED ) {
+      if ( !cache_memory.write( address, data ) ) {
+        main_memory.write( address, data );
+      }
+      return;
+    }
+    RangeCounters* counters = m_watch_ranges.findCounters( address );
+    if ( counters ) {
+      counters->writes++;
+    }
     if ( !cache_memory.write( address, data ) ) {
-      sys_state->cycles_consumed +=
-          sys_state->memory_access_latency + sys_state->cache_miss_penalty;
+      if ( counters ) {
+        counters->misses++;
+      }
+      sys_state->charge( cpu::STORE_MISS,
+                         sys_state->timing.memory_access_latency +
+                             sys_state->timing.cache_miss_penalty );
       sys_state->cache_miss += 1;
       main_memory.write( address, data );
     }
   }
 
+  // Hits and misses are counted in the CPU state, the rest by the cache and
+  // main memory themselves
+  void registerStats( common::StatsRegistry& stats ) const {
+    const cpu::StateData* state = sys_state;
+    stats.addCounter( "cache.hits", state->cache_hits );
+    stats.addCounter( "cache.misses", state->cache_miss );
+    stats.addFormula( "cache.hit_rate", [state]() {
+      std::int64_t accesses = state->cache_hits + state->cache_miss;
+      return state->cache_hits / double( accesses );
+    } );
+    cache_memory.registerStats( stats, "cache" );
+    main_memory.registerStats( stats, "mem" );
+    for ( auto& range : m_watch_ranges.getRanges() ) {
+      std::string prefix = "range." + getStatName( range.name );
+      std::string where = fmt::format( " in {} [{:#x}, {:#x})", range.name,
+                                       range.begin, range.end );
+      const RangeCounters& counters = range.counters;
+      stats.addCounter( prefix + ".reads", counters.reads, "Reads" + where );
+      stats.addCounter( prefix + ".writes", counters.writes,
+                        "Writes" + where );
+      stats.addCounter( prefix + ".hits", counters.hits,
+                        "Cache hits" + where );
+      stats.addCounter( prefix + ".misses", counters.misses,
+                        "Cache misses" + where );
+      stats.addCounter( prefix + ".writebacks", counters.writebacks,
+                        "Dirty blocks written back" + where );
+    }
+  }
+
   auto getMainMemory() { return main_memory; }
   auto getCacheMemory() { return cache_memory; }
+
+  // Direct access, without copying, for checkpointing
+  memory::MainMemory& getMainMemoryRef() { return main_memory; }
+  memory::CacheMemory& getCacheMemoryRef() { return cache_memory; }
+  const memory::MainMemory& getMainMemoryRef() const { return main_memory; }
+  const memory::CacheMemory& getCacheMemoryRef() const { return cache_memory; }
+
+ private:
+  // Charged to the range of the evicted block, whatever evicted it
+  void countWriteback() {
+    if ( RangeCounters* counters = m_watch_ranges.findCounters(
+             cache_memory.getLastWritebackAddress() ) ) {
+      counters->writebacks++;
+    }
+  }
+
+  // Lower case letters, digits and underscores only
+  static std::string getStatName( const std::string& name ) {
+    std::string stat_name;
+    for ( unsigned char c : name ) {
+      stat_name += std::isalnum( c ) ? char( std::tolower( c ) ) : '_';
+    }
+    return stat_name;
+  }
 };
 }  // namespace memory
\ No newline at end of file
@@ -1,19 +1,40 @@
 #pragma once
 
+#include <cstdint>
 #include <iterator>
 #include <list>
 #include <memory/cache_block.hpp>
-#include <random>
 
 namespace memory {
+// xorshift64 from a fixed seed, so random replacement is reproducible and
+// can be checkpointed
+struct XorShift64 {
+  std::uint64_t state = 0x9e3779b97f4a7c15ull;
+
+  std::uint64_t next() {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+  }
+};
+
 struct RandomEvictor {
  private:
   std::list<CacheBlock>& m_cache_blocks;
   std::int32_t m_num_blocks;
+  XorShift64 m_random;
 
  public:
   RandomEvictor( std::list<CacheBlock>& cache_blocks, std::int32_t num_blocks )
       : m_cache_blocks( cache_blocks ), m_num_blocks( num_blocks ) {}
+  // Copy of other, including its random state, that evicts from
+  // cache_blocks
+  RandomEvictor( const RandomEvictor& other,
+                 std::list<CacheBlock>& cache_blocks )
+      : m_cache_blocks( cache_blocks ),
+        m_num_blocks( other.m_num_blocks ),
+        m_random( other.m_random ) {}
 
   CacheBlock evict() {
     long offset = generateRandomNumber();
@@ -28,12 +49,10 @@ struct RandomEvictor {
   }
 
   std::int32_t generateRandomNumber() {
-    std::random_device dev;
-    std::mt19937 rng( dev() );
-    std::uniform_int_distribution<std::mt19937::result_type> dist(
-        0, m_num_blocks - 1 );
-
-    return dist( rng );
+    return std::int32_t( m_random.next() % m_num_blocks );
   }
+
+  std::uint64_t getRandomState() const { return m_random.state; }
+  void setRandomState( std::uint64_t state ) { m_random.state = state; }
 };
 }  // namespace memory
@@ -84,4 +84,33 @@ BOOST_AUTO_TEST_CASE( assembler_test_3_large_file_newline_delimited ) {
   BOOST_REQUIRE_EQUAL( file_stream.str(), resultant_binary );
 }
 
+BOOST_AUTO_TEST_CASE( assembler_test_parallel_matches_serial ) {
+  // Large enough to be split into several chunks, with labels that are
+  // referenced across chunk boundaries in both directions
+  {
+    std::fstream file( "parallel_sample.s", std::fstream::out );
+    for ( auto i = 0; i < 100000; i++ ) {
+      if ( i % 500 == 0 ) {
+        file << "l" << i << ":\n";
+      }
+      if ( i % 7 == 0 ) {
+        file << "beq r1 r2 l" << ( i / 500 + 1 ) * 500 << "\n";
+      } else if ( i % 11 == 0 && i % 500 != 0 ) {
+        file << "bne r1 r2 l" << ( i / 500 ) * 500 << "\n";
+      } else {
+        file << "add r1, r2, r3\n";
+      }
+    }
+    file << "l100000:\n";
+  }
+
+  turbo_asm serial_engine( "parallel_sample.s", 1 );
+  turbo_asm parallel_engine( "parallel_sample.s", 4 );
+
+  BOOST_REQUIRE_EQUAL( parallel_engine.getInstructions().size(),
+                       serial_engine.getInstructions().size() );
+  BOOST_REQUIRE( parallel_engine.dumpBinary( '\n' ) ==
+                 serial_engine.dumpBinary( '\n' ) );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
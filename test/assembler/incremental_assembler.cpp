@@ -0,0 +1,151 @@
+#define BOOST_TEST_MODULE incremental_assembler_test
+
+#include <assembler/assembler.hpp>
+#include <assembler/incremental_assembler.hpp>
+#include <boost/test/unit_test.hpp>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <test_helpers.hpp>
+#include <vector>
+
+using namespace assembler;
+
+std::string readSample( const std::string& filename ) {
+  std::fstream file( filename );
+  std::stringstream file_stream;
+  file_stream << file.rdbuf();
+  return file_stream.str();
+}
+
+// Reference binary from a full turbo_asm run over the same source
+std::string assembleWithTurbo( const std::string& source ) {
+  {
+    std::fstream file( "incremental_reference.s", std::fstream::out );
+    file << source;
+  }
+  turbo_asm asm_engine( "incremental_reference.s", 1 );
+  return asm_engine.dumpBinary( '\n' );
+}
+
+void replaceLine( std::string& source, const std::string& old_line,
+                  const std::string& new_line ) {
+  source.replace( source.find( old_line ), old_line.size(), new_line );
+}
+
+BOOST_AUTO_TEST_SUITE( incremental_assembler_test )
+
+BOOST_AUTO_TEST_CASE( initial_load_matches_turbo_asm ) {
+  incremental_asm inc_engine( get_examples_dir() + "sample9.s" );
+  turbo_asm asm_engine( get_examples_dir() + "sample9.s" );
+
+  BOOST_REQUIRE_EQUAL( inc_engine.dumpBinary( '\n' ),
+                       asm_engine.dumpBinary( '\n' ) );
+}
+
+BOOST_AUTO_TEST_CASE( edit_without_size_change ) {
+  std::string source = readSample( get_examples_dir() + "sample9.s" );
+  incremental_asm inc_engine;
+  inc_engine.update( source );
+  inc_engine.dumpBinary();
+
+  replaceLine( source, "bne r1 r17 m2", "blt r1 r17 m2" );
+  inc_engine.update( source );
+
+  BOOST_REQUIRE_EQUAL( inc_engine.getReparsedLineCount(), 1 );
+  BOOST_REQUIRE_EQUAL( inc_engine.dumpBinary( '\n' ),
+                       assembleWithTurbo( source ) );
+  BOOST_REQUIRE_EQUAL( inc_engine.getResolvedLineCount(), 1 );
+}
+
+BOOST_AUTO_TEST_CASE( inserted_instruction_shifts_crossing_branches ) {
+  std::string source = readSample( get_examples_dir() + "sample9.s" );
+  incremental_asm inc_engine;
+  inc_engine.update( source );
+  inc_engine.dumpBinary();
+
+  // Inside the loop, so the loop branches and the jal crossing it change
+  replaceLine( source, "and r6 r6 r6\nbeq", "and r6 r6 r6\nor r7 r7 r7\nbeq" );
+  inc_engine.update( source );
+
+  BOOST_REQUIRE_EQUAL( inc_engine.getReparsedLineCount(), 1 );
+  BOOST_REQUIRE_EQUAL( inc_engine.dumpBinary( '\n' ),
+                       assembleWithTurbo( source ) );
+  BOOST_REQUIRE( inc_engine.getResolvedLineCount() > 0 );
+  BOOST_REQUIRE( inc_engine.getResolvedLineCount() <
+                 inc_engine.getLineCount() );
+}
+
+BOOST_AUTO_TEST_CASE( moved_and_removed_labels ) {
+  std::string source = readSample( get_examples_dir() + "sample9.s" );
+  incremental_asm inc_engine;
+  inc_engine.update( source );
+
+  replaceLine( source, "lp_end:\n", "" );
+  replaceLine( source, "or r6 r6 r6", "lp_end: or r6 r6 r6" );
+  inc_engine.update( source );
+  BOOST_REQUIRE_EQUAL( inc_engine.dumpBinary( '\n' ),
+                       assembleWithTurbo( source ) );
+
+  replaceLine( source, "end:\n", "" );
+  inc_engine.update( source );
+  BOOST_REQUIRE_EQUAL( inc_engine.dumpBinary( '\n' ),
+                       assembleWithTurbo( source ) );
+}
+
+// Pairs of a label and a branch back to it, spread over many blocks
+std::vector<std::string> makeLoops( int num_loops ) {
+  std::vector<std::string> lines;
+  for ( int i = 0; i < num_loops; i++ ) {
+    lines.push_back( "l" + std::to_string( i ) + ":" );
+    lines.push_back( "add r1 r1 r1" );
+    lines.push_back( "beq r1 r2 l" + std::to_string( i ) );
+  }
+  return lines;
+}
+
+std::string joinLines( const std::vector<std::string>& lines ) {
+  std::string source;
+  for ( auto& line : lines ) {
+    source += line + "\n";
+  }
+  return source;
+}
+
+BOOST_AUTO_TEST_CASE( edits_across_blocks ) {
+  auto lines = makeLoops( 2000 );
+  incremental_asm inc_engine;
+  inc_engine.replaceLines( 0, 0, { lines.begin(), lines.end() } );
+  BOOST_REQUIRE_EQUAL( inc_engine.dumpBinary( '\n' ),
+                       assembleWithTurbo( joinLines( lines ) ) );
+
+  // Only the branch around the new instruction crosses it
+  lines.insert( lines.begin() + 3001, "or r7 r7 r7" );
+  inc_engine.replaceLines( 3001, 0, { "or r7 r7 r7" } );
+  BOOST_REQUIRE_EQUAL( inc_engine.getReparsedLineCount(), 1 );
+  BOOST_REQUIRE_EQUAL( inc_engine.dumpBinary( '\n' ),
+                       assembleWithTurbo( joinLines( lines ) ) );
+  BOOST_REQUIRE_EQUAL( inc_engine.getResolvedLineCount(), 1 );
+
+  // Removes whole blocks and leaves a branch to a removed label
+  lines.erase( lines.begin() + 100, lines.begin() + 1100 );
+  inc_engine.replaceLines( 100, 1000, {} );
+  BOOST_REQUIRE_EQUAL( inc_engine.getLineCount(), lines.size() );
+  BOOST_REQUIRE_EQUAL( inc_engine.dumpBinary( '\n' ),
+                       assembleWithTurbo( joinLines( lines ) ) );
+
+  lines.push_back( "jal r5 l0" );
+  inc_engine.replaceLines( inc_engine.getLineCount(), 0, { "jal r5 l0" } );
+  BOOST_REQUIRE_EQUAL( inc_engine.dumpBinary( '\n' ),
+                       assembleWithTurbo( joinLines( lines ) ) );
+  BOOST_REQUIRE_EQUAL( inc_engine.getResolvedLineCount(), 1 );
+}
+
+BOOST_AUTO_TEST_CASE( replace_lines_out_of_range ) {
+  incremental_asm inc_engine( get_examples_dir() + "sample2.s" );
+
+  BOOST_REQUIRE_THROW( inc_engine.replaceLines( 1, 10, {} ),
+                       std::out_of_range );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
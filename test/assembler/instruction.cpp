@@ -26,7 +26,7 @@ BOOST_AUTO_TEST_CASE( get_operand ) {
   Instruction test_instr( "label: add r1 r2 r3" );
 
   BOOST_REQUIRE_EQUAL(
-      ( (Register*)test_instr.getOperand( 0 ).get() )->getName(), "r1" );
+      std::get<Register>( test_instr.getOperand( 0 ) ).getName(), "r1" );
 }
 BOOST_AUTO_TEST_CASE( get_operand_count ) {
   Instruction test_instr( "label: add r1 r2 r3" );
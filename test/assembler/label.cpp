@@ -4,7 +4,6 @@
 #include <boost/test/unit_test.hpp>
 #include <cstddef>
 #include <cstdint>
-#include <range/v3/all.hpp>
 #include <string>
 
 using namespace assembler;
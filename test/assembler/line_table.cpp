@@ -0,0 +1,68 @@
+#define BOOST_TEST_MODULE line_table_test
+
+#include <assembler/assembler.hpp>
+#include <assembler/line_table.hpp>
+#include <boost/test/unit_test.hpp>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <test_helpers.hpp>
+
+using namespace assembler;
+
+BOOST_AUTO_TEST_SUITE( line_table_test )
+
+// Label only and blank lines take no address
+BOOST_AUTO_TEST_CASE( line_numbers ) {
+  {
+    std::fstream file( "line_table_sample.s", std::fstream::out );
+    file << "add r1 r2 r3\n"
+            "\n"
+            "loop:\n"
+            "sub r2 r2 r3\n"
+            "end: beq r2 r1 loop\n"
+            "xor r1 r1 r1";
+  }
+  turbo_asm engine( "line_table_sample.s" );
+  LineTable line_table = engine.getLineTable();
+  BOOST_REQUIRE_EQUAL( line_table.size(), 4 );
+  BOOST_REQUIRE_EQUAL( line_table.getLine( 0 ), 1 );
+  BOOST_REQUIRE_EQUAL( line_table.getLine( 4 ), 4 );
+  BOOST_REQUIRE_EQUAL( line_table.getLine( 8 ), 5 );
+  BOOST_REQUIRE_EQUAL( line_table.getLine( 12 ), 6 );
+  BOOST_REQUIRE_EQUAL( line_table.getLine( 16 ), 0 );
+  BOOST_REQUIRE_EQUAL( line_table.size() * 32, engine.dumpBinary().size() );
+}
+
+BOOST_AUTO_TEST_CASE( write_and_read ) {
+  turbo_asm engine( get_examples_dir() + "sample9.s" );
+  engine.dumpLineTable( "sample9.lines" );
+  std::ifstream file( "sample9.lines" );
+  BOOST_REQUIRE( LineTable::read( file ) == engine.getLineTable() );
+
+  std::istringstream gap( "0 1\n8 2\n" );
+  BOOST_REQUIRE_THROW( LineTable::read( gap ), std::runtime_error );
+  std::istringstream garbage( "0 1\nx\n" );
+  BOOST_REQUIRE_THROW( LineTable::read( garbage ), std::runtime_error );
+}
+
+// Chunks assembled in parallel continue the line numbers of the previous
+BOOST_AUTO_TEST_CASE( parallel_matches_serial ) {
+  {
+    std::fstream file( "line_table_parallel.s", std::fstream::out );
+    for ( auto i = 0; i < 100000; i++ ) {
+      if ( i % 300 == 0 ) {
+        file << "l" << i << ":\n\n";
+      }
+      file << "add r1, r2, r3\n";
+    }
+  }
+  turbo_asm serial_engine( "line_table_parallel.s", 1 );
+  turbo_asm parallel_engine( "line_table_parallel.s", 4 );
+  LineTable line_table = parallel_engine.getLineTable();
+  BOOST_REQUIRE( line_table == serial_engine.getLineTable() );
+  BOOST_REQUIRE_EQUAL( line_table.size(), 100000 );
+  BOOST_REQUIRE_EQUAL( line_table.getLine( 4 * 99999 ), 100000 + 334 * 2 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,52 @@
+#define BOOST_TEST_MODULE stream_assembler_test
+
+#include <assembler/assembler.hpp>
+#include <assembler/stream_assembler.hpp>
+#include <boost/test/unit_test.hpp>
+#include <fstream>
+#include <sstream>
+#include <test_helpers.hpp>
+
+using namespace assembler;
+
+BOOST_AUTO_TEST_SUITE( stream_assembler_test )
+
+BOOST_AUTO_TEST_CASE( matches_turbo_asm ) {
+  for ( std::string sample : { "sample1.s", "sample2.s", "sample3.s",
+                               "sample9.s", "cpu_sample8.s" } ) {
+    turbo_asm asm_engine( get_examples_dir() + sample );
+    stream_asm stream_engine( get_examples_dir() + sample );
+
+    BOOST_REQUIRE_EQUAL( stream_engine.dumpBinary(), asm_engine.dumpBinary() );
+    BOOST_REQUIRE_EQUAL( stream_engine.dumpBinary( '\n' ),
+                         asm_engine.dumpBinary( '\n' ) );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( forward_reference_to_file ) {
+  stream_asm stream_engine( get_examples_dir() + "sample3.s" );
+  stream_engine.dumpBinary( "stream_sample3.txt", '\n' );
+
+  std::fstream file( "stream_sample3.txt" );
+  std::stringstream file_stream;
+  file_stream << file.rdbuf();
+
+  turbo_asm asm_engine( get_examples_dir() + "sample3.s" );
+  BOOST_REQUIRE_EQUAL( file_stream.str(), asm_engine.dumpBinary( '\n' ) );
+}
+
+BOOST_AUTO_TEST_CASE( undefined_label ) {
+  {
+    std::fstream file( "stream_undefined.s", std::fstream::out );
+    file << "add r1 r2 r3\nbeq r1 r2 missing\n";
+  }
+  stream_asm stream_engine( "stream_undefined.s" );
+
+  BOOST_REQUIRE_THROW( stream_engine.dumpBinary(), std::runtime_error );
+}
+
+BOOST_AUTO_TEST_CASE( missing_file ) {
+  BOOST_REQUIRE_THROW( stream_asm( "does_not_exist.s" ), std::runtime_error );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
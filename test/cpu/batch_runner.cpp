@@ -0,0 +1,125 @@
+#define BOOST_TEST_MODULE batch_runner_test
+
+#include <boost/test/unit_test.hpp>
+#include <cpu/batch_runner.hpp>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <test_helpers.hpp>
+#include <vector>
+
+using namespace cpu;
+
+std::vector<BatchProgram> get_programs() {
+  std::vector<BatchProgram> programs;
+  for ( auto name : { "sample9.s", "cpu_sample8.s" } ) {
+    programs.push_back( { name, get_program( name ) } );
+  }
+  return programs;
+}
+
+BOOST_AUTO_TEST_SUITE( batch_runner_test_suite )
+
+BOOST_AUTO_TEST_CASE( sweep_space_product ) {
+  {
+    std::fstream file( "batch_sweep.cfg", std::fstream::out );
+    file << "cache_size = 64, 128, 256  # bytes\n"
+         << "replacement_policy = FIFO, LRU\n"
+         << "alu_latency = 1, 4\n";
+  }
+  SweepSpace space = SweepSpace::fromFile( "batch_sweep.cfg" );
+  BOOST_REQUIRE_EQUAL( space.size(), 12 );
+
+  std::vector<SweepPoint> points = space.getPoints();
+  BOOST_REQUIRE_EQUAL( points.size(), 12 );
+  // Last parameter varies fastest
+  BOOST_REQUIRE_EQUAL( points[0].timing.alu_latency, 1 );
+  BOOST_REQUIRE_EQUAL( points[1].timing.alu_latency, 4 );
+  BOOST_REQUIRE_EQUAL( points[2].replacement_policy,
+                       memory::CacheReplacementPolicy::LRU );
+  BOOST_REQUIRE_EQUAL( points[11].cache_size, 256 );
+  BOOST_REQUIRE_EQUAL( points[11].block_size, 8 );
+}
+
+BOOST_AUTO_TEST_CASE( sweep_space_invalid ) {
+  SweepSpace space;
+  BOOST_REQUIRE_THROW( space.set( "cache_size", { "big" } ),
+                       std::invalid_argument );
+  BOOST_REQUIRE_THROW( space.set( "write_policy", { "WRITEAROUND" } ),
+                       std::invalid_argument );
+  BOOST_REQUIRE_THROW( space.set( "l2_size", { "1" } ), std::invalid_argument );
+}
+
+// Every run matches the same configuration simulated on its own
+BOOST_AUTO_TEST_CASE( parallel_runs_match_single_runs ) {
+  SweepSpace space;
+  space.set( "cache_size", { "64", "512" } );
+  space.set( "write_policy", { "WRITEBACK", "WRITETHROUGH" } );
+  space.set( "cache_miss_penalty", { "20", "50" } );
+  std::vector<BatchProgram> programs = get_programs();
+  std::vector<SweepPoint> points = space.getPoints();
+
+  std::ostringstream output;
+  ResultWriter writer( output, ResultWriter::Format::CSV );
+  writer.writeHeader();
+  BatchRunner runner( 4 );
+  BOOST_REQUIRE_EQUAL( runner.run( programs, points, writer ), 0 );
+
+  std::vector<std::string> rows( programs.size() * points.size() );
+  std::istringstream lines( output.str() );
+  std::string line;
+  std::getline( lines, line );  // Header
+  std::size_t num_rows = 0;
+  while ( std::getline( lines, line ) ) {
+    std::size_t run_id = std::stoul( line.substr( 0, line.find( ',' ) ) );
+    rows.at( run_id ) = line;
+    num_rows++;
+  }
+  BOOST_REQUIRE_EQUAL( num_rows, rows.size() );
+
+  for ( std::size_t run_id = 0; run_id < rows.size(); run_id++ ) {
+    const BatchProgram& program = programs[run_id / points.size()];
+    const SweepPoint& point = points[run_id % points.size()];
+    CPU cpu( point.main_memory_size, point.cache_size, point.block_size,
+             point.write_policy, point.replacement_policy, point.timing );
+    cpu.runProgram( program.binary );
+
+    InstructionStats& stats = cpu.getSystemState().instr_stats;
+    std::string expected =
+        fmt::format( ",{},{},", stats.instructions, stats.cycles );
+    BOOST_TEST_CONTEXT( rows[run_id] ) {
+      BOOST_REQUIRE( rows[run_id].find( expected ) != std::string::npos );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( json_rows ) {
+  std::vector<BatchProgram> programs = get_programs();
+  std::ostringstream output;
+  ResultWriter writer( output, ResultWriter::Format::JSON );
+  writer.writeHeader();
+  BatchRunner runner( 2 );
+  runner.run( { programs[0] }, { SweepPoint() }, writer );
+
+  std::string row = output.str();
+  BOOST_REQUIRE_EQUAL( row.front(), '{' );
+  BOOST_REQUIRE( row.find( "\"program\":\"sample9.s\"" ) != std::string::npos );
+  BOOST_REQUIRE( row.find( "\"error\":\"\"}\n" ) != std::string::npos );
+}
+
+BOOST_AUTO_TEST_CASE( json_control_characters ) {
+  std::ostringstream output;
+  ResultWriter writer( output, ResultWriter::Format::JSON );
+  RunResult result;
+  result.program_name = "tab\there";
+  result.error = "line\r\nend\x01\x1f\"\\";
+  writer.write( result );
+
+  std::string row = output.str();
+  BOOST_REQUIRE( row.find( "\"program\":\"tab\\there\"" ) !=
+                 std::string::npos );
+  std::string error = "\"error\":\"line\\r\\nend\\u0001\\u001f\\\"\\\\\"}\n";
+  BOOST_REQUIRE( row.find( error ) != std::string::npos );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
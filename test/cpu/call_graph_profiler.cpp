@@ -0,0 +1,127 @@
+#define BOOST_TEST_MODULE call_graph_profiler_test
+
+#include <assembler/assembler.hpp>
+#include <boost/test/unit_test.hpp>
+#include <cpu/call_graph_profiler.hpp>
+#include <cpu/simulator.hpp>
+#include <sstream>
+#include <string>
+#include <test_helpers.hpp>
+
+using namespace cpu;
+
+namespace {
+constexpr std::uint32_t other = 0;
+
+std::uint32_t jal( std::uint32_t rd ) {
+  return rd << 7 | isa::IsaTable::op_jal;
+}
+
+std::uint32_t jalr( std::uint32_t rd ) {
+  return rd << 7 | isa::IsaTable::op_jalr;
+}
+
+FunctionProfile find_function( const CallGraphProfiler& profiler,
+                               std::int32_t address ) {
+  for ( auto& function : profiler.getFunctions() ) {
+    if ( function.address == address ) {
+      return function;
+    }
+  }
+  BOOST_FAIL( "No function at " << address );
+  return {};
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE( call_graph_profiler_test )
+
+// main calls f, which calls g
+BOOST_AUTO_TEST_CASE( nested_calls ) {
+  CallGraphProfiler profiler( { { 0, "main" }, { 100, "f" }, { 200, "g" } } );
+  profiler.record( 0, other, 4, 1, 0 );
+  profiler.record( 4, jal( 1 ), 100, 2, 0 );
+  profiler.record( 100, other, 104, 3, 1 );
+  profiler.record( 104, jal( 1 ), 200, 1, 0 );
+  profiler.record( 200, other, 204, 5, 2 );
+  BOOST_REQUIRE_EQUAL( profiler.getDepth(), 3 );
+  profiler.record( 204, jalr( 0 ), 108, 1, 0 );
+  profiler.record( 108, jalr( 0 ), 8, 1, 0 );
+  profiler.record( 8, other, 12, 1, 0 );
+  BOOST_REQUIRE_EQUAL( profiler.getDepth(), 1 );
+
+  FunctionProfile f = find_function( profiler, 100 );
+  BOOST_REQUIRE_EQUAL( f.name, "f" );
+  BOOST_REQUIRE_EQUAL( f.calls, 1 );
+  BOOST_REQUIRE_EQUAL( f.instructions, 3 );
+  BOOST_REQUIRE_EQUAL( f.exclusive_cycles, 5 );
+  BOOST_REQUIRE_EQUAL( f.inclusive_cycles, 11 );
+  BOOST_REQUIRE_EQUAL( f.exclusive_misses, 1 );
+  BOOST_REQUIRE_EQUAL( f.inclusive_misses, 3 );
+  FunctionProfile main = profiler.getFunctions().front();
+  BOOST_REQUIRE_EQUAL( main.name, "main" );
+  BOOST_REQUIRE_EQUAL( main.exclusive_cycles, 4 );
+  BOOST_REQUIRE_EQUAL( main.inclusive_cycles, 15 );  // Still running
+
+  std::ostringstream cycles, misses;
+  profiler.writeFolded( cycles );
+  profiler.writeFolded( misses, CallGraphProfiler::MISSES );
+  BOOST_REQUIRE_EQUAL( cycles.str(), "main 4\nmain;f 5\nmain;f;g 6\n" );
+  BOOST_REQUIRE_EQUAL( misses.str(), "main;f 1\nmain;f;g 2\n" );
+}
+
+// Inclusive cycles of a recursive function count its outermost call only
+BOOST_AUTO_TEST_CASE( recursion ) {
+  CallGraphProfiler profiler;
+  profiler.record( 0, jal( 1 ), 100, 1, 0 );
+  profiler.record( 100, jal( 1 ), 100, 1, 0 );
+  profiler.record( 100, other, 104, 1, 0 );
+  profiler.record( 104, jalr( 0 ), 104, 1, 0 );
+  profiler.record( 104, jalr( 0 ), 4, 1, 0 );
+  profiler.record( 4, other, 8, 1, 0 );
+
+  FunctionProfile f = find_function( profiler, 100 );
+  BOOST_REQUIRE_EQUAL( f.name, "0x64" );
+  BOOST_REQUIRE_EQUAL( f.calls, 2 );
+  BOOST_REQUIRE_EQUAL( f.exclusive_cycles, 4 );
+  BOOST_REQUIRE_EQUAL( f.inclusive_cycles, 4 );
+  std::ostringstream folded;
+  profiler.writeFolded( folded );
+  BOOST_REQUIRE_EQUAL( folded.str(), "0x0 2\n0x0;0x64 2\n0x0;0x64;0x64 2\n" );
+}
+
+// Jumps without a link register and jalr to no return address stay in the
+// current function
+BOOST_AUTO_TEST_CASE( jumps ) {
+  CallGraphProfiler profiler;
+  profiler.record( 0, jal( 0 ), 40, 1, 0 );
+  profiler.record( 40, jalr( 0 ), 80, 1, 0 );
+  BOOST_REQUIRE_EQUAL( profiler.getDepth(), 1 );
+  profiler.record( 80, jal( 1 ), 120, 1, 0 );
+  profiler.record( 120, jalr( 0 ), 0, 1, 0 );
+  BOOST_REQUIRE_EQUAL( profiler.getDepth(), 2 );
+  // An indirect call through jalr
+  profiler.record( 124, jalr( 1 ), 200, 1, 0 );
+  BOOST_REQUIRE_EQUAL( profiler.getDepth(), 3 );
+  // Returning past the innermost frame unwinds both
+  profiler.record( 200, jalr( 0 ), 84, 1, 0 );
+  BOOST_REQUIRE_EQUAL( profiler.getDepth(), 1 );
+}
+
+BOOST_AUTO_TEST_CASE( run_program ) {
+  assembler::turbo_asm engine( get_examples_dir() + "sample9.s" );
+  CallGraphProfiler profiler( engine.getSymbols() );
+  CPU test_cpu( 1024, 512, 8 );
+  test_cpu.runProgram( engine.dumpBinary(), { &profiler } );
+
+  std::vector<FunctionProfile> functions = profiler.getFunctions();
+  BOOST_REQUIRE_EQUAL( functions.size(), 2 );
+  BOOST_REQUIRE_EQUAL( functions[0].address, 0 );
+  BOOST_REQUIRE_EQUAL( functions[0].inclusive_cycles,
+                       test_cpu.getSystemState().instr_stats.cycles );
+  BOOST_REQUIRE_EQUAL( functions[1].name, "subtract" );
+  BOOST_REQUIRE_EQUAL( functions[1].calls, 1 );
+  BOOST_REQUIRE_EQUAL( functions[1].instructions, 2 );
+  BOOST_REQUIRE_EQUAL( profiler.getDepth(), 1 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
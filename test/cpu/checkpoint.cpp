@@ -0,0 +1,123 @@
+#define BOOST_TEST_MODULE checkpoint_test
+
+#include <boost/test/unit_test.hpp>
+#include <cpu/checkpoint.hpp>
+#include <cpu/simulator.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <test_helpers.hpp>
+
+using namespace cpu;
+
+std::string get_checkpoint_file() {
+  return ( std::filesystem::temp_directory_path() / "checkpoint_test.ckp" )
+      .string();
+}
+
+void require_same_state( State& state, State& reference ) {
+  BOOST_REQUIRE_EQUAL( state.PC, reference.PC );
+  BOOST_REQUIRE_EQUAL( state.cache_hits, reference.cache_hits );
+  BOOST_REQUIRE_EQUAL( state.cache_miss, reference.cache_miss );
+  BOOST_REQUIRE( state.instr_stats == reference.instr_stats );
+  for ( auto i = 0; i < 32; i++ ) {
+    BOOST_REQUIRE_EQUAL( state.register_file[i], reference.register_file[i] );
+  }
+  BOOST_REQUIRE( state.memory_manager.getMainMemory().read( 0, 1024 ) ==
+                 reference.memory_manager.getMainMemory().read( 0, 1024 ) );
+}
+
+BOOST_AUTO_TEST_SUITE( checkpoint_test_suite )
+
+// Restoring a checkpoint taken half way ends exactly like a full run, for
+// every replacement policy
+BOOST_AUTO_TEST_CASE( restore_continues_run ) {
+  for ( auto policy : { memory::CacheReplacementPolicy::FIFO,
+                        memory::CacheReplacementPolicy::RANDOM,
+                        memory::CacheReplacementPolicy::LRU } ) {
+    CPU reference_cpu( 1024, 64, 8, memory::CacheWritePolicy::WRITEBACK,
+                       policy );
+    reference_cpu.runProgram( get_program() );
+
+    CPU warm_cpu( 1024, 64, 8, memory::CacheWritePolicy::WRITEBACK, policy );
+    warm_cpu.loadProgram( get_program() );
+    BOOST_REQUIRE_EQUAL( warm_cpu.run( 25 ), 25 );
+    Checkpoint::save( warm_cpu.getSystemState(), get_checkpoint_file() );
+
+    CPU restored_cpu( Checkpoint::load( get_checkpoint_file() ) );
+    BOOST_REQUIRE_EQUAL( restored_cpu.run(), 61 - 25 );
+    BOOST_REQUIRE( restored_cpu.isHalted() );
+    require_same_state( restored_cpu.getSystemState(),
+                        reference_cpu.getSystemState() );
+  }
+  std::filesystem::remove( get_checkpoint_file() );
+}
+
+BOOST_AUTO_TEST_CASE( restore_keeps_configuration ) {
+  TimingConfig timing;
+  timing.set( "cache_miss_penalty", 42 );
+  State state( 4096, 128, 16, memory::CacheWritePolicy::WRITETHROUGH,
+               memory::CacheReplacementPolicy::RANDOM, timing );
+  State restored = Checkpoint::deserialize( Checkpoint::serialize( state ) );
+
+  auto& main_memory = restored.memory_manager.getMainMemoryRef();
+  auto& cache = restored.memory_manager.getCacheMemoryRef();
+  BOOST_REQUIRE_EQUAL( main_memory.getMemorySize(), 4096 );
+  BOOST_REQUIRE_EQUAL( cache.getCacheSize(), 128 );
+  BOOST_REQUIRE_EQUAL( cache.getBlockSize(), 16 );
+  BOOST_REQUIRE_EQUAL( cache.getWritePolicy(),
+                       memory::CacheWritePolicy::WRITETHROUGH );
+  BOOST_REQUIRE_EQUAL( cache.getReplacementPolicy(),
+                       memory::CacheReplacementPolicy::RANDOM );
+  BOOST_REQUIRE_EQUAL( restored.timing.cache_miss_penalty, 42 );
+}
+
+// Zero pages are skipped, so a large idle memory costs almost nothing
+BOOST_AUTO_TEST_CASE( zero_pages_skipped ) {
+  State state( 1 << 20, 64, 8, memory::CacheWritePolicy::WRITEBACK,
+               memory::CacheReplacementPolicy::FIFO );
+  std::string word = "01010101010101010101010101010101";
+  state.memory_manager.getMainMemoryRef().write( 300000, word );
+
+  std::string data = Checkpoint::serialize( state );
+  BOOST_REQUIRE_LT( data.size(), 4096 );
+
+  State restored = Checkpoint::deserialize( data );
+  BOOST_REQUIRE_EQUAL(
+      restored.memory_manager.getMainMemoryRef().getNumWrites(), 1 );
+  BOOST_REQUIRE_EQUAL(
+      restored.memory_manager.getMainMemoryRef().read( 300000, 4 ), word );
+  BOOST_REQUIRE_EQUAL(
+      restored.memory_manager.getMainMemoryRef().read( 0, 4 ),
+      std::string( 32, '0' ) );
+}
+
+BOOST_AUTO_TEST_CASE( invalid_checkpoints ) {
+  State state( 1024, 64, 8, memory::CacheWritePolicy::WRITEBACK,
+               memory::CacheReplacementPolicy::FIFO );
+  state.memory_manager.read( 0, 4 );
+  std::string data = Checkpoint::serialize( state );
+
+  std::string bad_magic = data;
+  bad_magic[0] = 'X';
+  BOOST_REQUIRE_THROW( Checkpoint::deserialize( bad_magic ),
+                       std::runtime_error );
+
+  std::string bad_version = data;
+  bad_version[Checkpoint::magic.size()] = 99;
+  BOOST_REQUIRE_THROW( Checkpoint::deserialize( bad_version ),
+                       std::runtime_error );
+
+  for ( std::size_t size = 0; size < data.size(); size += 7 ) {
+    BOOST_REQUIRE_THROW( Checkpoint::deserialize( data.substr( 0, size ) ),
+                         std::runtime_error );
+  }
+  BOOST_REQUIRE_THROW( Checkpoint::deserialize( data + "x" ),
+                       std::runtime_error );
+  BOOST_REQUIRE_THROW( Checkpoint::load( get_checkpoint_file() + ".missing" ),
+                       std::runtime_error );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
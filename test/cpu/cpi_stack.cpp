@@ -0,0 +1,99 @@
+#define BOOST_TEST_MODULE cpi_stack_test
+
+#include <assembler/assembler.hpp>
+#include <boost/test/unit_test.hpp>
+#include <cpu/cpi_stack.hpp>
+#include <cpu/simulator.hpp>
+#include <cpu/timing_config.hpp>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <test_helpers.hpp>
+
+using namespace cpu;
+
+BOOST_AUTO_TEST_SUITE( cpi_stack_test )
+
+// Every cycle of a run is charged to exactly one cause
+BOOST_AUTO_TEST_CASE( causes_add_up ) {
+  CPU test_cpu( 1024, 512, 8 );
+  test_cpu.runProgram( get_program() );
+
+  State& state = test_cpu.getSystemState();
+  CpiStack stack = state.instr_stats.getCpiStack();
+  std::int64_t hit_time = state.timing.cache_hit_time;
+  std::int64_t miss_time =
+      state.timing.memory_access_latency + state.timing.cache_miss_penalty;
+  BOOST_REQUIRE_EQUAL( stack.instructions, 61 );
+  BOOST_REQUIRE_EQUAL( stack.getCycles(), state.instr_stats.cycles );
+  BOOST_REQUIRE_CLOSE( stack.getCPI(), state.instr_stats.getCPI(), 1e-9 );
+  BOOST_REQUIRE_EQUAL(
+      stack.cycles[FETCH] / hit_time + stack.cycles[FETCH_MISS] / miss_time,
+      61 );
+  BOOST_REQUIRE_EQUAL( ( stack.cycles[FETCH] + stack.cycles[LOAD] ) / hit_time,
+                       state.cache_hits );
+  BOOST_REQUIRE_EQUAL( ( stack.cycles[FETCH_MISS] + stack.cycles[LOAD_MISS] +
+                         stack.cycles[STORE_MISS] ) /
+                           miss_time,
+                       state.cache_miss );
+  BOOST_REQUIRE_EQUAL( stack.cycles[DECODE], 61 * state.timing.decode_time );
+}
+
+BOOST_AUTO_TEST_CASE( execute_causes ) {
+  {
+    std::fstream file( "cpi_stack_sample.s", std::fstream::out );
+    file << "addi r1 r1 1\n"
+            "beq r1 r1 skip\n"
+            "add r2 r2 r2\n"
+            "skip:\n"
+            "bne r1 r1 skip\n";
+  }
+  TimingConfig timing;
+  timing.alu_latency = 1;
+  timing.branch_taken_latency = 7;
+  timing.branch_not_taken_latency = 2;
+  assembler::turbo_asm engine( "cpi_stack_sample.s" );
+  CPU test_cpu( 1024, 512, 8, memory::CacheWritePolicy::WRITEBACK,
+                memory::CacheReplacementPolicy::FIFO, timing );
+  CpiStackProfiler profiler = CpiStackProfiler::fromSymbols(
+      engine.getSymbols(), engine.getLineTable().size() * 4 );
+  test_cpu.runProgram( engine.dumpBinary(), { &profiler } );
+
+  CpiStack stack = test_cpu.getSystemState().instr_stats.getCpiStack();
+  BOOST_REQUIRE_EQUAL( stack.cycles[BASE], 3 );
+  BOOST_REQUIRE_EQUAL( stack.cycles[REDIRECT], 7 );
+  BOOST_REQUIRE_EQUAL( stack.cycles[LOAD], 0 );
+  BOOST_REQUIRE( profiler.getTotal() == stack );
+
+  BOOST_REQUIRE_EQUAL( profiler.getRegions().size(), 2 );
+  BOOST_REQUIRE_EQUAL( profiler.getRegions()[0].name, "[entry]" );
+  BOOST_REQUIRE_EQUAL( profiler.getRegions()[1].name, "skip" );
+  BOOST_REQUIRE_EQUAL( profiler.getStacks()[0].instructions, 2 );
+  BOOST_REQUIRE_EQUAL( profiler.getStacks()[0].cycles[REDIRECT], 7 );
+  BOOST_REQUIRE_EQUAL( profiler.getStacks()[1].instructions, 1 );
+  BOOST_REQUIRE_EQUAL( profiler.getStacks()[1].cycles[BASE], 2 );
+}
+
+BOOST_AUTO_TEST_CASE( regions ) {
+  CpiStackProfiler profiler( { { 20, 30, "b" }, { 0, 10, "a" } } );
+  CycleBreakdown cycles{};
+  cycles[BASE] = 1;
+  profiler.record( 4, cycles );
+  profiler.record( 12, cycles );  // Between the regions
+  profiler.record( 28, cycles );
+  profiler.record( 30, cycles );
+  BOOST_REQUIRE_EQUAL( profiler.getRegions()[0].name, "a" );
+  BOOST_REQUIRE_EQUAL( profiler.getStacks()[0].instructions, 1 );
+  BOOST_REQUIRE_EQUAL( profiler.getStacks()[1].instructions, 1 );
+  BOOST_REQUIRE_EQUAL( profiler.getTotal().instructions, 4 );
+
+  std::ostringstream out;
+  profiler.write( out );
+  BOOST_REQUIRE( out.str().find( "\ntotal " ) != std::string::npos );
+
+  BOOST_REQUIRE_THROW( CpiStackProfiler( { { 0, 10, "a" }, { 8, 20, "b" } } ),
+                       std::invalid_argument );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,102 @@
+#define BOOST_TEST_MODULE decoupled_pipeline_test
+
+#include <boost/test/unit_test.hpp>
+#include <common/spsc_ring.hpp>
+#include <cpu/decoupled_pipeline.hpp>
+#include <cpu/simulator.hpp>
+#include <cstdint>
+#include <string>
+#include <test_helpers.hpp>
+#include <thread>
+
+using namespace cpu;
+
+// Charges through the default timing model and keeps its own totals
+struct CountingConsumer {
+  std::int64_t instructions = 0;
+  std::int64_t cycles = 0;
+  std::int32_t last_pc = -1;
+
+  void retire( State& state, const RetiredInstruction& instr ) {
+    instructions++;
+    cycles += TimingModel::account( state, instr );
+    last_pc = instr.pc;
+  }
+};
+
+BOOST_AUTO_TEST_SUITE( decoupled_pipeline_test_suite )
+
+BOOST_AUTO_TEST_CASE( ring_keeps_order ) {
+  common::SpscRing<std::int64_t> ring( 5 );
+  BOOST_REQUIRE_EQUAL( ring.capacity(), 8 );
+  constexpr std::int64_t count = 100000;
+
+  std::thread producer( [&]() {
+    for ( std::int64_t i = 0; i < count; i++ ) {
+      while ( !ring.tryPush( i ) ) {
+        std::this_thread::yield();
+      }
+    }
+  } );
+  std::int64_t value = 0;
+  for ( std::int64_t expected = 0; expected < count; expected++ ) {
+    while ( !ring.tryPop( value ) ) {
+      std::this_thread::yield();
+    }
+    BOOST_REQUIRE_EQUAL( value, expected );
+  }
+  producer.join();
+  BOOST_REQUIRE( !ring.tryPop( value ) );
+}
+
+// The pipelined run ends in exactly the state of a sequential run
+BOOST_AUTO_TEST_CASE( matches_sequential_run ) {
+  for ( auto program : { "sample9.s", "cpu_sample8.s" } ) {
+    for ( auto policy : { memory::CacheReplacementPolicy::FIFO,
+                          memory::CacheReplacementPolicy::LRU } ) {
+      CPU reference_cpu( 1024, 64, 8, memory::CacheWritePolicy::WRITEBACK,
+                         policy );
+      reference_cpu.runProgram( get_program( program ) );
+      State& reference = reference_cpu.getSystemState();
+
+      CPU test_cpu( 1024, 64, 8, memory::CacheWritePolicy::WRITEBACK,
+                    policy );
+      test_cpu.loadProgram( get_program( program ) );
+      DecoupledPipeline::run( test_cpu, 4 );
+      State& state = test_cpu.getSystemState();
+
+      BOOST_REQUIRE( test_cpu.isHalted() );
+      BOOST_REQUIRE( state.instr_stats == reference.instr_stats );
+      BOOST_REQUIRE_EQUAL( state.cache_hits, reference.cache_hits );
+      BOOST_REQUIRE_EQUAL( state.cache_miss, reference.cache_miss );
+      BOOST_REQUIRE_EQUAL( state.IR, reference.IR );
+      for ( auto i = 0; i < 32; i++ ) {
+        BOOST_REQUIRE_EQUAL( state.register_file[i],
+                             reference.register_file[i] );
+      }
+      BOOST_REQUIRE( state.memory_manager.getMainMemory().read( 0, 1024 ) ==
+                     reference.memory_manager.getMainMemory().read( 0, 1024 ) );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( custom_timing_consumer ) {
+  CPU reference_cpu( 1024, 64, 8 );
+  reference_cpu.runProgram( get_program() );
+  State& reference = reference_cpu.getSystemState();
+
+  CPU test_cpu( 1024, 64, 8 );
+  test_cpu.loadProgram( get_program() );
+  CountingConsumer consumer;
+  DecoupledPipeline::run( test_cpu, consumer );
+  State& state = test_cpu.getSystemState();
+
+  BOOST_REQUIRE_EQUAL( consumer.instructions,
+                       reference.instr_stats.instructions );
+  BOOST_REQUIRE_EQUAL( consumer.cycles, reference.instr_stats.cycles );
+  BOOST_REQUIRE_EQUAL( consumer.last_pc, reference.PC - 4 );
+  BOOST_REQUIRE_EQUAL( state.instr_stats.instructions, 0 );
+  BOOST_REQUIRE_EQUAL( state.cache_miss, reference.cache_miss );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,82 @@
+#define BOOST_TEST_MODULE instruction_stats_test
+
+#include <boost/test/unit_test.hpp>
+#include <cpu/instruction_stats.hpp>
+#include <cpu/simulator.hpp>
+#include <cstdint>
+#include <isa/isa_table.hpp>
+#include <numeric>
+#include <string>
+#include <test_helpers.hpp>
+
+using namespace cpu;
+
+BOOST_AUTO_TEST_SUITE( instruction_stats_test_suite )
+
+BOOST_AUTO_TEST_CASE( latency_buckets ) {
+  BOOST_REQUIRE_EQUAL( InstructionStats::getBucket( 0 ), 0 );
+  BOOST_REQUIRE_EQUAL( InstructionStats::getBucket( 1 ), 1 );
+  BOOST_REQUIRE_EQUAL( InstructionStats::getBucket( 2 ), 2 );
+  BOOST_REQUIRE_EQUAL( InstructionStats::getBucket( 3 ), 2 );
+  BOOST_REQUIRE_EQUAL( InstructionStats::getBucket( 4 ), 3 );
+  BOOST_REQUIRE_EQUAL( InstructionStats::getBucket( INT64_MAX ), 63 );
+}
+
+BOOST_AUTO_TEST_CASE( record_and_history ) {
+  InstructionStats stats;
+  std::int32_t add = isa::IsaTable::indexOf( "add" );
+  std::int32_t lw = isa::IsaTable::indexOf( "lw" );
+  stats.record( 0, add, 2 );
+  BOOST_REQUIRE( stats.getHistory().empty() );
+
+  stats.setHistoryCapacity( 3 );
+  stats.record( 4, lw, 40 );
+  stats.record( 8, add, 3 );
+  stats.record( 12, add, 3 );
+  stats.record( 16, lw, 5'000'000'000 );  // Does not fit 32 bits
+
+  BOOST_REQUIRE_EQUAL( stats.instructions, 5 );
+  BOOST_REQUIRE_EQUAL( stats.cycles, 5'000'000'048 );
+  BOOST_REQUIRE_EQUAL( stats.opcode_counts[add], 3 );
+  BOOST_REQUIRE_EQUAL( stats.opcode_cycles[lw], 5'000'000'040 );
+  BOOST_REQUIRE_EQUAL( stats.latency_histogram[2], 3 );
+  BOOST_REQUIRE_EQUAL( stats.latency_histogram[6], 1 );
+
+  auto history = stats.getHistory();
+  BOOST_REQUIRE_EQUAL( history.size(), 3 );
+  BOOST_REQUIRE_EQUAL( history[0].index, 2 );
+  BOOST_REQUIRE_EQUAL( history[0].pc, 8 );
+  BOOST_REQUIRE_EQUAL( history[2].index, 4 );
+  BOOST_REQUIRE_EQUAL( history[2].cycles, 5'000'000'000 );
+
+  stats.reset();
+  BOOST_REQUIRE_EQUAL( stats.instructions, 0 );
+  BOOST_REQUIRE_EQUAL( stats.getHistoryCapacity(), 3 );
+  BOOST_REQUIRE( stats.getHistory().empty() );
+}
+
+BOOST_AUTO_TEST_CASE( program_stats ) {
+  CPU test_cpu( 1024, 512, 8 );
+  test_cpu.getSystemState().instr_stats.setHistoryCapacity( 8 );
+  test_cpu.runProgram( get_program() );
+
+  InstructionStats& stats = test_cpu.getSystemState().instr_stats;
+  BOOST_REQUIRE_EQUAL( stats.instructions, 61 );
+  BOOST_REQUIRE_EQUAL( std::accumulate( stats.opcode_counts.begin(),
+                                        stats.opcode_counts.end(),
+                                        std::int64_t( 0 ) ),
+                       61 );
+  BOOST_REQUIRE_EQUAL( std::accumulate( stats.opcode_cycles.begin(),
+                                        stats.opcode_cycles.end(),
+                                        std::int64_t( 0 ) ),
+                       stats.cycles );
+  BOOST_REQUIRE_EQUAL( std::accumulate( stats.latency_histogram.begin(),
+                                        stats.latency_histogram.end(),
+                                        std::int64_t( 0 ) ),
+                       61 );
+  auto history = stats.getHistory();
+  BOOST_REQUIRE_EQUAL( history.size(), 8 );
+  BOOST_REQUIRE_EQUAL( history.back().index, 60 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,122 @@
+#define BOOST_TEST_MODULE live_counters_test
+
+#include <unistd.h>
+
+#include <atomic>
+#include <boost/test/unit_test.hpp>
+#include <cpu/live_counters.hpp>
+#include <cpu/simulator.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <test_helpers.hpp>
+#include <thread>
+
+using namespace cpu;
+
+std::string get_counter_file() {
+  return ( std::filesystem::temp_directory_path() /
+           ( "live_counters_test." + std::to_string( ::getpid() ) ) )
+      .string();
+}
+
+BOOST_AUTO_TEST_SUITE( live_counters_test_suite )
+
+BOOST_AUTO_TEST_CASE( run_publishes_counters ) {
+  CPU test_cpu( 1024, 512, 8 );
+  test_cpu.loadProgram( get_program() );
+  {
+    LiveCounterPublisher publisher( get_counter_file(), 10 );
+    LiveCounterReader reader( publisher.getPath() );
+    BOOST_REQUIRE_EQUAL( reader.getPid(), ::getpid() );
+    BOOST_REQUIRE_EQUAL( reader.read().updates, 0 );
+
+    BOOST_REQUIRE_EQUAL( test_cpu.run( { &publisher }, 25 ), 25 );
+    LiveCounters counters = reader.read();
+    BOOST_REQUIRE_EQUAL( counters.updates, 3 );  // At 10, 20 and the end
+    BOOST_REQUIRE_EQUAL( counters.instructions, 25 );
+    BOOST_REQUIRE_EQUAL( counters.finished, 0 );
+
+    test_cpu.run( { &publisher } );
+    counters = reader.read();
+    State& state = test_cpu.getSystemState();
+    BOOST_REQUIRE_EQUAL( counters.instructions, 61 );
+    BOOST_REQUIRE_EQUAL( counters.cycles, state.instr_stats.cycles );
+    BOOST_REQUIRE_EQUAL( counters.cache_hits, 46 );
+    BOOST_REQUIRE_EQUAL( counters.cache_misses, 16 );
+    BOOST_REQUIRE_EQUAL( counters.pc, state.halt_adr );
+    BOOST_REQUIRE_EQUAL( counters.finished, 1 );
+  }
+  // Removed with the publisher
+  BOOST_REQUIRE( !std::filesystem::exists( get_counter_file() ) );
+}
+
+// Every snapshot a reader sees was published as a whole
+BOOST_AUTO_TEST_CASE( concurrent_reads_are_consistent ) {
+  LiveCounterPublisher publisher( get_counter_file() );
+  LiveCounterReader reader( publisher.getPath() );
+  std::atomic<bool> done{ false };
+
+  std::thread writer( [&]() {
+    for ( std::int64_t i = 1; i <= 200000; i++ ) {
+      LiveCounters counters;
+      counters.instructions = i;
+      counters.cycles = 3 * i;
+      counters.cache_hits = i + 7;
+      counters.pc = 4 * i;
+      publisher.publish( counters );
+    }
+    done = true;
+  } );
+
+  std::int64_t last_updates = 0;
+  while ( !done ) {
+    LiveCounters counters = reader.read();
+    BOOST_REQUIRE_EQUAL( counters.instructions, counters.updates );
+    BOOST_REQUIRE_EQUAL( counters.cycles, 3 * counters.instructions );
+    BOOST_REQUIRE_EQUAL( counters.pc, 4 * counters.instructions );
+    if ( counters.updates != 0 ) {
+      BOOST_REQUIRE_EQUAL( counters.cache_hits, counters.instructions + 7 );
+    }
+    BOOST_REQUIRE_GE( counters.updates, last_updates );
+    last_updates = counters.updates;
+  }
+  writer.join();
+  BOOST_REQUIRE_EQUAL( reader.read().updates, 200000 );
+}
+
+BOOST_AUTO_TEST_CASE( invalid_files ) {
+  BOOST_REQUIRE_THROW( LiveCounterPublisher( get_counter_file(), 0 ),
+                       std::invalid_argument );
+  BOOST_REQUIRE_THROW( LiveCounterReader( get_counter_file() + ".missing" ),
+                       std::runtime_error );
+  BOOST_REQUIRE_THROW(
+      LiveCounterReader( get_examples_dir() + "sample9.s" ),
+      std::runtime_error );
+
+  // A file cut short after a valid header is rejected before it is mapped
+  std::string short_file = get_counter_file() + ".short";
+  {
+    std::ofstream file( short_file, std::ios::binary );
+    file.write( LiveCounterSegment::magic.data(),
+                LiveCounterSegment::magic.size() );
+    std::uint32_t version = LiveCounterSegment::version;
+    file.write( reinterpret_cast<const char*>( &version ), sizeof( version ) );
+  }
+  BOOST_REQUIRE_THROW( LiveCounterReader{ short_file }, std::runtime_error );
+  std::filesystem::remove( short_file );
+}
+
+// The file only appears under its name once it is complete
+BOOST_AUTO_TEST_CASE( created_by_rename ) {
+  LiveCounterPublisher publisher( get_counter_file() );
+  BOOST_REQUIRE( !std::filesystem::exists( get_counter_file() + ".tmp" ) );
+  BOOST_REQUIRE_EQUAL( std::filesystem::file_size( get_counter_file() ),
+                       sizeof( LiveCounterSegment ) );
+  LiveCounterReader reader( get_counter_file() );
+  BOOST_REQUIRE_EQUAL( reader.getPid(), ::getpid() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
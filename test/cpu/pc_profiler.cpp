@@ -0,0 +1,75 @@
+#define BOOST_TEST_MODULE pc_profiler_test
+
+#include <assembler/assembler.hpp>
+#include <boost/test/unit_test.hpp>
+#include <common/mapped_file.hpp>
+#include <cpu/pc_profiler.hpp>
+#include <cpu/simulator.hpp>
+#include <sstream>
+#include <string>
+#include <test_helpers.hpp>
+
+using namespace cpu;
+
+BOOST_AUTO_TEST_SUITE( pc_profiler_test )
+
+BOOST_AUTO_TEST_CASE( record ) {
+  PcProfiler profiler( 2 );
+  profiler.record( 4, 10, 1, 0 );
+  profiler.record( 4, 20, 0, 1 );
+  profiler.record( 12, 5, 1, 1 );  // Grows the table
+  BOOST_REQUIRE_EQUAL( profiler.getAllCounters().size(), 4 );
+  BOOST_REQUIRE( profiler.getCounters( 4 ) == ( PcCounters{ 2, 30, 1, 1 } ) );
+  BOOST_REQUIRE( profiler.getCounters( 0 ) == PcCounters() );
+  BOOST_REQUIRE( profiler.getCounters( 400 ) == PcCounters() );
+  BOOST_REQUIRE( profiler.getTotal() == ( PcCounters{ 3, 35, 2, 2 } ) );
+}
+
+// The per PC counters add up to the totals of the state
+BOOST_AUTO_TEST_CASE( run_program ) {
+  assembler::turbo_asm engine( get_examples_dir() + "sample9.s" );
+  assembler::LineTable line_table = engine.getLineTable();
+  CPU test_cpu( 1024, 512, 8 );
+  PcProfiler profiler( line_table.size() );
+  test_cpu.runProgram( engine.dumpBinary(), { &profiler } );
+
+  State& state = test_cpu.getSystemState();
+  PcCounters total = profiler.getTotal();
+  BOOST_REQUIRE_EQUAL( total.instructions, 61 );
+  BOOST_REQUIRE_EQUAL( total.instructions, state.instr_stats.instructions );
+  BOOST_REQUIRE_EQUAL( total.cycles, state.instr_stats.cycles );
+  BOOST_REQUIRE_EQUAL( total.cache_hits, state.cache_hits );
+  BOOST_REQUIRE_EQUAL( total.cache_misses, state.cache_miss );
+  BOOST_REQUIRE_EQUAL( profiler.getAllCounters().size(), line_table.size() );
+  BOOST_REQUIRE_EQUAL( profiler.getCounters( 0 ).instructions, 1 );
+
+  std::vector<PcCounters> lines = profiler.getLineCounters( line_table );
+  BOOST_REQUIRE_EQUAL( lines[1].instructions, 1 );  // lui
+  BOOST_REQUIRE_EQUAL( lines[0].instructions, 0 );
+  // The loop body runs once per iteration
+  BOOST_REQUIRE_EQUAL( lines[24].instructions, 10 );
+}
+
+BOOST_AUTO_TEST_CASE( annotate ) {
+  PcProfiler profiler;
+  profiler.record( 0, 3, 1, 0 );
+  profiler.record( 4, 1, 0, 1 );
+  assembler::LineTable line_table( { 1, 3 } );
+  std::ostringstream out;
+  profiler.annotate( out, "add r1 r2 r3\nloop:\nsub r1 r1 r2\n", line_table );
+
+  std::istringstream lines( out.str() );
+  std::vector<std::string> rows;
+  for ( std::string row; std::getline( lines, row ); ) {
+    rows.push_back( row );
+  }
+  BOOST_REQUIRE_EQUAL( rows.size(), 5 );
+  BOOST_REQUIRE_EQUAL( rows[1], fmt::format( "{:>10} {:>10} {:>6} {:>8} "
+                                             "{:>8} {:>6}  add r1 r2 r3",
+                                             1, 3, "75.00", 1, 0, 1 ) );
+  BOOST_REQUIRE_EQUAL( rows[2], fmt::format( "{:>46} {:>6}  loop:", "", 2 ) );
+  BOOST_REQUIRE( rows[3].ends_with( "     3  sub r1 r1 r2" ) );
+  BOOST_REQUIRE( rows[4].ends_with( "total" ) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,87 @@
+#define BOOST_TEST_MODULE run_observer_test
+
+#include <boost/test/unit_test.hpp>
+#include <cpu/run_observer.hpp>
+#include <cpu/simulator.hpp>
+#include <cpu/time_series.hpp>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <test_helpers.hpp>
+
+using namespace cpu;
+
+// Counts the calls and checks what every instruction reports
+struct CountingObserver : RunObserver {
+  std::int64_t starts = 0;
+  std::int64_t instructions = 0;
+  std::int64_t finishes = 0;
+  std::int64_t cycles = 0;
+  std::int64_t cache_misses = 0;
+  bool halted = false;
+
+  void start( const State& ) override { starts++; }
+
+  void retire( const State& state,
+               const InstructionEvent& instruction ) override {
+    BOOST_REQUIRE_EQUAL( instruction.next_pc, state.PC );
+    BOOST_REQUIRE_EQUAL( instruction.cycles, state.cycles_consumed );
+    std::int64_t cause_cycles = 0;
+    for ( auto cycles : instruction.cycle_causes ) {
+      cause_cycles += cycles;
+    }
+    BOOST_REQUIRE_EQUAL( cause_cycles, instruction.cycles );
+    instructions++;
+    cycles += instruction.cycles;
+    cache_misses += instruction.cache_misses;
+  }
+
+  void finish( const State&, bool run_halted ) override {
+    finishes++;
+    halted = run_halted;
+  }
+};
+
+BOOST_AUTO_TEST_SUITE( run_observer_test_suite )
+
+BOOST_AUTO_TEST_CASE( start_retire_finish ) {
+  CPU test_cpu( 1024, 512, 8 );
+  test_cpu.loadProgram( get_program() );
+  CountingObserver observer;
+  BOOST_REQUIRE_EQUAL( test_cpu.run( { &observer }, 25 ), 25 );
+  BOOST_REQUIRE_EQUAL( observer.starts, 1 );
+  BOOST_REQUIRE_EQUAL( observer.instructions, 25 );
+  BOOST_REQUIRE_EQUAL( observer.finishes, 1 );
+  BOOST_REQUIRE( !observer.halted );
+
+  BOOST_REQUIRE_EQUAL( test_cpu.run( { &observer } ), 61 - 25 );
+  BOOST_REQUIRE_EQUAL( observer.starts, 2 );
+  BOOST_REQUIRE_EQUAL( observer.instructions, 61 );
+  BOOST_REQUIRE( observer.halted );
+
+  State& state = test_cpu.getSystemState();
+  BOOST_REQUIRE_EQUAL( observer.cycles, state.instr_stats.cycles );
+  BOOST_REQUIRE_EQUAL( observer.cache_misses, state.cache_miss );
+}
+
+// Several observers of one run see the same as each of them alone
+BOOST_AUTO_TEST_CASE( combined_observers ) {
+  TimeSeriesConfig config;
+  config.length = 10;
+  std::stringstream combined_output, alone_output;
+  TimeSeriesWriter combined_writer( combined_output );
+  TimeSeriesRecorder combined_recorder( combined_writer, config );
+  CountingObserver counter;
+  CPU test_cpu( 1024, 512, 8 );
+  test_cpu.runProgram( get_program(), { &combined_recorder, &counter } );
+
+  TimeSeriesWriter alone_writer( alone_output );
+  TimeSeriesRecorder alone_recorder( alone_writer, config );
+  CPU( 1024, 512, 8 ).runProgram( get_program(), { &alone_recorder } );
+
+  BOOST_REQUIRE_EQUAL( counter.instructions, 61 );
+  BOOST_REQUIRE_EQUAL( combined_recorder.getNumPoints(), 7 );
+  BOOST_REQUIRE_EQUAL( combined_output.str(), alone_output.str() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
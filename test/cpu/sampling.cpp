@@ -0,0 +1,188 @@
+#define BOOST_TEST_MODULE sampling_test
+
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <cpu/sampling.hpp>
+#include <cpu/simulator.hpp>
+#include <cstdint>
+#include <iterator>
+#include <memory/common_enums.hpp>
+#include <stdexcept>
+#include <string>
+#include <test_helpers.hpp>
+
+using namespace cpu;
+
+// Registers, memory and cache of two CPUs are the same
+void require_same_state( CPU& cpu, CPU& reference_cpu ) {
+  State& state = cpu.getSystemState();
+  State& reference = reference_cpu.getSystemState();
+  BOOST_REQUIRE_EQUAL( state.PC, reference.PC );
+  BOOST_REQUIRE( std::equal( std::begin( state.register_file ),
+                             std::end( state.register_file ),
+                             std::begin( reference.register_file ) ) );
+  const memory::MainMemory& memory = state.memory_manager.getMainMemoryRef();
+  const memory::MainMemory& reference_memory =
+      reference.memory_manager.getMainMemoryRef();
+  for ( auto page = 0; page < memory.getNumPages(); page++ ) {
+    BOOST_REQUIRE( memory.getPageData( page ) ==
+                   reference_memory.getPageData( page ) );
+  }
+  const memory::CacheMemory& cache = state.memory_manager.getCacheMemoryRef();
+  const memory::CacheMemory& reference_cache =
+      reference.memory_manager.getCacheMemoryRef();
+  BOOST_REQUIRE_EQUAL( cache.getBlocks().size(),
+                       reference_cache.getBlocks().size() );
+  auto block = cache.getBlocks().begin();
+  for ( auto& reference_block : reference_cache.getBlocks() ) {
+    BOOST_REQUIRE( block->getEntries() == reference_block.getEntries() );
+    BOOST_REQUIRE_EQUAL( block->isDirty(), reference_block.isDirty() );
+    block++;
+  }
+  BOOST_REQUIRE( cache.getLruOrder() == reference_cache.getLruOrder() );
+}
+
+std::int64_t get_reference_cycles() {
+  CPU reference_cpu( 1024, 512, 8 );
+  reference_cpu.runProgram( get_program() );
+  return reference_cpu.getSystemState().instr_stats.cycles;
+}
+
+BOOST_AUTO_TEST_SUITE( sampling_test_suite )
+
+// Measuring every instruction gives the exact result
+BOOST_AUTO_TEST_CASE( full_measurement_is_exact ) {
+  SamplingConfig config;
+  config.period = 1;
+  config.warmup = 0;
+  config.window = 1;
+
+  CPU test_cpu( 1024, 512, 8 );
+  SamplingResult result = test_cpu.runProgram( get_program(), config );
+  BOOST_REQUIRE( test_cpu.isHalted() );
+  BOOST_REQUIRE_EQUAL( result.instructions, 61 );
+  BOOST_REQUIRE_EQUAL( result.num_samples, 61 );
+  BOOST_REQUIRE_CLOSE( result.cycles, double( get_reference_cycles() ),
+                       1e-9 );
+  BOOST_REQUIRE_EQUAL( test_cpu.getSystemState().instr_stats.instructions, 0 );
+}
+
+BOOST_AUTO_TEST_CASE( sampled_estimate ) {
+  SamplingConfig config;
+  config.period = 10;
+  config.warmup = 2;
+  config.window = 4;
+  config.confidence = 0.95;
+
+  CPU test_cpu( 1024, 512, 8 );
+  SamplingResult result = test_cpu.runProgram( get_program(), config );
+  BOOST_REQUIRE_EQUAL( result.instructions, 61 );
+  BOOST_REQUIRE_EQUAL( result.num_samples, 6 );
+  BOOST_REQUIRE_EQUAL( result.measured_instructions, 24 );
+  BOOST_REQUIRE_GT( result.cpi_error, 0 );
+  BOOST_REQUIRE_CLOSE( result.cycles, result.cpi * 61, 1e-9 );
+  BOOST_REQUIRE_CLOSE( result.cycles_error, result.cpi_error * 61, 1e-9 );
+  // Only the detailed instructions are counted, but the caches were warmed
+  // in between
+  State& state = test_cpu.getSystemState();
+  BOOST_REQUIRE_LT( state.cache_hits + state.cache_miss, 62 );
+  CPU reference_cpu( 1024, 512, 8 );
+  reference_cpu.runProgram( get_program() );
+  require_same_state( test_cpu, reference_cpu );
+}
+
+// Functional warming leaves the same state behind as detailed execution
+BOOST_AUTO_TEST_CASE( functional_warming ) {
+  for ( auto write_policy :
+        { memory::CacheWritePolicy::WRITEBACK,
+          memory::CacheWritePolicy::WRITETHROUGH } ) {
+    for ( auto replacement_policy : { memory::CacheReplacementPolicy::FIFO,
+                                      memory::CacheReplacementPolicy::RANDOM,
+                                      memory::CacheReplacementPolicy::LRU } ) {
+      CPU reference_cpu( 16384, 64, 8, write_policy, replacement_policy );
+      reference_cpu.runProgram( get_program( "loop_sample.s" ) );
+      CPU test_cpu( 16384, 64, 8, write_policy, replacement_policy );
+      test_cpu.loadProgram( get_program( "loop_sample.s" ) );
+      BOOST_REQUIRE_EQUAL( test_cpu.fastForward( 100000 ), 12004 );
+      require_same_state( test_cpu, reference_cpu );
+
+      State& state = test_cpu.getSystemState();
+      BOOST_REQUIRE_EQUAL( state.cache_hits + state.cache_miss, 0 );
+      BOOST_REQUIRE_EQUAL( state.instr_stats.cycles, 0 );
+    }
+  }
+}
+
+// Without warming the cache is left alone
+BOOST_AUTO_TEST_CASE( functional_fast_forward ) {
+  CPU reference_cpu( 16384, 64, 8 );
+  reference_cpu.runProgram( get_program( "loop_sample.s" ) );
+  CPU test_cpu( 16384, 64, 8 );
+  test_cpu.loadProgram( get_program( "loop_sample.s" ) );
+  BOOST_REQUIRE_EQUAL( test_cpu.fastForward( 100000, false ), 12004 );
+  State& state = test_cpu.getSystemState();
+  State& reference = reference_cpu.getSystemState();
+  BOOST_REQUIRE_EQUAL( state.register_file[6], reference.register_file[6] );
+  BOOST_REQUIRE( state.memory_manager.getCacheMemoryRef().getBlocks().empty() );
+}
+
+// Warming skips decoding known instructions and all timing, so it has to
+// take less time than detailed execution of the same instructions
+BOOST_AUTO_TEST_CASE( warming_is_cheaper ) {
+  std::string program = get_program( "loop_sample.s" );
+  auto time = [&]( bool detailed ) {
+    auto best = std::chrono::steady_clock::duration::max();
+    for ( auto i = 0; i < 5; i++ ) {
+      CPU test_cpu( 16384, 64, 8 );
+      test_cpu.loadProgram( program );
+      auto start = std::chrono::steady_clock::now();
+      if ( detailed ) {
+        test_cpu.run();
+      } else {
+        test_cpu.fastForward( 100000 );
+      }
+      best = std::min( best, std::chrono::steady_clock::now() - start );
+      BOOST_REQUIRE( test_cpu.isHalted() );
+    }
+    return best;
+  };
+  BOOST_REQUIRE_LT( time( false ).count(), time( true ).count() );
+}
+
+// A program shorter than one period still gives one sample
+BOOST_AUTO_TEST_CASE( partial_window ) {
+  SamplingConfig config;
+  config.period = 1000;
+  config.warmup = 0;
+  config.window = 1000;
+
+  CPU test_cpu( 1024, 512, 8 );
+  SamplingResult result = test_cpu.runProgram( get_program(), config );
+  BOOST_REQUIRE_EQUAL( result.num_samples, 1 );
+  BOOST_REQUIRE_EQUAL( result.measured_instructions, 61 );
+  BOOST_REQUIRE_EQUAL( result.cpi_error, 0 );
+  BOOST_REQUIRE_CLOSE( result.cycles, double( get_reference_cycles() ),
+                       1e-9 );
+}
+
+BOOST_AUTO_TEST_CASE( invalid_config ) {
+  CPU test_cpu( 1024, 512, 8 );
+  test_cpu.loadProgram( get_program() );
+  SamplingConfig config;
+  config.window = 0;
+  BOOST_REQUIRE_THROW( test_cpu.runSampled( config ), std::invalid_argument );
+  config = SamplingConfig();
+  config.warmup = config.period;
+  BOOST_REQUIRE_THROW( test_cpu.runSampled( config ), std::invalid_argument );
+  config = SamplingConfig();
+  config.confidence = 1;
+  BOOST_REQUIRE_THROW( test_cpu.runSampled( config ), std::invalid_argument );
+}
+
+BOOST_AUTO_TEST_CASE( z_scores ) {
+  BOOST_REQUIRE_CLOSE( SampleAccumulator::zScore( 0.95 ), 1.95996, 1e-3 );
+  BOOST_REQUIRE_CLOSE( SampleAccumulator::zScore( 0.997 ), 2.96774, 1e-3 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
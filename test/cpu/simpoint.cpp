@@ -0,0 +1,123 @@
+#define BOOST_TEST_MODULE simpoint_test
+
+#include <unistd.h>
+
+#include <boost/test/unit_test.hpp>
+#include <cpu/bbv_profiler.hpp>
+#include <cpu/simpoint.hpp>
+#include <cpu/simulator.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <test_helpers.hpp>
+#include <vector>
+
+using namespace cpu;
+
+BOOST_AUTO_TEST_SUITE( simpoint_test_suite )
+
+BOOST_AUTO_TEST_CASE( profile_intervals ) {
+  CPU test_cpu( 1024, 512, 8 );
+  test_cpu.loadProgram( get_program() );
+  BbvProfiler profiler( 10 );
+  profiler.profile( test_cpu );
+
+  BOOST_REQUIRE( test_cpu.isHalted() );
+  auto& intervals = profiler.getIntervals();
+  BOOST_REQUIRE_EQUAL( intervals.size(), 7 );
+  for ( auto i = 0; i < 6; i++ ) {
+    BOOST_REQUIRE_EQUAL( intervals[i].getTotal(), 10 );
+  }
+  BOOST_REQUIRE_EQUAL( intervals[6].getTotal(), 1 );
+  BOOST_REQUIRE_EQUAL( profiler.getBlockAddress( 0 ), 0 );
+  BOOST_REQUIRE_GT( profiler.getNumBlocks(), 1 );
+
+  std::stringstream bbv_file;
+  BbvProfiler::write( bbv_file, intervals );
+  auto read_intervals = BbvProfiler::read( bbv_file );
+  BOOST_REQUIRE_EQUAL( read_intervals.size(), intervals.size() );
+  for ( std::size_t i = 0; i < intervals.size(); i++ ) {
+    BOOST_REQUIRE( read_intervals[i].counts == intervals[i].counts );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( read_invalid ) {
+  std::stringstream bbv_file( "T:1:5 :x:3\n" );
+  BOOST_REQUIRE_THROW( BbvProfiler::read( bbv_file ), std::invalid_argument );
+  std::stringstream zero_id( "T:0:5\n" );
+  BOOST_REQUIRE_THROW( BbvProfiler::read( zero_id ), std::invalid_argument );
+}
+
+// Two alternating phases that use different blocks give one point each
+BOOST_AUTO_TEST_CASE( select_phases ) {
+  std::vector<BasicBlockVector> intervals;
+  for ( auto i = 0; i < 20; i++ ) {
+    if ( i % 4 < 2 ) {
+      intervals.push_back( { { { 0, 60 + i }, { 1, 40 - i } } } );
+    } else {
+      intervals.push_back( { { { 2, 30 + i }, { 3, 70 - i } } } );
+    }
+  }
+  auto points = SimPoint::select( intervals, 4 );
+  BOOST_REQUIRE_EQUAL( points.size(), 2 );
+  BOOST_REQUIRE_CLOSE( points[0].weight, 0.5, 1e-9 );
+  BOOST_REQUIRE_CLOSE( points[1].weight, 0.5, 1e-9 );
+  BOOST_REQUIRE_NE( points[0].interval % 4 < 2, points[1].interval % 4 < 2 );
+
+  // A single phase needs a single point
+  std::vector<BasicBlockVector> uniform( 10, { { { 0, 50 }, { 1, 50 } } } );
+  points = SimPoint::select( uniform, 2 );
+  BOOST_REQUIRE_EQUAL( points.size(), 1 );
+  BOOST_REQUIRE_CLOSE( points[0].weight, 1.0, 1e-9 );
+}
+
+// Every interval weighted by its length reproduces the full run
+BOOST_AUTO_TEST_CASE( estimate_all_intervals ) {
+  CPU reference_cpu( 1024, 512, 8 );
+  reference_cpu.runProgram( get_program() );
+  State& reference = reference_cpu.getSystemState();
+  std::int64_t reference_cycles = reference.instr_stats.cycles;
+
+  std::vector<SimulationPoint> points;
+  for ( auto i = 0; i < 7; i++ ) {
+    points.push_back( { i, ( i < 6 ? 10 : 1 ) / 61.0 } );
+  }
+  CPU test_cpu( 1024, 512, 8 );
+  test_cpu.loadProgram( get_program() );
+  SimPointEstimate estimate = SimPoint::estimate( test_cpu, points, 10, 61 );
+  BOOST_REQUIRE_EQUAL( estimate.instructions, 61 );
+  BOOST_REQUIRE_CLOSE( estimate.cycles, double( reference_cycles ), 1e-9 );
+  BOOST_REQUIRE_GT( estimate.miss_rate, 0 );
+  BOOST_REQUIRE_LT( estimate.miss_rate, 1 );
+}
+
+// Restoring the points from checkpoints gives the same estimate
+BOOST_AUTO_TEST_CASE( estimate_from_checkpoints ) {
+  std::vector<SimulationPoint> points{ { 1, 0.5 }, { 4, 0.3 }, { 6, 0.2 } };
+  CPU test_cpu( 1024, 512, 8 );
+  test_cpu.loadProgram( get_program() );
+  SimPointEstimate expected = SimPoint::estimate( test_cpu, points, 10, 61 );
+
+  std::filesystem::path checkpoint_dir =
+      std::filesystem::temp_directory_path() /
+      ( "simpoint_test." + std::to_string( ::getpid() ) );
+  std::filesystem::create_directory( checkpoint_dir );
+  SimPoint::writeCheckpoints( test_cpu, points, 10, checkpoint_dir.string() );
+  for ( auto& point : points ) {
+    BOOST_REQUIRE( std::filesystem::exists( SimPoint::getCheckpointName(
+        checkpoint_dir.string(), point.interval ) ) );
+  }
+  SimPointEstimate estimate = SimPoint::estimateFromCheckpoints(
+      points, 10, 61, checkpoint_dir.string() );
+  std::filesystem::remove_all( checkpoint_dir );
+
+  BOOST_REQUIRE_EQUAL( estimate.instructions, 61 );
+  BOOST_REQUIRE_CLOSE( estimate.cpi, expected.cpi, 1e-9 );
+  BOOST_REQUIRE_CLOSE( estimate.cycles, expected.cycles, 1e-9 );
+  BOOST_REQUIRE_CLOSE( estimate.miss_rate, expected.miss_rate, 1e-9 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,65 @@
+#define BOOST_TEST_MODULE state_test
+
+#include <boost/test/unit_test.hpp>
+#include <cpu/simulator.hpp>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <test_helpers.hpp>
+
+using namespace cpu;
+
+BOOST_AUTO_TEST_SUITE( state_test_suite )
+
+// A run that is forked half way ends exactly like an uninterrupted run
+BOOST_AUTO_TEST_CASE( fork_continues_run ) {
+  CPU reference_cpu( 1024, 512, 8 );
+  reference_cpu.runProgram( get_program() );
+  State& reference = reference_cpu.getSystemState();
+
+  CPU warm_cpu( 1024, 512, 8 );
+  warm_cpu.loadProgram( get_program() );
+  BOOST_REQUIRE_EQUAL( warm_cpu.run( 20 ), 20 );
+
+  CPU forked_cpu = warm_cpu.fork();
+  forked_cpu.run();
+  State& forked = forked_cpu.getSystemState();
+
+  BOOST_REQUIRE( forked_cpu.isHalted() );
+  BOOST_REQUIRE( !warm_cpu.isHalted() );
+  BOOST_REQUIRE_EQUAL( warm_cpu.getSystemState().instr_stats.instructions,
+                       20 );
+  BOOST_REQUIRE( forked.instr_stats == reference.instr_stats );
+  BOOST_REQUIRE_EQUAL( forked.cache_hits, reference.cache_hits );
+  BOOST_REQUIRE_EQUAL( forked.cache_miss, reference.cache_miss );
+  for ( auto i = 0; i < 32; i++ ) {
+    BOOST_REQUIRE_EQUAL( forked.register_file[i], reference.register_file[i] );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( forks_are_independent ) {
+  State state( 1024, 64, 8, memory::CacheWritePolicy::WRITETHROUGH,
+               memory::CacheReplacementPolicy::LRU );
+  std::string ones( 32, '1' );
+  std::string zeros( 32, '0' );
+  state.register_file[1] = 5;
+  state.memory_manager.read( 512, 4 );  // Bring the block into the cache
+
+  State forked = state.fork();
+  forked.register_file[1] = 7;
+  forked.memory_manager.write( 512, ones );
+
+  BOOST_REQUIRE_EQUAL( state.register_file[1], 5 );
+  BOOST_REQUIRE_EQUAL( state.memory_manager.read( 512, 4 ), zeros );
+  BOOST_REQUIRE_EQUAL( forked.memory_manager.read( 512, 4 ), ones );
+  BOOST_REQUIRE_EQUAL(
+      forked.memory_manager.getMainMemory().read( 512, 4 ), ones );
+  BOOST_REQUIRE_EQUAL( state.memory_manager.getMainMemory().read( 512, 4 ),
+                       zeros );
+
+  // Counters are charged to the state that did the access
+  BOOST_REQUIRE_EQUAL( state.cache_hits, 1 );
+  BOOST_REQUIRE_EQUAL( forked.cache_hits, 1 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
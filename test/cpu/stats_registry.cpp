@@ -0,0 +1,123 @@
+#define BOOST_TEST_MODULE stats_registry_test
+
+#include <boost/test/unit_test.hpp>
+#include <common/stats_registry.hpp>
+#include <cpu/simulator.hpp>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <test_helpers.hpp>
+#include <vector>
+
+using namespace cpu;
+using common::StatsRegistry;
+
+BOOST_AUTO_TEST_SUITE( stats_registry_test_suite )
+
+BOOST_AUTO_TEST_CASE( json_nesting ) {
+  std::int64_t misses = 3;
+  std::int32_t size = 64;
+  std::int64_t instructions = 10;
+  StatsRegistry stats;
+  stats.addCounter( "l1d.misses", misses );
+  stats.addCounter( "cpu.instructions", instructions );
+  stats.addCounter( "l1d.size", size );
+  stats.addFormula( "l1d.mpki",
+                    [&]() { return misses * 1000.0 / instructions; } );
+
+  std::ostringstream output;
+  stats.writeJSON( output, 0 );
+  BOOST_REQUIRE_EQUAL( output.str(),
+                       "{\"cpu\":{\"instructions\":10},"
+                       "\"l1d\":{\"misses\":3,\"mpki\":300,\"size\":64}}\n" );
+
+  std::ostringstream indented;
+  stats.writeJSON( indented );
+  BOOST_REQUIRE_EQUAL( indented.str(),
+                       "{\n"
+                       "  \"cpu\": {\n"
+                       "    \"instructions\": 10\n"
+                       "  },\n"
+                       "  \"l1d\": {\n"
+                       "    \"misses\": 3,\n"
+                       "    \"mpki\": 300,\n"
+                       "    \"size\": 64\n"
+                       "  }\n"
+                       "}\n" );
+}
+
+BOOST_AUTO_TEST_CASE( csv_and_live_values ) {
+  std::int64_t hits = 0;
+  std::int64_t zero = 0;
+  StatsRegistry stats;
+  stats.addCounter( "hits", hits, "Cache hits, all levels" );
+  stats.addFormula( "rate", [&]() { return hits / double( zero ); } );
+
+  hits = 7;  // Read when dumped, not when registered
+  BOOST_REQUIRE_EQUAL( stats.getValue( "hits" ), 7 );
+
+  std::ostringstream output;
+  stats.write( output, StatsRegistry::Format::CSV );
+  BOOST_REQUIRE_EQUAL( output.str(),
+                       "name,value,description\n"
+                       "hits,7,\"Cache hits, all levels\"\n"
+                       "rate,null,\n" );
+}
+
+BOOST_AUTO_TEST_CASE( invalid_names ) {
+  std::int64_t counter = 0;
+  StatsRegistry stats;
+  stats.addCounter( "cpu.cycles", counter );
+  BOOST_REQUIRE_THROW( stats.addCounter( "cpu.Cycles", counter ),
+                       std::invalid_argument );
+  BOOST_REQUIRE_THROW( stats.addCounter( "cpu..cycles", counter ),
+                       std::invalid_argument );
+  BOOST_REQUIRE_THROW( stats.addCounter( "", counter ),
+                       std::invalid_argument );
+  // Duplicates, and statistics that would also be groups
+  BOOST_REQUIRE_THROW( stats.addCounter( "cpu.cycles", counter ),
+                       std::invalid_argument );
+  BOOST_REQUIRE_THROW( stats.addCounter( "cpu.cycles.total", counter ),
+                       std::invalid_argument );
+  BOOST_REQUIRE_THROW( stats.addCounter( "cpu", counter ),
+                       std::invalid_argument );
+  BOOST_REQUIRE_THROW( stats.getValue( "cpu.cpi" ), std::out_of_range );
+  BOOST_REQUIRE_EQUAL( stats.size(), 1 );
+}
+
+BOOST_AUTO_TEST_CASE( cpu_statistics ) {
+  CPU cpu( 1024, 512, 8, memory::CacheWritePolicy::WRITEBACK,
+           memory::CacheReplacementPolicy::FIFO );
+  cpu.runProgram( get_program() );
+  State& state = cpu.getSystemState();
+
+  StatsRegistry stats = state.getStats();
+  BOOST_REQUIRE_EQUAL( stats.getValue( "cpu.instructions" ), 61 );
+  BOOST_REQUIRE_EQUAL( stats.getValue( "cpu.cycles" ), 1060 );
+  BOOST_REQUIRE_CLOSE( stats.getValue( "cpu.cpi" ), 1060 / 61.0, 1e-9 );
+  BOOST_REQUIRE_EQUAL( stats.getValue( "cache.hits" ), 46 );
+  BOOST_REQUIRE_EQUAL( stats.getValue( "cache.misses" ), 16 );
+  BOOST_REQUIRE_EQUAL( stats.getValue( "cache.size" ), 512 );
+  BOOST_REQUIRE_EQUAL( stats.getValue( "timing.cache_hit_time" ), 10 );
+
+  const memory::CacheMemory& cache = state.memory_manager.getCacheMemoryRef();
+  BOOST_REQUIRE_EQUAL( stats.getValue( "cache.evictions" ),
+                       cache.getNumEvictions() );
+  BOOST_REQUIRE_LE( cache.getNumWritebacks(), cache.getNumEvictions() );
+  BOOST_REQUIRE_GT( stats.getValue( "mem.reads" ), 0 );
+
+  double opcode_cycles = 0;
+  for ( auto& name : stats.getNames() ) {
+    if ( name.starts_with( "cpu.opcode." ) && name.ends_with( ".cycles" ) ) {
+      opcode_cycles += stats.getValue( name );
+    }
+  }
+  BOOST_REQUIRE_EQUAL( opcode_cycles, 1060 );
+
+  // The registry reads the live counters
+  cpu.getSystemState().timing.cache_hit_time = 3;
+  BOOST_REQUIRE_EQUAL( stats.getValue( "timing.cache_hit_time" ), 3 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,70 @@
+#define BOOST_TEST_MODULE time_parallel_test
+
+#include <boost/test/unit_test.hpp>
+#include <cpu/simulator.hpp>
+#include <cpu/time_parallel.hpp>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <test_helpers.hpp>
+
+using namespace cpu;
+
+BOOST_AUTO_TEST_SUITE( time_parallel_test_suite )
+
+// With a warm-up covering everything before each interval the stitched
+// result is exactly the sequential one
+BOOST_AUTO_TEST_CASE( full_warmup_is_exact ) {
+  CPU reference_cpu( 1024, 64, 8 );
+  reference_cpu.runProgram( get_program() );
+  State& reference = reference_cpu.getSystemState();
+  std::int64_t reference_cycles = reference.instr_stats.cycles;
+
+  CPU test_cpu( 1024, 64, 8 );
+  test_cpu.loadProgram( get_program() );
+  TimeParallelConfig config;
+  config.num_intervals = 4;
+  config.num_threads = 4;
+  config.warmup = 1000;
+  TimeParallelResult result = TimeParallelRunner::run( test_cpu, config );
+
+  BOOST_REQUIRE_EQUAL( result.intervals.size(), 4 );
+  BOOST_REQUIRE_EQUAL( result.instructions, 61 );
+  BOOST_REQUIRE_EQUAL( result.cycles, reference_cycles );
+  BOOST_REQUIRE_EQUAL( result.cache_hits, reference.cache_hits );
+  BOOST_REQUIRE_EQUAL( result.cache_misses, reference.cache_miss );
+  std::int64_t position = 0;
+  for ( auto& interval : result.intervals ) {
+    BOOST_REQUIRE_EQUAL( interval.start, position );
+    position += interval.instructions;
+  }
+  BOOST_REQUIRE( !test_cpu.isHalted() );  // The input CPU is not run
+}
+
+// Without warm-up later intervals start with cold caches, which can only
+// cost misses, never instructions
+BOOST_AUTO_TEST_CASE( cold_intervals ) {
+  CPU test_cpu( 1024, 64, 8 );
+  test_cpu.loadProgram( get_program() );
+  TimeParallelConfig config;
+  config.num_intervals = 6;
+  config.num_threads = 3;
+  config.warmup = 0;
+  TimeParallelResult result = TimeParallelRunner::run( test_cpu, config );
+
+  BOOST_REQUIRE_EQUAL( result.intervals.size(), 6 );
+  BOOST_REQUIRE_EQUAL( result.instructions, 61 );
+  BOOST_REQUIRE_EQUAL( result.cache_hits + result.cache_misses, 62 );
+  BOOST_REQUIRE_GT( result.getCPI(), 0 );
+
+  config.num_intervals = 1000;  // More intervals than instructions
+  result = TimeParallelRunner::run( test_cpu, config );
+  BOOST_REQUIRE_EQUAL( result.intervals.size(), 61 );
+  BOOST_REQUIRE_EQUAL( result.instructions, 61 );
+
+  config.warmup = -1;
+  BOOST_REQUIRE_THROW( TimeParallelRunner::run( test_cpu, config ),
+                       std::invalid_argument );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
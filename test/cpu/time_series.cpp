@@ -0,0 +1,104 @@
+#define BOOST_TEST_MODULE time_series_test
+
+#include <boost/test/unit_test.hpp>
+#include <cpu/simulator.hpp>
+#include <cpu/time_series.hpp>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <test_helpers.hpp>
+#include <vector>
+
+using namespace cpu;
+
+std::vector<TimeSeriesPoint> record( const TimeSeriesConfig& config,
+                                     CPU& test_cpu ) {
+  std::stringstream stream;
+  TimeSeriesWriter writer( stream, TimeSeriesWriter::Format::BINARY );
+  TimeSeriesRecorder recorder( writer, config );
+  test_cpu.runProgram( get_program(), { &recorder } );
+  std::vector<TimeSeriesPoint> points = TimeSeriesWriter::readBinary( stream );
+  BOOST_REQUIRE_EQUAL( points.size(), recorder.getNumPoints() );
+  return points;
+}
+
+BOOST_AUTO_TEST_SUITE( time_series_test_suite )
+
+// Intervals add up to the whole run and the last one may be partial
+BOOST_AUTO_TEST_CASE( instruction_intervals ) {
+  TimeSeriesConfig config;
+  config.length = 10;
+  CPU test_cpu( 1024, 512, 8 );
+  std::vector<TimeSeriesPoint> points = record( config, test_cpu );
+
+  BOOST_REQUIRE_EQUAL( points.size(), 7 );
+  std::int64_t cycles = 0, hits = 0, misses = 0;
+  for ( std::size_t i = 0; i < points.size(); i++ ) {
+    BOOST_REQUIRE_EQUAL( points[i].interval, i );
+    BOOST_REQUIRE_EQUAL( points[i].instructions, i < 6 ? 10 : 1 );
+    cycles += points[i].cycles;
+    hits += points[i].cache_hits;
+    misses += points[i].cache_misses;
+    BOOST_REQUIRE_EQUAL( points[i].cycle, cycles );
+  }
+  BOOST_REQUIRE_EQUAL( points.back().instruction, 61 );
+  BOOST_REQUIRE_EQUAL( cycles, 1060 );
+  BOOST_REQUIRE_EQUAL( hits, 46 );
+  BOOST_REQUIRE_EQUAL( misses, 16 );
+  BOOST_REQUIRE_GT( points[0].mem_reads, 0 );  // Cold misses fill blocks
+}
+
+// A point is written once per interval even if an instruction spans
+// several boundaries
+BOOST_AUTO_TEST_CASE( cycle_intervals ) {
+  TimeSeriesConfig config;
+  config.unit = TimeSeriesConfig::CYCLES;
+  config.length = 15;
+  CPU test_cpu( 1024, 512, 8 );
+  std::vector<TimeSeriesPoint> points = record( config, test_cpu );
+
+  BOOST_REQUIRE_GT( points.size(), 1 );
+  std::int64_t instructions = 0;
+  for ( std::size_t i = 0; i + 1 < points.size(); i++ ) {
+    // Ends in a later interval than it starts
+    std::int64_t start = points[i].cycle - points[i].cycles;
+    BOOST_REQUIRE_GT( points[i].cycle / 15, start / 15 );
+    instructions += points[i].instructions;
+  }
+  BOOST_REQUIRE_EQUAL( instructions + points.back().instructions, 61 );
+  BOOST_REQUIRE_EQUAL( points.back().cycle, 1060 );
+}
+
+BOOST_AUTO_TEST_CASE( csv_output ) {
+  TimeSeriesConfig config;
+  config.length = 100;
+  std::ostringstream output;
+  TimeSeriesWriter writer( output );
+  TimeSeriesRecorder recorder( writer, config );
+  CPU test_cpu( 1024, 512, 8 );
+  test_cpu.runProgram( get_program(), { &recorder } );
+
+  std::istringstream lines( output.str() );
+  std::string header, row, end;
+  std::getline( lines, header );
+  std::getline( lines, row );
+  BOOST_REQUIRE( !std::getline( lines, end ) );
+  BOOST_REQUIRE( header.starts_with( "interval,instruction,cycle," ) );
+  BOOST_REQUIRE( row.starts_with( "0,61,1060,61,1060,0.0575,46,16,0.7419," ) );
+}
+
+BOOST_AUTO_TEST_CASE( invalid_input ) {
+  std::ostringstream output;
+  TimeSeriesWriter writer( output );
+  TimeSeriesConfig config;
+  config.length = 0;
+  BOOST_REQUIRE_THROW( TimeSeriesRecorder( writer, config ),
+                       std::invalid_argument );
+
+  std::istringstream not_binary( "interval,instruction\n" );
+  BOOST_REQUIRE_THROW( TimeSeriesWriter::readBinary( not_binary ),
+                       std::runtime_error );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,80 @@
+#define BOOST_TEST_MODULE timing_config_test
+
+#include <boost/test/unit_test.hpp>
+#include <cpu/simulator.hpp>
+#include <cpu/timing_config.hpp>
+#include <fstream>
+#include <stdexcept>
+
+using namespace cpu;
+
+BOOST_AUTO_TEST_SUITE( timing_config_test_suite )
+
+BOOST_AUTO_TEST_CASE( load_from_file ) {
+  {
+    std::fstream file( "timing_config.cfg", std::fstream::out );
+    file << "# Slow memory\n"
+         << "memory_access_latency = 100\n"
+         << "\n"
+         << "  alu_latency=3   # comment\n"
+         << "branch_taken_latency = 4\n";
+  }
+  TimingConfig config = TimingConfig::fromFile( "timing_config.cfg" );
+
+  BOOST_REQUIRE_EQUAL( config.memory_access_latency, 100 );
+  BOOST_REQUIRE_EQUAL( config.alu_latency, 3 );
+  BOOST_REQUIRE_EQUAL( config.get( "branch_taken_latency" ), 4 );
+  // Not given, keeps the default
+  BOOST_REQUIRE_EQUAL( config.cache_hit_time, 10 );
+}
+
+BOOST_AUTO_TEST_CASE( invalid_config ) {
+  TimingConfig config;
+  BOOST_REQUIRE_THROW( config.set( "fpu_latency", 1 ), std::invalid_argument );
+  BOOST_REQUIRE_THROW( config.set( "alu_latency", -1 ), std::invalid_argument );
+  {
+    std::fstream file( "timing_invalid.cfg", std::fstream::out );
+    file << "alu_latency = fast\n";
+  }
+  BOOST_REQUIRE_THROW( TimingConfig::fromFile( "timing_invalid.cfg" ),
+                       std::invalid_argument );
+  BOOST_REQUIRE_THROW( TimingConfig::fromFile( "missing.cfg" ),
+                       std::runtime_error );
+}
+
+BOOST_AUTO_TEST_CASE( alu_latency ) {
+  TimingConfig config;
+  config.decode_time = 3;
+  config.alu_latency = 5;
+  CPU test_cpu( 512, 64, 8, memory::CacheWritePolicy::WRITEBACK,
+                memory::CacheReplacementPolicy::FIFO, config );
+
+  // add r1 r2 r3, fetch misses the cache
+  test_cpu.runProgram( "00000000001100010000000010110011" );
+
+  BOOST_REQUIRE_EQUAL( test_cpu.getSystemState().instr_stats.cycles,
+                       10 + 20 + 3 + 5 );
+}
+
+BOOST_AUTO_TEST_CASE( branch_latency ) {
+  TimingConfig config;
+  config.branch_taken_latency = 7;
+  config.branch_not_taken_latency = 2;
+  // beq r1 r2 4
+  std::string program = "00000000001000001000001001100011";
+
+  CPU taken_cpu( 512, 64, 8, memory::CacheWritePolicy::WRITEBACK,
+                 memory::CacheReplacementPolicy::FIFO, config );
+  taken_cpu.runProgram( program );
+  BOOST_REQUIRE_EQUAL( taken_cpu.getSystemState().instr_stats.cycles,
+                       30 + 1 + 7 );
+
+  CPU not_taken_cpu( 512, 64, 8, memory::CacheWritePolicy::WRITEBACK,
+                     memory::CacheReplacementPolicy::FIFO, config );
+  not_taken_cpu.getSystemState().register_file[1] = 1;
+  not_taken_cpu.runProgram( program );
+  BOOST_REQUIRE_EQUAL( not_taken_cpu.getSystemState().instr_stats.cycles,
+                       30 + 1 + 2 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
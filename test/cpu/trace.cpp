@@ -0,0 +1,129 @@
+#define BOOST_TEST_MODULE trace_test
+
+#include <unistd.h>
+
+#include <boost/test/unit_test.hpp>
+#include <cpu/simulator.hpp>
+#include <cpu/trace.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <isa/encoding.hpp>
+#include <stdexcept>
+#include <string>
+#include <test_helpers.hpp>
+#include <vector>
+
+using namespace cpu;
+
+std::string get_trace_file() {
+  return ( std::filesystem::temp_directory_path() /
+           ( "trace_test." + std::to_string( ::getpid() ) ) )
+      .string();
+}
+
+std::vector<TraceRecord> read_trace( const std::string& filename ) {
+  TraceReader reader( filename );
+  std::vector<TraceRecord> records;
+  TraceRecord record;
+  while ( reader.next( record ) ) {
+    records.push_back( record );
+  }
+  return records;
+}
+
+BOOST_AUTO_TEST_SUITE( trace_test_suite )
+
+BOOST_AUTO_TEST_CASE( program_trace ) {
+  std::string program = get_program();
+
+  CPU test_cpu( 1024, 512, 8 );
+  {
+    TraceRecorder tracer( get_trace_file() );
+    test_cpu.runProgram( program, { &tracer } );
+    tracer.close();
+    BOOST_REQUIRE_EQUAL( tracer.getNumRecords(), 61 );
+  }
+  // Tracing does not change the simulation
+  BOOST_REQUIRE_EQUAL( test_cpu.getSystemState().instr_stats.cycles, 1060 );
+
+  // Same records as stepping by hand
+  CPU reference_cpu( 1024, 512, 8 );
+  reference_cpu.loadProgram( program );
+  std::vector<TraceRecord> expected;
+  while ( !reference_cpu.isHalted() ) {
+    reference_cpu.step( true, &expected.emplace_back() );
+  }
+  std::vector<TraceRecord> records = read_trace( get_trace_file() );
+  BOOST_REQUIRE( records == expected );
+
+  std::int64_t misses = 0, memory_accesses = 0;
+  for ( auto& record : records ) {
+    misses += !record.fetch_hit + ( record.has_address && !record.data_hit );
+    memory_accesses += record.has_address;
+  }
+  BOOST_REQUIRE_EQUAL( misses, 16 );
+  BOOST_REQUIRE_GT( memory_accesses, 0 );
+  BOOST_REQUIRE_EQUAL( records[0].pc, 0 );
+  BOOST_REQUIRE_EQUAL( records[0].word,
+                       isa::Encoding::toWord( program.substr( 0, 32 ) ) );
+  std::filesystem::remove( get_trace_file() );
+}
+
+// A long loop spans several chunks and compresses to about a byte per
+// instruction
+BOOST_AUTO_TEST_CASE( loop_round_trip ) {
+  std::vector<TraceRecord> records;
+  for ( std::int32_t i = 0; i < 100000; i++ ) {
+    for ( std::int32_t j = 0; j < 5; j++ ) {
+      TraceRecord record;
+      record.pc = 0x100 + 4 * j;
+      record.word = 0x00a50533u + j;
+      record.fetch_hit = true;
+      if ( j == 1 ) {
+        record.has_address = true;
+        record.address = 0x4000 + 4 * i;  // Constant stride
+        record.data_hit = i % 2 == 0;
+      } else if ( j == 3 ) {
+        record.has_address = true;
+        record.is_store = true;
+        record.address = ( i * 7919 ) % 65536 - 1000;  // Irregular
+      }
+      records.push_back( record );
+    }
+  }
+  records.push_back( TraceRecord{ -8, 0xffffffffu } );  // Backwards jump
+
+  {
+    TraceRecorder tracer( get_trace_file(), 2 );
+    for ( auto& record : records ) {
+      tracer.record( record );
+    }
+  }
+  BOOST_REQUIRE( read_trace( get_trace_file() ) == records );
+  BOOST_REQUIRE_LT( std::filesystem::file_size( get_trace_file() ),
+                    records.size() * 2 );
+  std::filesystem::remove( get_trace_file() );
+}
+
+BOOST_AUTO_TEST_CASE( invalid_traces ) {
+  BOOST_REQUIRE_THROW( TraceReader( get_examples_dir() + "sample9.s" ),
+                       std::runtime_error );
+
+  {
+    TraceRecorder tracer( get_trace_file() );
+    for ( std::int32_t i = 0; i < 100; i++ ) {
+      tracer.record( TraceRecord{ 4 * i, std::uint32_t( i ) } );
+    }
+  }
+  std::filesystem::resize_file( get_trace_file(),
+                                std::filesystem::file_size( get_trace_file() ) -
+                                    10 );
+  BOOST_REQUIRE_THROW( read_trace( get_trace_file() ), std::runtime_error );
+  std::filesystem::remove( get_trace_file() );
+
+  BOOST_REQUIRE_THROW( TraceRecorder( "/nonexistent/dir/trace" ),
+                       std::runtime_error );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
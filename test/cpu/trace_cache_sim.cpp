@@ -0,0 +1,142 @@
+#define BOOST_TEST_MODULE trace_cache_sim_test
+
+#include <unistd.h>
+
+#include <boost/test/unit_test.hpp>
+#include <cpu/simulator.hpp>
+#include <cpu/trace_cache_sim.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <test_helpers.hpp>
+#include <vector>
+
+using namespace cpu;
+
+std::string get_trace_file() {
+  return ( std::filesystem::temp_directory_path() /
+           ( "trace_cache_sim_test." + std::to_string( ::getpid() ) ) )
+      .string();
+}
+
+std::vector<MemoryReference> read_din( std::string_view text ) {
+  DinReader reader( text );
+  std::vector<MemoryReference> references;
+  MemoryReference reference;
+  while ( reader.next( reference ) ) {
+    references.push_back( reference );
+  }
+  return references;
+}
+
+std::vector<TraceCacheConfig> get_configs() {
+  std::vector<TraceCacheConfig> configs;
+  for ( auto cache_size : { 64, 128, 256 } ) {
+    for ( auto policy : { memory::FIFO, memory::RANDOM, memory::LRU } ) {
+      TraceCacheConfig config;
+      config.cache_size = cache_size;
+      config.block_size = 16;
+      config.replacement_policy = policy;
+      configs.push_back( config );
+    }
+  }
+  return configs;
+}
+
+BOOST_AUTO_TEST_SUITE( trace_cache_sim_test_suite )
+
+BOOST_AUTO_TEST_CASE( din_parsing ) {
+  std::vector<MemoryReference> references =
+      read_din( "0 1000\n"
+                "1 0x1A04 4\r\n"
+                "\n"
+                "  2\tffffFFFF\n"
+                "3 0\n"
+                "4 0\n"
+                "0 20" );
+  BOOST_REQUIRE_EQUAL( references.size(), 5 );
+  BOOST_REQUIRE_EQUAL( references[0].address, 0x1000 );
+  BOOST_REQUIRE_EQUAL( references[0].type, memory::READ );
+  BOOST_REQUIRE_EQUAL( references[1].address, 0x1a04 );
+  BOOST_REQUIRE_EQUAL( references[1].type, memory::WRITE );
+  BOOST_REQUIRE_EQUAL( references[2].address, 0xffffffff );
+  BOOST_REQUIRE_EQUAL( references[2].type, memory::FETCH );
+  BOOST_REQUIRE( references[3].flush );
+  BOOST_REQUIRE( !references[4].flush );
+  BOOST_REQUIRE_EQUAL( references[4].address, 0x20 );
+
+  BOOST_REQUIRE_THROW( read_din( "0 1000\n5 1000\n" ), std::runtime_error );
+  BOOST_REQUIRE_THROW( read_din( "0 10g0\n" ), std::runtime_error );
+  BOOST_REQUIRE_THROW( read_din( "0\n" ), std::runtime_error );
+}
+
+// Configurations run in parallel give the same result as one at a time
+BOOST_AUTO_TEST_CASE( parallel_configs ) {
+  std::string trace;
+  for ( std::uint32_t i = 0; i < 2000; i++ ) {
+    std::uint32_t address = ( i * 2654435761u >> 20 ) % 1024 & ~3u;
+    trace += std::to_string( i % 3 ) + " " + fmt::format( "{:x}", address );
+    trace += i % 500 == 499 ? "\n4 0\n" : "\n";
+  }
+
+  std::vector<TraceCacheConfig> configs = get_configs();
+  std::vector<TraceCacheStats> results =
+      TraceCacheSimulator::simulate( trace, configs, 4 );
+  for ( std::size_t i = 0; i < configs.size(); i++ ) {
+    TraceCacheStats alone =
+        TraceCacheSimulator::simulate( trace, { configs[i] }, 1 )[0];
+    BOOST_REQUIRE_EQUAL( results[i].getAccesses(), 2000 );
+    BOOST_REQUIRE_GT( results[i].getMisses(), 0 );
+    BOOST_REQUIRE_EQUAL( results[i].getMisses(), alone.getMisses() );
+    BOOST_REQUIRE_EQUAL( results[i].writebacks, alone.writebacks );
+  }
+}
+
+// A flush writes back the dirty blocks and empties the cache
+BOOST_AUTO_TEST_CASE( flush ) {
+  TraceCacheConfig config;
+  TraceCacheStats stats =
+      TraceCacheSimulator::simulate( "0 0\n1 0\n4 0\n0 0\n", { config } )[0];
+  BOOST_REQUIRE_EQUAL( stats.accesses[memory::READ], 2 );
+  BOOST_REQUIRE_EQUAL( stats.misses[memory::READ], 2 );
+  BOOST_REQUIRE_EQUAL( stats.accesses[memory::WRITE], 1 );
+  BOOST_REQUIRE_EQUAL( stats.misses[memory::WRITE], 0 );
+  BOOST_REQUIRE_EQUAL( stats.writebacks, 1 );
+
+  BOOST_REQUIRE_THROW(
+      TraceCacheSimulator::simulate( "0 ffffffff\n", { config } ),
+      std::out_of_range );
+}
+
+// A trace recorded by the simulator gives a fetch per instruction
+BOOST_AUTO_TEST_CASE( execution_trace ) {
+  CPU test_cpu( 1024, 512, 8 );
+  {
+    TraceRecorder tracer( get_trace_file() );
+    test_cpu.runProgram( get_program(), { &tracer } );
+  }
+  std::vector<TraceCacheStats> results =
+      TraceCacheSimulator::run( get_trace_file(), get_configs() );
+  for ( auto& stats : results ) {
+    BOOST_REQUIRE_EQUAL( stats.accesses[memory::FETCH], 61 );
+    BOOST_REQUIRE_GT( stats.accesses[memory::READ] +
+                          stats.accesses[memory::WRITE],
+                      0 );
+  }
+
+  // The cache of the CPU gives the same hits and misses
+  TraceCacheConfig cpu_config;
+  cpu_config.cache_size = 512;
+  cpu_config.block_size = 8;
+  results = TraceCacheSimulator::run( get_trace_file(), { cpu_config } );
+  State& state = test_cpu.getSystemState();
+  BOOST_REQUIRE_EQUAL( results[0].getMisses(), state.cache_miss );
+  BOOST_REQUIRE_EQUAL( results[0].getAccesses() - results[0].getMisses() -
+                           results[0].accesses[memory::WRITE] +
+                           results[0].misses[memory::WRITE],
+                       state.cache_hits );
+  std::filesystem::remove( get_trace_file() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,125 @@
+#define BOOST_TEST_MODULE working_set_test
+
+#include <boost/test/unit_test.hpp>
+#include <cpu/simulator.hpp>
+#include <cpu/working_set.hpp>
+#include <cstdint>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <test_helpers.hpp>
+
+using namespace cpu;
+
+namespace {
+WorkingSetConfig make_config( std::int64_t interval_length,
+                              std::int32_t max_sampled_lines = 4096 ) {
+  WorkingSetConfig config;
+  config.interval_length = interval_length;
+  config.max_sampled_lines = max_sampled_lines;
+  return config;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE( working_set_test )
+
+// Without sampling the distances are exact
+BOOST_AUTO_TEST_CASE( exact_distances ) {
+  WorkingSetProfiler profiler( make_config( 100 ) );
+  // Lines A B C A A B, A at 0x00, B at 0x08 and C at 0x14
+  for ( std::uint32_t address : { 0x00, 0x08, 0x14, 0x04, 0x00, 0x0c } ) {
+    profiler.access( address );
+    profiler.retire();
+  }
+  profiler.finish();
+  BOOST_REQUIRE_EQUAL( profiler.getIntervals().size(), 1 );
+  const WorkingSetInterval& interval = profiler.getIntervals()[0];
+  BOOST_REQUIRE_EQUAL( interval.instructions, 6 );
+  BOOST_REQUIRE_EQUAL( interval.references, 6 );
+  BOOST_REQUIRE_EQUAL( interval.unique_lines, 3 );
+  BOOST_REQUIRE_EQUAL( interval.reuse.cold, 3 );
+  BOOST_REQUIRE_EQUAL( interval.reuse.buckets[0], 1 );  // A A
+  BOOST_REQUIRE_EQUAL( interval.reuse.buckets[2], 2 );  // A .. A, B .. B
+
+  // Two lines hold only the A A reuse, three all of them
+  BOOST_REQUIRE_CLOSE( interval.reuse.getMissRatio( 2 ), 5 / 6.0, 1e-9 );
+  BOOST_REQUIRE_CLOSE( interval.reuse.getMissRatio( 4 ), 3 / 6.0, 1e-9 );
+}
+
+// Reuse is tracked across intervals, unique lines are per interval
+BOOST_AUTO_TEST_CASE( intervals ) {
+  WorkingSetProfiler profiler( make_config( 4 ) );
+  for ( auto i = 0; i < 10; i++ ) {
+    profiler.access( ( i % 4 ) * 64 );
+    profiler.retire();
+  }
+  profiler.finish();
+  BOOST_REQUIRE_EQUAL( profiler.getIntervals().size(), 3 );
+  BOOST_REQUIRE_EQUAL( profiler.getIntervals()[1].unique_lines, 4 );
+  BOOST_REQUIRE_EQUAL( profiler.getIntervals()[1].reuse.cold, 0 );
+  BOOST_REQUIRE_EQUAL( profiler.getIntervals()[1].reuse.buckets[2], 4 );
+  BOOST_REQUIRE_EQUAL( profiler.getIntervals()[2].instructions, 2 );
+  BOOST_REQUIRE_EQUAL( profiler.getTotal().getReferences(), 10 );
+}
+
+// A cyclic sweep over more lines than are sampled still gives about the
+// right distance and working set
+BOOST_AUTO_TEST_CASE( bounded_sampling ) {
+  WorkingSetConfig config = make_config( 40000, 256 );
+  config.max_set_size = 256;
+  WorkingSetProfiler profiler( config );
+  for ( auto pass = 0; pass < 4; pass++ ) {
+    for ( std::uint32_t line = 0; line < 10000; line++ ) {
+      profiler.access( line * 8 );
+      profiler.retire();
+    }
+  }
+  profiler.finish();
+  BOOST_REQUIRE_LE( profiler.getNumSampledLines(), 256 );
+  BOOST_REQUIRE_LT( profiler.getSamplingRate(), 0.1 );
+
+  const WorkingSetInterval& interval = profiler.getIntervals()[0];
+  BOOST_REQUIRE_CLOSE( interval.unique_lines, 10000, 20 );
+  // Every reuse has distance 9999, in bucket 14 ( 8192 .. 16383 )
+  const ReuseHistogram& reuse = interval.reuse;
+  double reused = reuse.getReferences() - reuse.cold;
+  BOOST_REQUIRE_GT( reuse.buckets[14], 0.9 * reused );
+  BOOST_REQUIRE_GT( reuse.getMissRatio( 4096 ), 0.95 );
+  BOOST_REQUIRE_LT( reuse.getMissRatio( 1 << 15 ), 0.4 );
+}
+
+BOOST_AUTO_TEST_CASE( run_program ) {
+  CPU test_cpu( 1024, 512, 8 );
+  WorkingSetProfiler profiler( make_config( 20 ) );
+  test_cpu.runProgram( get_program(), { &profiler } );
+
+  std::int64_t instructions = 0;
+  std::int64_t references = 0;
+  for ( auto& interval : profiler.getIntervals() ) {
+    instructions += interval.instructions;
+    references += interval.references;
+  }
+  BOOST_REQUIRE_EQUAL( profiler.getIntervals().size(), 4 );
+  BOOST_REQUIRE_EQUAL( instructions, 61 );
+  BOOST_REQUIRE_EQUAL( references, 2 );  // One sw and one lw
+  BOOST_REQUIRE_EQUAL( profiler.getTotal().buckets[0], 1 );
+
+  std::ostringstream csv;
+  profiler.writeCSV( csv, 8 );
+  BOOST_REQUIRE( csv.str().starts_with(
+      "interval,instructions,references,unique_lines,working_set_bytes,"
+      "miss_ratio_1,miss_ratio_2,miss_ratio_4,miss_ratio_8\n"
+      "0,20,2,1.0,8,0.5000" ) );
+}
+
+BOOST_AUTO_TEST_CASE( invalid_configs ) {
+  WorkingSetConfig config;
+  config.line_size = 12;
+  BOOST_REQUIRE_THROW( WorkingSetProfiler{ config }, std::invalid_argument );
+  config = WorkingSetConfig();
+  config.sampling_rate = 0;
+  BOOST_REQUIRE_THROW( WorkingSetProfiler{ config }, std::invalid_argument );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,80 @@
+#define BOOST_TEST_MODULE isa_table_test
+
+#include <boost/test/unit_test.hpp>
+#include <isa/decode_table.hpp>
+#include <isa/encoding.hpp>
+#include <isa/isa_table.hpp>
+
+using namespace isa;
+
+BOOST_AUTO_TEST_SUITE( isa_table_test_suite )
+
+BOOST_AUTO_TEST_CASE( find_instruction ) {
+  BOOST_REQUIRE( IsaTable::find( "add" ) != nullptr );
+  BOOST_REQUIRE_EQUAL( IsaTable::find( "lw" )->format, Format::I );
+  BOOST_REQUIRE( IsaTable::find( "mul" ) == nullptr );
+  BOOST_REQUIRE_EQUAL( IsaTable::indexOf( "mul" ), -1 );
+}
+
+// Every entry has to decode back to itself with the same operands
+BOOST_AUTO_TEST_CASE( encode_decode_round_trip ) {
+  for ( std::size_t i = 0; i < IsaTable::size(); i++ ) {
+    const InstrDesc& desc = IsaTable::instructions[i];
+    std::int32_t width = Encoding::immediateWidth( desc.immediate_layout );
+    // Largest immediate of the layout, branch and jump offsets are even
+    std::int32_t imm = width == 0 ? 0 : ( 1 << ( width - 1 ) ) - 2;
+
+    Operands operands{ 5, 17, 31 };
+    if ( desc.immediate_layout == ImmU || desc.immediate_layout == ImmJ ) {
+      operands = { 5, imm };
+    } else if ( desc.immediate_layout != NoImm ) {
+      operands.operand3 = imm;
+    }
+
+    std::uint32_t word = Encoding::encode( desc, operands );
+    BOOST_TEST_CONTEXT( desc.name ) {
+      BOOST_REQUIRE_EQUAL( DecodeTable::decode( word ), std::int32_t( i ) );
+
+      Operands decoded = Encoding::getOperands( desc.immediate_layout, word );
+      BOOST_REQUIRE_EQUAL( decoded.operand1, operands.operand1 );
+      BOOST_REQUIRE_EQUAL( decoded.operand2, operands.operand2 );
+      BOOST_REQUIRE_EQUAL( decoded.operand3, operands.operand3 );
+    }
+  }
+}
+
+// Entries that ignore funct3 decode whatever those bits hold
+BOOST_AUTO_TEST_CASE( decode_any_funct3 ) {
+  for ( std::size_t i = 0; i < IsaTable::size(); i++ ) {
+    const InstrDesc& desc = IsaTable::instructions[i];
+    if ( desc.match_funct3 ) {
+      continue;
+    }
+    std::uint32_t word = Encoding::encode( desc, { 5, 0 } );
+    for ( std::uint32_t funct3 = 0; funct3 < 8; funct3++ ) {
+      BOOST_TEST_CONTEXT( desc.name << " funct3 " << funct3 ) {
+        std::uint32_t with_funct3 = ( word & ~0x7000u ) | funct3 << 12;
+        BOOST_REQUIRE_EQUAL( DecodeTable::decode( with_funct3 ),
+                             std::int32_t( i ) );
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( decode_unknown_instruction ) {
+  // add opcode with an unused funct7
+  std::uint32_t word = Encoding::toWord( "11000000001100010000000010110011" );
+  BOOST_REQUIRE_EQUAL( DecodeTable::decode( word ), DecodeTable::invalid );
+  BOOST_REQUIRE_EQUAL( DecodeTable::decode( 0 ), DecodeTable::invalid );
+}
+
+BOOST_AUTO_TEST_CASE( negative_branch_offset ) {
+  // beq r1 r2 -2048, needs both the sign bit and bit 11
+  std::uint32_t word =
+      Encoding::encode( *IsaTable::find( "beq" ), { 1, 2, -2048 } );
+  BOOST_REQUIRE_EQUAL( Encoding::toBinaryString( word ),
+                       "10000000001000001000000011100011" );
+  BOOST_REQUIRE_EQUAL( Encoding::getImmediate( ImmB, word ), 0x1800u );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,83 @@
+#define BOOST_TEST_MODULE address_range_table_test
+
+#include <boost/test/unit_test.hpp>
+#include <cpu/state_data.hpp>
+#include <cstdint>
+#include <limits>
+#include <memory/address_range_table.hpp>
+#include <memory/memory_manager.hpp>
+#include <stdexcept>
+#include <string>
+
+using namespace memory;
+
+BOOST_AUTO_TEST_SUITE( address_range_table_test )
+
+// The halving search agrees with a linear scan, including the padding
+BOOST_AUTO_TEST_CASE( find ) {
+  AddressRangeTable table;
+  BOOST_REQUIRE_EQUAL( table.find( 0 ), AddressRangeTable::none );
+  table.add( "c", 500, 600 );
+  table.add( "a", 0, 16 );
+  table.add( "b", 100, 200 );
+  BOOST_REQUIRE_EQUAL( table.getRanges()[0].name, "a" );
+  BOOST_REQUIRE_EQUAL( table.getRanges()[2].name, "c" );
+
+  for ( std::uint32_t address = 0; address < 700; address++ ) {
+    std::int32_t expected = AddressRangeTable::none;
+    for ( std::size_t i = 0; i < table.size(); i++ ) {
+      if ( table.getRanges()[i].begin <= address &&
+           address < table.getRanges()[i].end ) {
+        expected = i;
+      }
+    }
+    BOOST_REQUIRE_EQUAL( table.find( address ), expected );
+  }
+  BOOST_REQUIRE_EQUAL( table.find( std::numeric_limits<std::uint32_t>::max() ),
+                       AddressRangeTable::none );
+}
+
+BOOST_AUTO_TEST_CASE( invalid_ranges ) {
+  AddressRangeTable table;
+  table.add( "stack", 100, 200 );
+  BOOST_REQUIRE_THROW( table.add( "x", 150, 250 ), std::invalid_argument );
+  BOOST_REQUIRE_THROW( table.add( "x", 50, 101 ), std::invalid_argument );
+  BOOST_REQUIRE_THROW( table.add( "x", 300, 300 ), std::invalid_argument );
+  BOOST_REQUIRE_THROW( table.add( "", 300, 400 ), std::invalid_argument );
+  table.add( "x", 200, 300 );  // Touching is fine
+  BOOST_REQUIRE_EQUAL( table.size(), 2 );
+}
+
+BOOST_AUTO_TEST_CASE( memory_manager_counters ) {
+  cpu::StateData state;
+  MemoryManager memory_manager( 512, 64, 8, CacheWritePolicy::WRITEBACK,
+                                CacheReplacementPolicy::FIFO, &state );
+  memory_manager.addWatchRange( "matrix A", 0, 64 );
+  memory_manager.addWatchRange( "matrix B", 64, 128 );
+  std::string word( 32, '1' );
+
+  memory_manager.read( 0, 4 );
+  memory_manager.read( 0, 4 );
+  memory_manager.write( 0, word );
+  memory_manager.read( 200, 4, true );  // Fetches are not counted
+  for ( std::int32_t address = 64; address < 128; address += 8 ) {
+    memory_manager.read( address, 4 );  // The last one evicts address 0
+  }
+  memory_manager.write( 300, word );
+
+  const RangeCounters& a =
+      memory_manager.getWatchRanges().getRanges()[0].counters;
+  const RangeCounters& b =
+      memory_manager.getWatchRanges().getRanges()[1].counters;
+  BOOST_REQUIRE( a == ( RangeCounters{ 2, 1, 1, 1, 1 } ) );
+  BOOST_REQUIRE( b == ( RangeCounters{ 8, 0, 0, 8, 0 } ) );
+  BOOST_REQUIRE_EQUAL( a.hits + b.hits, state.cache_hits );
+  BOOST_REQUIRE_EQUAL( a.misses + b.misses + 2, state.cache_miss );
+
+  common::StatsRegistry stats;
+  memory_manager.registerStats( stats );
+  BOOST_REQUIRE_EQUAL( stats.getValue( "range.matrix_a.writebacks" ), 1 );
+  BOOST_REQUIRE_EQUAL( stats.getValue( "range.matrix_b.misses" ), 8 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -126,4 +126,34 @@ BOOST_AUTO_TEST_CASE( write_back_test ) {
   BOOST_REQUIRE_EQUAL( test_data, main_memory.read( 100, 4 ) );
 }
 
+// A block covers the aligned block_size bytes around the missing address
+BOOST_AUTO_TEST_CASE( aligned_blocks ) {
+  std::string test_data =
+      std::bitset<32>( std::numeric_limits<std::int32_t>::max() ).to_string();
+  MainMemory main_memory( 512, '0' );
+  main_memory.write( 108, test_data );
+
+  CacheMemory cache_memory( main_memory, 32, 16 );
+  BOOST_REQUIRE( !cache_memory.read( 100 ).first );
+  BOOST_REQUIRE( cache_memory.read( 96 ).first );
+  auto [data_present, result_data] = cache_memory.read( 108 );
+  BOOST_REQUIRE( data_present );
+  BOOST_REQUIRE_EQUAL( result_data, test_data );
+  BOOST_REQUIRE( !cache_memory.read( 112 ).first );
+}
+
+// Hits count as uses for LRU replacement
+BOOST_AUTO_TEST_CASE( lru_hits_refresh ) {
+  MainMemory main_memory( 512, '0' );
+  CacheMemory cache_memory( main_memory, 16, 8,
+                            memory::CacheWritePolicy::WRITEBACK,
+                            memory::CacheReplacementPolicy::LRU );
+  cache_memory.read( 0 );
+  cache_memory.read( 8 );
+  BOOST_REQUIRE( cache_memory.read( 4 ).first );
+  cache_memory.read( 16 );  // Evicts the block at 8
+  BOOST_REQUIRE( cache_memory.read( 0 ).first );
+  BOOST_REQUIRE( !cache_memory.read( 8 ).first );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
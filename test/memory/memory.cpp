@@ -26,4 +26,34 @@ BOOST_AUTO_TEST_CASE( memory_test_read_write_behaviour ) {
   BOOST_REQUIRE_EQUAL( data, main_memory.read( 100, 4 ) );
 }
 
+BOOST_AUTO_TEST_CASE( memory_test_page_crossing ) {
+  std::string data =
+      std::bitset<32>( std::numeric_limits<std::uint32_t>::max() ).to_string();
+
+  MainMemory main_memory( 1024, '0' );
+
+  main_memory.write( MainMemory::page_size - 2, data );
+
+  BOOST_REQUIRE_EQUAL( data, main_memory.read( MainMemory::page_size - 2, 4 ) );
+  BOOST_REQUIRE_THROW( main_memory.read( 1022, 4 ), std::out_of_range );
+}
+
+BOOST_AUTO_TEST_CASE( memory_test_copy_on_write ) {
+  std::string data =
+      std::bitset<32>( std::numeric_limits<std::uint32_t>::max() ).to_string();
+  std::string zeros( 32, '0' );
+
+  MainMemory main_memory( 1024, '0' );
+  MainMemory copy = main_memory;
+  BOOST_REQUIRE( main_memory.isPageShared( 0 ) );
+
+  copy.write( 100, data );
+
+  // Only the written page is unshared
+  BOOST_REQUIRE( !copy.isPageShared( 0 ) );
+  BOOST_REQUIRE( copy.isPageShared( 1 ) );
+  BOOST_REQUIRE_EQUAL( copy.read( 100, 4 ), data );
+  BOOST_REQUIRE_EQUAL( main_memory.read( 100, 4 ), zeros );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
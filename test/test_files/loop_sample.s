@@ -0,0 +1,11 @@
+addi r2 r2 2000
+addi r3 r3 1
+addi r16 r16 512
+lp_start:
+sw r2 0(r16)
+lw r7 0(r16)
+add r6 r6 r7
+addi r16 r16 4
+sub r2 r2 r3
+bne r2 r1 lp_start
+add r6 r6 r6
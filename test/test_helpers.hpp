@@ -0,0 +1,13 @@
+#pragma once
+
+#include <assembler/assembler.hpp>
+#include <string>
+
+inline std::string get_examples_dir() { return std::string( EXAMPLES ); }
+
+// Binary of a program in the examples directory, as CPU::loadProgram takes
+// it
+inline std::string get_program( const std::string& name = "sample9.s" ) {
+  assembler::turbo_asm engine( get_examples_dir() + name );
+  return engine.dumpBinary();
+}